@@ -1,29 +1,18 @@
 #version 450
 
-layout (location = 0) in vec3 fragOffset;
+layout (location = 0) in vec2 fragOffset;
+layout (location = 1) flat in vec4 fragColor;
 layout (location = 0) out vec4 outColor;
 
- struct PointLight
-{
-		vec4 position; // Ignore w
-		vec4 color;    // W is the intensity
-};
-
 layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projectionMatrix;
 	mat4 viewMatrix;
 	mat4 inverseViewMatrix;
 	vec4 ambientLightColor; // W is intensity
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterDepth;      // Near, far, slice scale, slice bias
+	uvec4 clusterGrid;      // Clusters along x, y and z
 } ubo;
 
-layout (push_constant) uniform Push {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
-
 const float M_PI = 3.1415926538;
 
 void main()
@@ -36,5 +25,5 @@ void main()
 	}
 
 	float cosDis = 0.5 * (cos(dis * M_PI) + 1.0); // Setting the ranges from 1 -> 0
-	outColor = vec4(push.color.xyz + cosDis / 2, cosDis);
+	outColor = vec4(fragColor.xyz + cosDis / 2, cosDis);
 }
\ No newline at end of file
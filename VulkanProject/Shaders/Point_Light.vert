@@ -10,34 +10,37 @@ const vec2 OFFSETS[6] = vec2[](
 );
 
 layout (location = 0) out vec2 fragOffset;
-
- struct PointLight
-{
-		vec4 position; // Ignore w
-		vec4 color;    // W is the intensity
-};
+layout (location = 1) flat out vec4 fragColor;
 
 layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projectionMatrix;
 	mat4 viewMatrix;
 	mat4 inverseViewMatrix;
 	vec4 ambientLightColor; // W is intensity
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterDepth;      // Near, far, slice scale, slice bias
+	uvec4 clusterGrid;      // Clusters along x, y and z
 } ubo;
 
-layout (push_constant) uniform Push {
-	vec4 position;
-	vec4 color;
-	float radius;
-} push;
+struct BillboardData
+{
+	vec4 position; // W is the billboard radius
+	vec4 color;    // W is the intensity
+};
+
+// Sorted back to front, one billboard per instance
+layout (std430, set = 1, binding = 0) readonly buffer BillboardBuffer {
+	BillboardData billboards[];
+} billboardBuffer;
 
 void main()
 {
+	BillboardData billboard = billboardBuffer.billboards[gl_InstanceIndex];
+
 	fragOffset = OFFSETS[gl_VertexIndex];
+	fragColor = billboard.color;
 
-	vec4 lightInCameraSpace = ubo.viewMatrix * vec4(push.position.xyz, 1.0);
-	vec4 cameraSpacePos = lightInCameraSpace + push.radius * vec4(fragOffset, 0.0, 0.0);
+	vec4 lightInCameraSpace = ubo.viewMatrix * vec4(billboard.position.xyz, 1.0);
+	vec4 cameraSpacePos = lightInCameraSpace + billboard.position.w * vec4(fragOffset, 0.0, 0.0);
 
 	gl_Position = ubo.projectionMatrix * cameraSpacePos;
 }
\ No newline at end of file
@@ -7,7 +7,7 @@ layout (location = 0) out vec4 outColor;
 
 struct PointLight
 {
-		vec4 position; // Ignore w
+		vec4 position; // W is the influence radius
 		vec4 color;    // W is the intensity
 };
 
@@ -16,14 +16,46 @@ layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 viewMatrix;
 	mat4 inverseViewMatrix;
 	vec4 ambientLightColor; // W is intensity
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterDepth;      // Near, far, slice scale, slice bias
+	uvec4 clusterGrid;      // Clusters along x, y and z
 } ubo;
 
-layout (push_constant) uniform Push {
-	mat4 modelMatrix;
-	mat4 normalMatrix;
-} push;
+layout (std430, set = 0, binding = 1) readonly buffer LightBuffer {
+	PointLight lights[];
+} lightBuffer;
+
+// Offset and count into the light index list for every cluster
+layout (std430, set = 0, binding = 2) readonly buffer ClusterBuffer {
+	uvec2 clusters[];
+} clusterBuffer;
+
+layout (std430, set = 0, binding = 3) readonly buffer LightIndexBuffer {
+	uint lightIndices[];
+} lightIndexBuffer;
+
+// Same cluster VELightClusters binned the lights into: a screen tile and an exponential depth slice
+uint GetClusterIndex(vec3 worldSpacePos)
+{
+	vec4 viewSpacePos = ubo.viewMatrix * vec4(worldSpacePos, 1.0);
+	vec4 clipSpacePos = ubo.projectionMatrix * viewSpacePos;
+	vec2 ndc = clipSpacePos.xy / clipSpacePos.w;
+
+	uvec3 cluster = uvec3(
+		clamp(floor((ndc * 0.5 + 0.5) * vec2(ubo.clusterGrid.xy)), vec2(0.0), vec2(ubo.clusterGrid.xy - 1)),
+		clamp(floor(log(viewSpacePos.z) * ubo.clusterDepth.z + ubo.clusterDepth.w), 0.0, float(ubo.clusterGrid.z - 1)));
+
+	return (cluster.z * ubo.clusterGrid.y + cluster.y) * ubo.clusterGrid.x + cluster.x;
+}
+
+// Inverse square falloff multiplied by a window that smoothly reaches zero at the radius,
+// so the light has no visible edge where it stops being shaded
+float GetAttenuation(float distanceSquared, float radius)
+{
+	float ratio = distanceSquared / (radius * radius);
+	float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+
+	return window * window / max(distanceSquared, 0.0001);
+}
 
 void main()
 {
@@ -34,12 +66,16 @@ void main()
 	vec3 cameraWorldSpacePos = ubo.inverseViewMatrix[3].xyz;
 	vec3 viewDirection = normalize(cameraWorldSpacePos - fragWorldSpacePos);
 
-	for (int i = 0; i < ubo.numLights; i++)
+	// Only the lights whose influence reaches this fragment's cluster
+	uvec2 cluster = clusterBuffer.clusters[GetClusterIndex(fragWorldSpacePos)];
+
+	for (uint i = 0; i < cluster.y; i++)
 	{
-		PointLight light = ubo.pointLights[i];
+		PointLight light = lightBuffer.lights[lightIndexBuffer.lightIndices[cluster.x + i]];
 
-		vec3 directionToLight = light.position.xyz - fragWorldSpacePos;		// Ignore the worldSpacePosition.w component
-		float attenuation = 1.0 / dot(directionToLight, directionToLight);  // Distance squared
+		vec3 directionToLight = light.position.xyz - fragWorldSpacePos;
+		float distanceSquared = dot(directionToLight, directionToLight);
+		float attenuation = GetAttenuation(distanceSquared, light.position.w);
 		directionToLight = normalize(directionToLight);
 
 		float cosAngleIncidence = max(dot(surfaceNormal, directionToLight), 0);
@@ -1,40 +1,54 @@
 #version 450
-layout (location = 0) in vec3 position;
+// VEModel::PackedVertex, the formats unpack the snorm, unorm and half values
+layout (location = 0) in vec3 position; // Relative to the model's bounds, the model matrix undoes that
 layout (location = 1) in vec3 color;
-layout (location = 2) in vec3 normal;
+layout (location = 2) in vec2 normal;   // Octahedral
 layout (location = 3) in vec2 uv;
 
 layout (location = 0) out vec3 fragColor;
 layout (location = 1) out vec3 fragWorldSpacePos;
 layout (location = 2) out vec3 fragNormalWorldSpace;
 
-struct PointLight
-{
-		vec4 position; // Ignore w
-		vec4 color;    // W is the intensity
-};
-
 layout (set = 0, binding = 0) uniform GlobalUbo {
 	mat4 projectionMatrix;
 	mat4 viewMatrix;
 	mat4 inverseViewMatrix;
 	vec4 ambientLightColor; // W is intensity
-	PointLight pointLights[10];
-	int numLights;
+	vec4 clusterDepth;      // Near, far, slice scale, slice bias
+	uvec4 clusterGrid;      // Clusters along x, y and z
 } ubo;
 
-layout (push_constant) uniform Push {
+struct InstanceData
+{
 	mat4 modelMatrix;
 	mat4 normalMatrix;
-} push;
+};
 
+layout (std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+	InstanceData instances[];
+} instanceBuffer;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+	// Unfold the lower half
+	float t = max(-n.z, 0.0);
+	n.x += n.x >= 0.0 ? -t : t;
+	n.y += n.y >= 0.0 ? -t : t;
+
+	return normalize(n);
+}
 
 void main()
 {
-	vec4  worldSpacePosition = push.modelMatrix * vec4(position, 1.0);
+	InstanceData instance = instanceBuffer.instances[gl_InstanceIndex];
+
+	// SimpleRenderSystem folds VEModel's position scale and offset into modelMatrix, which dequantizes the position
+	vec4  worldSpacePosition = instance.modelMatrix * vec4(position, 1.0);
 	gl_Position = ubo.projectionMatrix * ubo.viewMatrix * worldSpacePosition;
 
-	fragNormalWorldSpace = normalize(mat3(push.normalMatrix) * normal);
+	fragNormalWorldSpace = normalize(mat3(instance.normalMatrix) * DecodeOctahedral(normal));
 	fragWorldSpacePos = worldSpacePosition.xyz;
 	fragColor = color;
 }
\ No newline at end of file
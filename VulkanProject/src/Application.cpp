@@ -11,23 +11,76 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <chrono>
+#include <cmath>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <sstream>
 #include <stdexcept>
 
 namespace VulkanEngine {
 
-	Application::Application()
+	// Milliseconds since start, then moves start to now so consecutive calls time consecutive parts of the frame
+	static double Lap(std::chrono::high_resolution_clock::time_point& start)
+	{
+		const auto now = std::chrono::high_resolution_clock::now();
+		const double milliseconds = std::chrono::duration<double, std::milli>(now - start).count();
+
+		start = now;
+
+		return milliseconds;
+	}
+
+	// Circles the synthetic scene once every 20 seconds, above it and looking at its center
+	static glm::vec3 GetBenchmarkCameraPosition(const BenchmarkSettings& settings, float time)
+	{
+		const float gridSize = std::sqrt(static_cast<float>(std::max(settings.ObjectCount, 1u)));
+		const float radius = gridSize * 0.75f + 3.0f;
+		const float angle = time * glm::two_pi<float>() / 20.0f;
+
+		// Negative y is up
+		return { radius * std::cos(angle), -0.25f * radius, radius * std::sin(angle) };
+	}
+
+	Application::Application(bool headless)
+		: Application(headless, std::nullopt)
+	{
+	}
+
+	Application::Application(const BenchmarkSettings& settings)
+		: Application(settings.Headless, settings)
+	{
+	}
+
+	Application::Application(bool headless, std::optional<BenchmarkSettings> settings)
+		: window{ WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE, headless }, benchmarkSettings{ std::move(settings) }
 	{
 		globalPool = VEDescriptorPool::Builder(device)
 			.SetMaxSets(VESwapChain::MAX_FRAMES_IN_FLIGHT)
 			.AddPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VESwapChain::MAX_FRAMES_IN_FLIGHT)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * VESwapChain::MAX_FRAMES_IN_FLIGHT)
 			.Build();
 
 
-		LoadGameObjects();
+		if (benchmarkSettings)
+		{
+			LoadBenchmarkScene();
+		}
+		else
+		{
+			LoadGameObjects();
+		}
+
+		auto memoryStats = device.GetAllocator().GetStats();
+
+		std::cout << "Device memory: " << memoryStats.BytesUsed / 1024 << " KiB used of "
+			<< memoryStats.BytesReserved / 1024 << " KiB reserved in "
+			<< memoryStats.BlockCount << " blocks and " << memoryStats.DedicatedCount << " dedicated allocations ("
+			<< memoryStats.AllocationCount << " buffers, " << memoryStats.Fragmentation * 100.0f << "% fragmented)" << std::endl;
 	}
 
 	Application::~Application()
@@ -35,8 +88,18 @@ namespace VulkanEngine {
 
 	}
 
-	void Application::Run()
+	void Application::Run(uint32_t frameCount)
 	{
+		if (benchmarkSettings)
+		{
+			frameCount = benchmarkSettings->WarmupFrames + benchmarkSettings->FrameCount;
+		}
+
+		if (window.IsHeadless() && frameCount == 0)
+		{
+			throw std::runtime_error("A headless application needs a frame count, it has no window to close.");
+		}
+
 		std::vector<std::unique_ptr<VEBuffer>> uboBuffers(VESwapChain::MAX_FRAMES_IN_FLIGHT);
 
 		for (int i = 0; i < uboBuffers.size(); i++)
@@ -53,47 +116,93 @@ namespace VulkanEngine {
 
 		auto globalSetLayout = VEDescriptorSetLayout::Builder(device)
 			.AddBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.AddBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)	// Lights
+			.AddBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)	// Light clusters
+			.AddBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)	// Cluster light indices
 			.Build();
 
+		SimpleRenderSystem simpleRenderSystem(device, renderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout(), &geometryPool);
+
+		if (benchmarkSettings)
+		{
+			simpleRenderSystem.SetMeshletCulling(benchmarkSettings->MeshletCulling);
+		}
+		
+		PointLightSystem pointLightSystem(device, renderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout());
+
+		// The light system owns the light and cluster buffers the global set points at
 		std::vector<VkDescriptorSet> globalDescriptorSets(VESwapChain::MAX_FRAMES_IN_FLIGHT);
 
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
 		{
 			auto bufferInfo = uboBuffers[i]->DescriptorInfo();
+			auto lightInfo = pointLightSystem.GetLightBufferInfo(i);
+			auto clusterInfo = pointLightSystem.GetClusterBufferInfo(i);
+			auto lightIndexInfo = pointLightSystem.GetLightIndexBufferInfo(i);
 
 			VEDescriptorWriter(*globalSetLayout, *globalPool)
 				.WriteBuffer(0, &bufferInfo)
+				.WriteBuffer(1, &lightInfo)
+				.WriteBuffer(2, &clusterInfo)
+				.WriteBuffer(3, &lightIndexInfo)
 				.Build(globalDescriptorSets[i]);
 		}
 
-		SimpleRenderSystem simpleRenderSystem(device, renderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout());
-		
-		PointLightSystem pointLightSystem(device, renderer.GetSwapChainRenderPass(), globalSetLayout->GetDescriptorSetLayout());
-
 		VECamera camera = {};
 
-		auto viewerObject = VEGameObject::CreateGameObject();
-		viewerObject.m_Transform.Translation.z = -2.5f;
+		TransformComponent viewerTransform = {};
+		viewerTransform.SetTranslation({ 0.0f, 0.0f, -2.5f });
 		InputController cameraController = {};
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		const auto startTime = currentTime;
+		uint32_t renderedFrames = 0;
 
-		while (!window.Close())
+		std::vector<BenchmarkFrame> benchmarkFrames;
+
+		if (benchmarkSettings)
 		{
-			glfwPollEvents();
+			benchmarkFrames.reserve(benchmarkSettings->FrameCount);
+		}
 
+		while (!window.Close() && (frameCount == 0 || renderedFrames < frameCount))
+		{
 			auto newTime = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
 			currentTime = newTime;
 
-			cameraController.MoveInPlaneXZ(window.GetWindow(), frameTime, viewerObject);
-			camera.SetViewYXZ(viewerObject.m_Transform.Translation, viewerObject.m_Transform.Rotation);
+			if (!window.IsHeadless())
+			{
+				glfwPollEvents();
+			}
+
+			if (benchmarkSettings)
+			{
+				// A fixed timestep and a scripted orbit, so every run renders the same frames
+				frameTime = benchmarkSettings->TimeStep;
+				camera.SetViewTarget(GetBenchmarkCameraPosition(*benchmarkSettings, renderedFrames * frameTime), glm::vec3(0.0f));
+			}
+			else
+			{
+				// There is no input without a window, the camera stays where it starts
+				if (!window.IsHeadless())
+				{
+					cameraController.MoveInPlaneXZ(window.GetWindow(), frameTime, viewerTransform);
+				}
+
+				camera.SetViewYXZ(viewerTransform.GetTranslation(), viewerTransform.GetRotation());
+			}
 
 			float aspect = renderer.GetAspectRatio();
 			camera.SetPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 1000.0f);
-			
+
+			BenchmarkFrame benchmarkFrame = {};
+			auto lapStart = std::chrono::high_resolution_clock::now();
+
 			if (auto commandBuffer = renderer.BeginFrame())
 			{
+				benchmarkFrame.WaitTime = Lap(lapStart);
+
 				uint32_t frameIndex = renderer.GetFrameIndex();
 				FrameInfo frameInfo = {
 					frameIndex,
@@ -101,7 +210,7 @@ namespace VulkanEngine {
 					commandBuffer,
 					camera,
 					globalDescriptorSets[frameIndex],
-					gameObjects
+					scene
 				};
 
 				// Update
@@ -109,7 +218,11 @@ namespace VulkanEngine {
 				ubo.ProjectionMatrix = camera.GetProjectionMatrix();
 				ubo.ViewMatrix =  camera.GetViewMatrix();
 				ubo.InverseViewMatrix = camera.GetInverseViewMatrix();
+				pointLightSystem.Animate(frameInfo);
+				scene.UpdateTransforms();
+				benchmarkFrame.TransformUpdateTime = Lap(lapStart);
 				pointLightSystem.Update(frameInfo, ubo);
+				benchmarkFrame.LightUpdateTime = Lap(lapStart);
 				uboBuffers[frameIndex]->WriteToBuffer(&ubo);
 				uboBuffers[frameIndex]->Flush();
 
@@ -117,46 +230,88 @@ namespace VulkanEngine {
 				renderer.BeginSwapChainRenderPass(commandBuffer);
 
 				// The order in which objects get rendered matters
+				lapStart = std::chrono::high_resolution_clock::now();
 				simpleRenderSystem.RenderGameObjects(frameInfo);
+				benchmarkFrame.SceneRenderTime = Lap(lapStart);
 				pointLightSystem.Render(frameInfo);
+				benchmarkFrame.LightRenderTime = Lap(lapStart);
 
 				renderer.EndSwapChainRenderPass(commandBuffer);
 				renderer.EndFrame();
+				benchmarkFrame.SubmitTime = Lap(lapStart);
+
+				if (benchmarkSettings && renderedFrames >= benchmarkSettings->WarmupFrames)
+				{
+					benchmarkFrame.FrameTime = std::chrono::duration<double, std::milli>(lapStart - currentTime).count();
+
+					benchmarkFrame.VisibleObjects = simpleRenderSystem.GetVisibleCount();
+					benchmarkFrame.CulledObjects = simpleRenderSystem.GetCulledCount();
+					benchmarkFrame.DrawCalls = simpleRenderSystem.GetDrawCallCount();
+					benchmarkFrame.IndirectCommands = simpleRenderSystem.GetIndirectCommandCount();
+					benchmarkFrame.Instances = simpleRenderSystem.GetInstanceCount();
+					benchmarkFrame.Triangles = simpleRenderSystem.GetTriangleCount();
+					benchmarkFrame.Meshlets = simpleRenderSystem.GetMeshletCount();
+					benchmarkFrame.CulledMeshlets = simpleRenderSystem.GetCulledMeshletCount();
+					benchmarkFrame.UploadedLights = pointLightSystem.GetUploadedLightCount();
+					benchmarkFrame.Billboards = pointLightSystem.GetBillboardCount();
+
+					benchmarkFrames.push_back(benchmarkFrame);
+				}
+
+				renderedFrames++;
 			}
 		}
 
 		// Block the CPU until all GPU operations are completed
 		vkDeviceWaitIdle(device.Device());
+
+		if (benchmarkSettings)
+		{
+			ReportBenchmark(benchmarkFrames);
+		}
+		else if (window.IsHeadless())
+		{
+			const double totalTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+			std::cout << "Headless: " << renderedFrames << " frames in " << totalTime << " ms ("
+				<< totalTime / renderedFrames << " ms per frame)" << std::endl;
+		}
 	}
 
-	void Application::LoadGameObjects()
+	std::shared_ptr<VEModel> Application::LoadModel(const std::string& filepath)
 	{
-		std::shared_ptr<VEModel> model			= VEModel::CreateModelFromFile(device, "Models/flat_vase.obj");
+		std::shared_ptr<VEModel> model = VEModel::CreateModelFromFile(device, filepath, &uploadManager, &geometryPool);
 
-		auto flatVase		= VEGameObject::CreateGameObject();
-		flatVase.m_Model						= model;
-		flatVase.m_Transform.Translation		= { -0.5f, 0.5f, 0.0f };
-		flatVase.m_Transform.Scale				= { 3.0f, 1.5f, 3.0f };
+		const VEModel::MemoryUsage& usage = model->GetMemoryUsage();
 
-		gameObjects.emplace(flatVase.GetId(), std::move(flatVase));
+		std::cout << filepath << ": " << usage.GetBytes() / 1024 << " KiB of geometry, "
+			<< usage.GetSavedBytes() / 1024 << " KiB saved by packing" << std::endl;
 
-		model									= VEModel::CreateModelFromFile(device, "Models/smooth_vase.obj");
+		return model;
+	}
+
+	void Application::LoadGameObjects()
+	{
+		std::shared_ptr<VEModel> model			= LoadModel("Models/flat_vase.obj");
 
-		auto smoothVase		= VEGameObject::CreateGameObject();
-		smoothVase.m_Model						= model;
-		smoothVase.m_Transform.Translation		= { 0.5f, 0.5f, 0.0f };
-		smoothVase.m_Transform.Scale			= { 3.0f, 1.5f, 3.0f };
+		auto flatVase		= scene.CreateEntity();
+		scene.SetModel(flatVase, model);
+		scene.GetTransform(flatVase).SetTranslation({ -0.5f, 0.5f, 0.0f });
+		scene.GetTransform(flatVase).SetScale({ 3.0f, 1.5f, 3.0f });
 
-		gameObjects.emplace(smoothVase.GetId(), std::move(smoothVase));
+		model									= LoadModel("Models/smooth_vase.obj");
 
-		model = VEModel::CreateModelFromFile(device, "Models/quad.obj");
+		auto smoothVase		= scene.CreateEntity();
+		scene.SetModel(smoothVase, model);
+		scene.GetTransform(smoothVase).SetTranslation({ 0.5f, 0.5f, 0.0f });
+		scene.GetTransform(smoothVase).SetScale({ 3.0f, 1.5f, 3.0f });
 
-		auto floor			= VEGameObject::CreateGameObject();
-		floor.m_Model							= model;
-		floor.m_Transform.Translation			= { 0.0f, 0.5f, 0.0f };
-		floor.m_Transform.Scale					= { 3.0f, 1.0f, 3.0f };
+		model = LoadModel("Models/quad.obj");
 
-		gameObjects.emplace(floor.GetId(), std::move(floor));
+		auto floor			= scene.CreateEntity();
+		scene.SetModel(floor, model);
+		scene.GetTransform(floor).SetTranslation({ 0.0f, 0.5f, 0.0f });
+		scene.GetTransform(floor).SetScale({ 3.0f, 1.0f, 3.0f });
 
 		std::vector<glm::vec3> lightColors{
 			{ 1.0f, 0.1f, 0.1f },
@@ -169,17 +324,91 @@ namespace VulkanEngine {
 
 		for (int i = 0; i < lightColors.size(); i++)
 		{
-			auto pointLight = VEGameObject::MakePointLight(0.2f);
-			pointLight.m_Color = lightColors[i];
+			auto pointLight = scene.CreatePointLight(0.2f, 0.1f, lightColors[i]);
 
 			// Create a circle and spread the lights evenly around the circle
 			auto rotateLight = glm::rotate(glm::mat4(1.0f),
 				i * glm::two_pi<float>() / lightColors.size(),
 				{ 0.0f, -1.0f, 0.0f });
 
-			pointLight.m_Transform.Translation = glm::vec3(rotateLight * glm::vec4(-1.0f, -1.0f, -1.0f, -1.0f));
-
-			gameObjects.emplace(pointLight.GetId(), std::move(pointLight));
+			scene.GetTransform(pointLight).SetTranslation(glm::vec3(rotateLight * glm::vec4(-1.0f, -1.0f, -1.0f, -1.0f)));
 		}
+
+		// Submit all of the model uploads in one batch, they become resident without stalling the CPU
+		uploadManager.Flush();
 	}	
+
+	void Application::LoadBenchmarkScene()
+	{
+		const BenchmarkSettings& settings = *benchmarkSettings;
+
+		std::shared_ptr<VEModel> model = LoadModel(settings.MeshPath);
+
+		scene.Reserve(settings.ObjectCount + settings.LightCount, settings.LightCount);
+
+		// Fixed seed, so every run builds the same scene
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		// Objects on a square grid with one unit between them, centered on the origin
+		const uint32_t gridSize = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(settings.ObjectCount))));
+		const float gridOffset = (gridSize - 1) * 0.5f;
+
+		for (uint32_t i = 0; i < settings.ObjectCount; i++)
+		{
+			auto object = scene.CreateEntity();
+			scene.SetModel(object, model);
+
+			auto& transform = scene.GetTransform(object);
+			transform.SetTranslation({ (i % gridSize) - gridOffset, 0.5f, (i / gridSize) - gridOffset });
+			transform.SetRotation({ 0.0f, unit(random) * glm::two_pi<float>(), 0.0f });
+			transform.SetScale(glm::vec3(1.0f));
+		}
+
+		// Lights scattered over the grid just above the objects
+		for (uint32_t i = 0; i < settings.LightCount; i++)
+		{
+			const glm::vec3 color(0.2f + 0.8f * unit(random), 0.2f + 0.8f * unit(random), 0.2f + 0.8f * unit(random));
+
+			auto pointLight = scene.CreatePointLight(0.5f, 0.1f, color, 3.0f);
+
+			scene.GetTransform(pointLight).SetTranslation({
+				(unit(random) - 0.5f) * gridSize,
+				-0.5f - unit(random),
+				(unit(random) - 0.5f) * gridSize });
+		}
+
+		uploadManager.Flush();
+	}
+
+	void Application::ReportBenchmark(const std::vector<BenchmarkFrame>& frames)
+	{
+		const BenchmarkSettings& settings = *benchmarkSettings;
+
+		std::ostringstream report;
+		WriteBenchmarkReport(report, settings, device.m_Properties.deviceName, frames);
+
+		if (!IsValidJson(report.str()))
+		{
+			throw std::runtime_error("Benchmark report is not valid JSON:\n" + report.str());
+		}
+
+		// main prints it once everything else the engine writes to stdout has been sent to stderr
+		if (settings.OutputPath.empty())
+		{
+			benchmarkReport = report.str();
+			return;
+		}
+
+		std::ofstream file(settings.OutputPath, std::ios::trunc);
+
+		if (!file.is_open())
+		{
+			throw std::runtime_error("Failed to open benchmark report: " + settings.OutputPath);
+		}
+
+		file << report.str();
+
+		std::cout << "Benchmark report written to " << settings.OutputPath << std::endl;
+	}
 }
\ No newline at end of file
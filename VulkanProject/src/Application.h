@@ -1,11 +1,16 @@
 #pragma once
 #include "VE_Descriptors.h"
 #include "VE_Device.h"
-#include "VE_GameObject.h"
+#include "VE_GeometryPool.h"
 #include "VE_Window.h"
 #include "VE_Renderer.h"
+#include "VE_Scene.h"
+#include "VE_UploadManager.h"
+#include "Tools/FrameBenchmark.h"
 
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 const uint32_t WINDOW_WIDTH = 1280;
@@ -17,17 +22,33 @@ namespace VulkanEngine {
 	class Application
 	{
 	public:
-		Application();
+		// A headless application has no window and renders into offscreen images, for machines without a display
+		explicit Application(bool headless = false);
+
+		// Loads a synthetic scene instead of the demo scene, Run then renders the benchmark's frames and reports them
+		explicit Application(const BenchmarkSettings& settings);
 		~Application();
 
 		// Delete the copy constructor and copy operator
 		Application(const Application&) = delete;
 		Application& operator=(const Application&) = delete;
 
-		void Run();
+		// Runs until the window is closed, or for frameCount frames when it is not 0. Headless runs need a frame count,
+		// benchmarks ignore it and run for their warmup and recorded frames
+		void Run(uint32_t frameCount = 0);
+
+		// The JSON report of a benchmark run without an output path, empty otherwise
+		const std::string& GetBenchmarkReport() const { return benchmarkReport; }
 
 	private:
+		Application(bool headless, std::optional<BenchmarkSettings> settings);
+
+		// Loads into the geometry pool and prints how much memory the packed format saved
+		std::shared_ptr<VEModel> LoadModel(const std::string& filepath);
+
 		void LoadGameObjects();
+		void LoadBenchmarkScene();
+		void ReportBenchmark(const std::vector<BenchmarkFrame>& frames);
 
 		// Recursive triangle effect
 		void Sierpinski(std::vector<VEModel::Vertex>& vertices,
@@ -37,11 +58,16 @@ namespace VulkanEngine {
 			glm::vec2 left);
 
 	private:
-		VEWindow window{ WINDOW_WIDTH, WINDOW_HEIGHT, WINDOW_TITLE };
+		VEWindow window;
 		VEDevice device{ window };
 		VERenderer renderer{ window, device };
+		VEUploadManager uploadManager{ device };
+		VEGeometryPool geometryPool{ device, sizeof(VEModel::PackedVertex), VK_INDEX_TYPE_UINT16 };
 
 		std::unique_ptr<VEDescriptorPool> globalPool{};
-		VEGameObject::Map gameObjects;
+		VEScene scene;
+
+		std::optional<BenchmarkSettings> benchmarkSettings;
+		std::string benchmarkReport;
 	};
 }
\ No newline at end of file
@@ -4,7 +4,7 @@
 
 namespace VulkanEngine {
 
-    void InputController::MoveInPlaneXZ(GLFWwindow* window, float deltaTime, VEGameObject& gameObject)
+    void InputController::MoveInPlaneXZ(GLFWwindow* window, float deltaTime, TransformComponent& transform)
     {
         glm::vec3 rotate{ 0.0f };
 
@@ -20,15 +20,21 @@ namespace VulkanEngine {
         if (glfwGetKey(window, m_Keys.lookDown) == GLFW_PRESS)
             rotate.x -= 1;
 
+        glm::vec3 rotation = transform.GetRotation();
+
         if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
-            gameObject.m_Transform.Rotation += m_CameraSpeed * deltaTime * glm::normalize(rotate);
+            rotation += m_CameraSpeed * deltaTime * glm::normalize(rotate);
 
         // Limit pitch values between about +/- 85ish degrees
-        gameObject.m_Transform.Rotation.x = glm::clamp(gameObject.m_Transform.Rotation.x, -1.5f, 1.5f);
+        rotation.x = glm::clamp(rotation.x, -1.5f, 1.5f);
+
+        rotation.y = glm::mod(rotation.y, glm::two_pi<float>());
 
-        gameObject.m_Transform.Rotation.y = glm::mod(gameObject.m_Transform.Rotation.y, glm::two_pi<float>());
+        // Only touch the transform when it moved, so a still camera stays clean
+        if (rotation != transform.GetRotation())
+            transform.SetRotation(rotation);
 
-        float yaw = gameObject.m_Transform.Rotation.y;
+        float yaw = rotation.y;
         const glm::vec3 forward{ sin(yaw), 0.0f, cos(yaw) };
         const glm::vec3 right{ forward.z, 0.0f, -forward.x };
         const glm::vec3 up{ 0.0f, -1.0f, 0.0f };
@@ -54,7 +60,7 @@ namespace VulkanEngine {
             movementDirection -= up;
 
         if (glm::dot(movementDirection, movementDirection) > std::numeric_limits<float>::epsilon())
-            gameObject.m_Transform.Translation += m_MovementSpeed * deltaTime * glm::normalize(movementDirection);
+            transform.SetTranslation(transform.GetTranslation() + m_MovementSpeed * deltaTime * glm::normalize(movementDirection));
 
     }
 
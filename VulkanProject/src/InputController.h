@@ -20,7 +20,7 @@ namespace VulkanEngine {
             int lookDown        = GLFW_KEY_DOWN;
         };
 
-        void MoveInPlaneXZ(GLFWwindow* window, float deltaTime, VEGameObject& gameObject);
+        void MoveInPlaneXZ(GLFWwindow* window, float deltaTime, TransformComponent& transform);
 
         KeyMappings m_Keys = {};
 
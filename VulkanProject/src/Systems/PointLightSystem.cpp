@@ -1,4 +1,5 @@
 #include "PointLightSystem.h"
+#include "VE_SwapChain.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -7,21 +8,18 @@
 
 #include <array>
 #include <cassert>
-#include <map>
+#include <cstring>
 #include <stdexcept>
 
 namespace VulkanEngine {
 
-	struct PointLightPushConstants
-	{
-		glm::vec4 Position{};
-		glm::vec4 Color{};
-		float Radius;
-	};
+	static constexpr uint32_t INITIAL_BILLBOARD_CAPACITY = 64;
 
 	PointLightSystem::PointLightSystem(VEDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
 		: m_Device{device}
 	{
+		CreateLightBuffers();
+		CreateBillboardBuffers();
 		CreatePipelineLayout(globalSetLayout);
 		CreatePipeline(renderPass);
 	}
@@ -31,24 +29,107 @@ namespace VulkanEngine {
 		vkDestroyPipelineLayout(m_Device.Device(), m_PipelineLayout, nullptr);
 	}
 
-	void PointLightSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	void PointLightSystem::CreateLightBuffers()
+	{
+		auto createBuffers = [this](std::vector<std::unique_ptr<VEBuffer>>& buffers, VkDeviceSize instanceSize, uint32_t instanceCount)
+		{
+			buffers.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+			for (auto& buffer : buffers)
+			{
+				buffer = std::make_unique<VEBuffer>(
+					m_Device,
+					instanceSize,
+					instanceCount,
+					VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+				buffer->Map();
+			}
+		};
+
+		createBuffers(m_LightBuffers, sizeof(PointLight), MAX_LIGHTS);
+		createBuffers(m_ClusterBuffers, sizeof(VELightClusters::Cluster), VELightClusters::CLUSTER_COUNT);
+		createBuffers(m_LightIndexBuffers, sizeof(uint32_t), MAX_LIGHT_INDICES);
+	}
+
+	void PointLightSystem::CreateBillboardBuffers()
 	{
-		VkPushConstantRange pushConstantRange = {};
+		m_BillboardSetLayout = VEDescriptorSetLayout::Builder(m_Device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.Build();
 
-		pushConstantRange.stageFlags				= VK_SHADER_STAGE_VERTEX_BIT |
-													  VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset					= 0;
-		pushConstantRange.size						= sizeof(PointLightPushConstants);
+		m_BillboardPool = VEDescriptorPool::Builder(m_Device)
+			.SetMaxSets(VESwapChain::MAX_FRAMES_IN_FLIGHT)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VESwapChain::MAX_FRAMES_IN_FLIGHT)
+			.Build();
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		m_BillboardBuffers.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+		m_BillboardDescriptorSets.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		for (uint32_t i = 0; i < VESwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_BillboardBuffers[i] = std::make_unique<VEBuffer>(
+				m_Device,
+				sizeof(BillboardData),
+				INITIAL_BILLBOARD_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			m_BillboardBuffers[i]->Map();
+
+			auto bufferInfo = m_BillboardBuffers[i]->DescriptorInfo();
+
+			VEDescriptorWriter(*m_BillboardSetLayout, *m_BillboardPool)
+				.WriteBuffer(0, &bufferInfo)
+				.Build(m_BillboardDescriptorSets[i]);
+		}
+	}
+
+	void PointLightSystem::ReserveBillboards(uint32_t frameIndex, uint32_t billboardCount)
+	{
+		auto& buffer = m_BillboardBuffers[frameIndex];
+
+		if (billboardCount <= buffer->GetInstanceCount())
+		{
+			return;
+		}
+
+		// The fence of this frame has already been waited on, so the old buffer is no longer in use by the GPU
+		uint32_t capacity = buffer->GetInstanceCount();
+
+		while (capacity < billboardCount)
+		{
+			capacity *= 2;
+		}
+
+		buffer = std::make_unique<VEBuffer>(
+			m_Device,
+			sizeof(BillboardData),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		buffer->Map();
+
+		auto bufferInfo = buffer->DescriptorInfo();
+
+		VEDescriptorWriter(*m_BillboardSetLayout, *m_BillboardPool)
+			.WriteBuffer(0, &bufferInfo)
+			.Overwrite(m_BillboardDescriptorSets[frameIndex]);
+	}
+
+	void PointLightSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	{
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, m_BillboardSetLayout->GetDescriptorSetLayout() };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 
 		pipelineLayoutInfo.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount			= static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts				= descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount	= 1;
-		pipelineLayoutInfo.pPushConstantRanges		= &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount	= 0;
+		pipelineLayoutInfo.pPushConstantRanges		= nullptr;
 
 		if (vkCreatePipelineLayout(m_Device.Device(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 		{
@@ -77,90 +158,145 @@ namespace VulkanEngine {
 			pipelineConfig);
 	}
 
-	void PointLightSystem::Update(FrameInfo& frameInfo, GlobalUbo& ubo)
+	void PointLightSystem::Animate(FrameInfo& frameInfo)
 	{
 		// Create a circle and spread the lights evenly around the circle
 		auto rotateLight = glm::rotate(glm::mat4(1.0f),
 			frameInfo.FrameTime,
 			{ 0.0f, -1.0f, 0.0f });
 
-		int lightIndex = 0;
+		frameInfo.Scene.ForEachPointLight([&](VEEntity, PointLightComponent&, TransformComponent& transform)
+		{
+			transform.SetTranslation(glm::vec3(rotateLight * glm::vec4(transform.GetTranslation(), 1.0f)));
+		});
+	}
 
-		for (auto& kv : frameInfo.GameObjects)
+	void PointLightSystem::Update(FrameInfo& frameInfo, GlobalUbo& ubo)
+	{
+		m_CandidateLights.clear();
+		m_CandidateSpheres.Clear();
+
+		frameInfo.Scene.ForEachPointLight([&](VEEntity, PointLightComponent& light, TransformComponent& transform)
 		{
-			auto& obj = kv.second;
+			assert(!transform.IsDirty() && "VEScene::UpdateTransforms must run before updating the lights.");
+
+			// Lights can be parented, so culling and shading use the world position
+			const glm::vec3 position = glm::vec3(transform.GetWorldMatrix()[3]);
 
-			if (obj.m_PointLight == nullptr)
+			PointLight candidate = {};
+			candidate.Position	= glm::vec4(position, light.Radius);
+			candidate.Color		= glm::vec4(light.Color, light.LightIntensity);
+
+			m_CandidateLights.push_back(candidate);
+			m_CandidateSpheres.Add(position.x, position.y, position.z, light.Radius);
+		});
+
+		// A light whose sphere of influence misses the frustum cannot reach any visible fragment
+		const VEFrustum frustum(frameInfo.Camera.GetProjectionMatrix() * frameInfo.Camera.GetViewMatrix());
+
+		float planes[VEFrustum::PLANE_COUNT * 4];
+		frustum.GetPlanes(planes);
+
+		VECulling::CullSpheres(planes, m_CandidateSpheres, m_VisibleIndices);
+
+		// Copy the visible lights to the storage buffer
+		PointLight* lights = static_cast<PointLight*>(m_LightBuffers[frameInfo.FrameIndex]->GetMappedMemory());
+
+		m_LightSpheres.clear();
+		m_ConsideredLightCount = static_cast<uint32_t>(m_CandidateLights.size());
+		m_LightCount = 0;
+
+		for (uint32_t index : m_VisibleIndices)
+		{
+			if (m_LightCount == MAX_LIGHTS)
 			{
-				continue;
+				break;
 			}
 
-			assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum number of lights permitted.");
+			lights[m_LightCount] = m_CandidateLights[index];
+			m_LightSpheres.push_back(m_CandidateLights[index].Position);
+			m_LightCount++;
+		}
+
+		m_LightClusters.Build(frameInfo.Camera.GetViewMatrix(), frameInfo.Camera.GetProjectionMatrix(),
+			m_LightSpheres.data(), m_LightCount);
 
-			// Update the light's position
-			obj.m_Transform.Translation = glm::vec3(rotateLight * glm::vec4(obj.m_Transform.Translation, 1.0f));
+		const auto& clusters = m_LightClusters.GetClusters();
+		const auto& lightIndices = m_LightClusters.GetLightIndices();
 
-			// Copy the light to the ubo
-			ubo.PointLights[lightIndex].Position	= glm::vec4(obj.m_Transform.Translation, 1.0f);
-			ubo.PointLights[lightIndex].Color		= glm::vec4(obj.m_Color, obj.m_PointLight->LightIntensity);
+		std::memcpy(m_ClusterBuffers[frameInfo.FrameIndex]->GetMappedMemory(), clusters.data(), clusters.size() * sizeof(clusters[0]));
 
-			lightIndex += 1;
+		if (!lightIndices.empty())
+		{
+			std::memcpy(m_LightIndexBuffers[frameInfo.FrameIndex]->GetMappedMemory(), lightIndices.data(), lightIndices.size() * sizeof(uint32_t));
 		}
 
-		ubo.NumLights = lightIndex;
+		m_LightBuffers[frameInfo.FrameIndex]->Flush();
+		m_ClusterBuffers[frameInfo.FrameIndex]->Flush();
+		m_LightIndexBuffers[frameInfo.FrameIndex]->Flush();
+
+		ubo.ClusterDepth = m_LightClusters.GetDepthParameters();
+		ubo.ClusterGrid = glm::uvec4(VELightClusters::GRID_X, VELightClusters::GRID_Y, VELightClusters::GRID_Z, 0);
 	}
 
 	void PointLightSystem::Render(FrameInfo& frameInfo)
 	{
-		// Sorting the lights
-		std::map<float, VEGameObject::id_t> sortedLights;
+		m_Billboards.clear();
+		m_DepthSort.Clear();
 
-		for (auto& kv : frameInfo.GameObjects)
-		{
-			auto& obj = kv.second;
-
-			if (obj.m_PointLight == nullptr)
-			{
-				continue;
-			}
+		const glm::vec3 cameraPosition = frameInfo.Camera.GetPosition();
 
+		frameInfo.Scene.ForEachPointLight([&](VEEntity, PointLightComponent& light, TransformComponent& transform)
+		{
 			// Calculate the distance of the light
-			auto offset = frameInfo.Camera.GetPosition() - obj.m_Transform.Translation;
+			const glm::vec3 position = glm::vec3(transform.GetWorldMatrix()[3]);
+			auto offset = cameraPosition - position;
 			float distanceSquared = glm::dot(offset, offset);
-			sortedLights[distanceSquared] = obj.GetId();
+			m_DepthSort.Add(distanceSquared, static_cast<uint32_t>(m_Billboards.size()));
+
+			BillboardData billboard = {};
+			billboard.Position	= glm::vec4(position, transform.GetScale().x);
+			billboard.Color		= glm::vec4(light.Color, light.LightIntensity);
+
+			m_Billboards.push_back(billboard);
+		});
+
+		m_BillboardCount = static_cast<uint32_t>(m_Billboards.size());
+
+		if (m_BillboardCount == 0)
+		{
+			return;
+		}
+
+		// Write the billboards back to front so the blended instances composite correctly in draw order
+		const uint32_t* sortedBillboards = m_DepthSort.Sort(VEDepthSort::Order::BackToFront);
+
+		ReserveBillboards(frameInfo.FrameIndex, m_BillboardCount);
+
+		auto& billboardBuffer = m_BillboardBuffers[frameInfo.FrameIndex];
+		BillboardData* billboards = static_cast<BillboardData*>(billboardBuffer->GetMappedMemory());
+
+		for (uint32_t i = 0; i < m_BillboardCount; i++)
+		{
+			billboards[i] = m_Billboards[sortedBillboards[i]];
 		}
 
+		billboardBuffer->Flush();
+
 		m_Pipeline->Bind(frameInfo.CommandBuffer);
 
+		VkDescriptorSet descriptorSets[] = { frameInfo.GlobalDescriptorSet, m_BillboardDescriptorSets[frameInfo.FrameIndex] };
+
 		vkCmdBindDescriptorSets(frameInfo.CommandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_PipelineLayout,
 			0,
-			1,
-			&frameInfo.GlobalDescriptorSet,
+			2,
+			descriptorSets,
 			0,
 			nullptr);
 
-		// Iterate through the sorted lights map in reverse order
-		for (auto it = sortedLights.rbegin(); it != sortedLights.rend(); ++it)
-		{
-			// Use the game obj to find the light object
-			auto& obj = frameInfo.GameObjects.at(it->second);
-
-			PointLightPushConstants push = {};
-
-			push.Position = glm::vec4(obj.m_Transform.Translation, 1.0f);
-			push.Color = glm::vec4(obj.m_Color, obj.m_PointLight->LightIntensity);
-			push.Radius = obj.m_Transform.Scale.x;
-
-			vkCmdPushConstants(frameInfo.CommandBuffer,
-				m_PipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PointLightPushConstants),
-				&push);
-
-			vkCmdDraw(frameInfo.CommandBuffer, 6, 1, 0, 0);
-		}
+		// Every billboard in one draw, instances are rasterized in order so the sort still holds
+		vkCmdDraw(frameInfo.CommandBuffer, 6, m_BillboardCount, 0, 0);
 	}
 }
\ No newline at end of file
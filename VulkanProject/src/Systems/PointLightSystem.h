@@ -1,9 +1,15 @@
 #pragma once
+#include "VE_Buffer.h"
 #include "VE_Camera.h"
+#include "VE_Culling.h"
+#include "VE_Descriptors.h"
+#include "VE_DepthSort.h"
 #include "VE_Device.h"
 #include "VE_FrameInfo.h"
-#include "VE_GameObject.h"
+#include "VE_Frustum.h"
+#include "VE_LightClusters.h"
 #include "VE_Pipeline.h"
+#include "VE_Scene.h"
 
 #include <memory>
 #include <vector>
@@ -21,16 +27,75 @@ namespace VulkanEngine {
 		PointLightSystem(const PointLightSystem&) = delete;
 		PointLightSystem& operator=(const PointLightSystem&) = delete;
 
+		// Upper bound on cluster light references per frame, 1 MiB of indices
+		static constexpr uint32_t MAX_LIGHT_INDICES = 256 * 1024;
+
+		// Moves the lights around their circle. Runs before VEScene::UpdateTransforms, Update and Render read
+		// the world positions it produces
+		void Animate(FrameInfo& frameInfo);
+
+		// Culls the lights against the view frustum and writes the visible ones and their clusters into this frame's storage buffers
 		void Update(FrameInfo& frameInfo, GlobalUbo& ubo);
 		void Render(FrameInfo& frameInfo);
 
+		// Bindings 1 to 3 of the global descriptor set
+		VkDescriptorBufferInfo GetLightBufferInfo(uint32_t frameIndex) { return m_LightBuffers[frameIndex]->DescriptorInfo(); }
+		VkDescriptorBufferInfo GetClusterBufferInfo(uint32_t frameIndex) { return m_ClusterBuffers[frameIndex]->DescriptorInfo(); }
+		VkDescriptorBufferInfo GetLightIndexBufferInfo(uint32_t frameIndex) { return m_LightIndexBuffers[frameIndex]->DescriptorInfo(); }
+
+		// Lights in the scene and lights that passed culling and were uploaded
+		uint32_t GetConsideredLightCount() const { return m_ConsideredLightCount; }
+		uint32_t GetUploadedLightCount() const { return m_LightCount; }
+		// Billboards drawn by the last Render, all in one instanced draw
+		uint32_t GetBillboardCount() const { return m_BillboardCount; }
+
+		uint32_t GetDroppedLightIndexCount() const { return m_LightClusters.GetDroppedCount(); }
+
 	private:
+		// Matches BillboardData in Point_Light.vert
+		struct BillboardData
+		{
+			glm::vec4 Position{}; // W is the billboard radius
+			glm::vec4 Color{};    // W is the intensity
+		};
+
+		void CreateLightBuffers();
+		void CreateBillboardBuffers();
 		void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void CreatePipeline(VkRenderPass renderPass);
 
+		// Grows the billboard buffer of a frame so it holds at least billboardCount billboards
+		void ReserveBillboards(uint32_t frameIndex, uint32_t billboardCount);
+
 	private:
 		VEDevice& m_Device;
 		std::unique_ptr<VEPipeline> m_Pipeline;
 		VkPipelineLayout m_PipelineLayout;
+
+		// Per frame storage buffers, fixed size so the global descriptor sets never need rewriting
+		std::vector<std::unique_ptr<VEBuffer>> m_LightBuffers;
+		std::vector<std::unique_ptr<VEBuffer>> m_ClusterBuffers;
+		std::vector<std::unique_ptr<VEBuffer>> m_LightIndexBuffers;
+
+		VELightClusters m_LightClusters{ MAX_LIGHT_INDICES };
+		std::vector<glm::vec4> m_LightSpheres;
+		uint32_t m_ConsideredLightCount = 0;
+		uint32_t m_LightCount = 0;
+
+		// Reused every frame to avoid allocating while culling
+		std::vector<PointLight> m_CandidateLights;
+		VESphereList m_CandidateSpheres;
+		std::vector<uint32_t> m_VisibleIndices;
+
+		// Per frame storage buffers with the position, radius and color of every billboard, sorted back to front
+		std::unique_ptr<VEDescriptorSetLayout> m_BillboardSetLayout;
+		std::unique_ptr<VEDescriptorPool> m_BillboardPool;
+		std::vector<std::unique_ptr<VEBuffer>> m_BillboardBuffers;
+		std::vector<VkDescriptorSet> m_BillboardDescriptorSets;
+
+		// Reused every frame to avoid allocating while sorting the billboards
+		std::vector<BillboardData> m_Billboards;
+		VEDepthSort m_DepthSort;
+		uint32_t m_BillboardCount = 0;
 	};
 }
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "SimpleRenderSystem.h"
+#include "VE_SwapChain.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <iostream>
@@ -12,15 +14,59 @@
 
 namespace VulkanEngine {
 
-	struct SimplePushConstantData
+	// Matches InstanceData in Simple_Shader.vert
+	struct InstanceData
 	{
 		glm::mat4 ModelMatrix{ 1.0f };
 		glm::mat4 NormalMatrix{ 1.0f };
 	};
 
-	SimpleRenderSystem::SimpleRenderSystem(VEDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: m_Device{device}
+	static constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 256;
+	static constexpr uint32_t INITIAL_INDIRECT_CAPACITY = 64;
+	static constexpr uint32_t INITIAL_COMPACTED_INDEX_CAPACITY = 64 * 1024;
+
+	SimpleRenderSystem::SimpleRenderSystem(VEDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, VEGeometryPool* geometryPool)
+		: m_Device{device}, m_GeometryPool{ geometryPool }
 	{
+		// Every command points at its own slice of the instance buffer, which needs a non zero firstInstance
+		m_UseIndirect = m_GeometryPool != nullptr && m_Device.GetEnabledFeatures().drawIndirectFirstInstance;
+
+		if (m_UseIndirect)
+		{
+			m_IndirectBuffers.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+			for (auto& buffer : m_IndirectBuffers)
+			{
+				buffer = std::make_unique<VEBuffer>(
+					m_Device,
+					sizeof(VkDrawIndexedIndirectCommand),
+					INITIAL_INDIRECT_CAPACITY,
+					VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+				buffer->Map();
+			}
+		}
+
+		// Meshlet culling draws through the indirect buffers, so the compacted indices are only needed with them
+		if (m_UseIndirect)
+		{
+			m_CompactedIndexBuffers.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+			for (auto& buffer : m_CompactedIndexBuffers)
+			{
+				buffer = std::make_unique<VEBuffer>(
+					m_Device,
+					sizeof(uint32_t),
+					INITIAL_COMPACTED_INDEX_CAPACITY,
+					VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+					VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				);
+				buffer->Map();
+			}
+		}
+
+		CreateInstanceBuffers();
 		CreatePipelineLayout(globalSetLayout);
 		CreatePipeline(renderPass);
 	}
@@ -30,24 +76,50 @@ namespace VulkanEngine {
 		vkDestroyPipelineLayout(m_Device.Device(), m_PipelineLayout, nullptr);
 	}
 
-	void SimpleRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	void SimpleRenderSystem::CreateInstanceBuffers()
 	{
-		VkPushConstantRange pushConstantRange = {};
+		m_InstanceSetLayout = VEDescriptorSetLayout::Builder(m_Device)
+			.AddBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+			.Build();
 
-		pushConstantRange.stageFlags				= VK_SHADER_STAGE_VERTEX_BIT |
-													  VK_SHADER_STAGE_FRAGMENT_BIT;
-		pushConstantRange.offset					= 0;
-		pushConstantRange.size						= sizeof(SimplePushConstantData);
+		m_InstancePool = VEDescriptorPool::Builder(m_Device)
+			.SetMaxSets(VESwapChain::MAX_FRAMES_IN_FLIGHT)
+			.AddPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VESwapChain::MAX_FRAMES_IN_FLIGHT)
+			.Build();
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+		m_InstanceBuffers.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+		m_InstanceDescriptorSets.resize(VESwapChain::MAX_FRAMES_IN_FLIGHT);
+
+		for (uint32_t i = 0; i < VESwapChain::MAX_FRAMES_IN_FLIGHT; i++)
+		{
+			m_InstanceBuffers[i] = std::make_unique<VEBuffer>(
+				m_Device,
+				sizeof(InstanceData),
+				INITIAL_INSTANCE_CAPACITY,
+				VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+			);
+			m_InstanceBuffers[i]->Map();
+
+			auto bufferInfo = m_InstanceBuffers[i]->DescriptorInfo();
+
+			VEDescriptorWriter(*m_InstanceSetLayout, *m_InstancePool)
+				.WriteBuffer(0, &bufferInfo)
+				.Build(m_InstanceDescriptorSets[i]);
+		}
+	}
+
+	void SimpleRenderSystem::CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	{
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, m_InstanceSetLayout->GetDescriptorSetLayout() };
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
 
 		pipelineLayoutInfo.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 		pipelineLayoutInfo.setLayoutCount			= static_cast<uint32_t>(descriptorSetLayouts.size());
 		pipelineLayoutInfo.pSetLayouts				= descriptorSetLayouts.data();
-		pipelineLayoutInfo.pushConstantRangeCount	= 1;
-		pipelineLayoutInfo.pPushConstantRanges		= &pushConstantRange;
+		pipelineLayoutInfo.pushConstantRangeCount	= 0;
+		pipelineLayoutInfo.pPushConstantRanges		= nullptr;
 
 		if (vkCreatePipelineLayout(m_Device.Device(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS)
 		{
@@ -72,42 +144,352 @@ namespace VulkanEngine {
 			pipelineConfig);
 	}
 
+	void SimpleRenderSystem::ReserveInstances(uint32_t frameIndex, uint32_t instanceCount)
+	{
+		auto& buffer = m_InstanceBuffers[frameIndex];
+
+		if (instanceCount <= buffer->GetInstanceCount())
+		{
+			return;
+		}
+
+		// The fence of this frame has already been waited on, so the old buffer is no longer in use by the GPU
+		uint32_t capacity = buffer->GetInstanceCount();
+
+		while (capacity < instanceCount)
+		{
+			capacity *= 2;
+		}
+
+		buffer = std::make_unique<VEBuffer>(
+			m_Device,
+			sizeof(InstanceData),
+			capacity,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		buffer->Map();
+
+		auto bufferInfo = buffer->DescriptorInfo();
+
+		VEDescriptorWriter(*m_InstanceSetLayout, *m_InstancePool)
+			.WriteBuffer(0, &bufferInfo)
+			.Overwrite(m_InstanceDescriptorSets[frameIndex]);
+	}
+
+	void SimpleRenderSystem::ReserveIndirectCommands(uint32_t frameIndex, uint32_t commandCount)
+	{
+		auto& buffer = m_IndirectBuffers[frameIndex];
+
+		if (commandCount <= buffer->GetInstanceCount())
+		{
+			return;
+		}
+
+		uint32_t capacity = buffer->GetInstanceCount();
+
+		while (capacity < commandCount)
+		{
+			capacity *= 2;
+		}
+
+		buffer = std::make_unique<VEBuffer>(
+			m_Device,
+			sizeof(VkDrawIndexedIndirectCommand),
+			capacity,
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		buffer->Map();
+	}
+
+	void SimpleRenderSystem::ReserveCompactedIndices(uint32_t frameIndex, uint32_t indexCount)
+	{
+		auto& buffer = m_CompactedIndexBuffers[frameIndex];
+
+		if (indexCount <= buffer->GetInstanceCount())
+		{
+			return;
+		}
+
+		uint32_t capacity = buffer->GetInstanceCount();
+
+		while (capacity < indexCount)
+		{
+			capacity *= 2;
+		}
+
+		buffer = std::make_unique<VEBuffer>(
+			m_Device,
+			sizeof(uint32_t),
+			capacity,
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+		);
+		buffer->Map();
+	}
+
+	void SimpleRenderSystem::CullMeshlets(const VEFrustum& frustum, const glm::vec3& cameraPosition, uint32_t first, uint32_t last)
+	{
+		VEModel* model = m_DrawList[first].Model;
+
+		for (uint32_t i = first; i < last; i++)
+		{
+			const uint32_t firstIndex = static_cast<uint32_t>(m_CompactedIndices.size());
+			const uint32_t keptCount = model->CullMeshlets(frustum, m_DrawList[i].Transform->GetWorldMatrix(), cameraPosition, m_CompactedIndices);
+			const uint32_t indexCount = static_cast<uint32_t>(m_CompactedIndices.size()) - firstIndex;
+
+			m_MeshletCount += model->GetMeshletCount();
+			m_CulledMeshletCount += model->GetMeshletCount() - keptCount;
+			m_TriangleCount += indexCount / 3;
+
+			if (indexCount == 0)
+			{
+				continue;
+			}
+
+			// The instance index still points at the object's slot in the instance buffer
+			m_CompactedCommands.push_back({ indexCount, 1, firstIndex, model->GetVertexOffset(), i });
+		}
+	}
+
+	void SimpleRenderSystem::DrawIndirect(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		const uint32_t regularCount = static_cast<uint32_t>(m_IndirectCommands.size());
+		const uint32_t compactedCount = static_cast<uint32_t>(m_CompactedCommands.size());
+
+		m_IndirectCommandCount = regularCount + compactedCount;
+
+		if (m_IndirectCommandCount == 0)
+		{
+			return;
+		}
+
+		ReserveIndirectCommands(frameIndex, m_IndirectCommandCount);
+
+		// The compacted commands go right after the regular ones, they only need another index buffer
+		auto& indirectBuffer = m_IndirectBuffers[frameIndex];
+
+		if (regularCount > 0)
+		{
+			indirectBuffer->WriteToBuffer(m_IndirectCommands.data(), sizeof(VkDrawIndexedIndirectCommand) * regularCount);
+		}
+
+		if (compactedCount > 0)
+		{
+			indirectBuffer->WriteToBuffer(m_CompactedCommands.data(),
+				sizeof(VkDrawIndexedIndirectCommand) * compactedCount,
+				sizeof(VkDrawIndexedIndirectCommand) * regularCount);
+		}
+
+		indirectBuffer->Flush();
+
+		m_GeometryPool->Bind(commandBuffer);
+		DrawIndirectRange(commandBuffer, indirectBuffer->GetBuffer(), 0, regularCount);
+
+		if (compactedCount > 0)
+		{
+			vkCmdBindIndexBuffer(commandBuffer, m_CompactedIndexBuffers[frameIndex]->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			DrawIndirectRange(commandBuffer, indirectBuffer->GetBuffer(), regularCount, compactedCount);
+		}
+	}
+
+	void SimpleRenderSystem::DrawIndirectRange(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, uint32_t first, uint32_t count)
+	{
+		const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+
+		// Without multiDrawIndirect every command needs its own call, but still no per object state changes
+		const uint32_t maxDrawCount = m_Device.GetEnabledFeatures().multiDrawIndirect
+			? m_Device.m_Properties.limits.maxDrawIndirectCount
+			: 1;
+
+		for (uint32_t offset = 0; offset < count; offset += maxDrawCount)
+		{
+			const uint32_t drawCount = std::min(maxDrawCount, count - offset);
+
+			vkCmdDrawIndexedIndirect(commandBuffer, indirectBuffer, (first + offset) * stride, drawCount, stride);
+			m_DrawCallCount++;
+		}
+	}
+
+	uint32_t SimpleRenderSystem::SelectLod(const VECamera& camera, const VEModel& model, const glm::vec3& center, float radius) const
+	{
+		if (model.GetLodCount() == 1 || m_LodThreshold <= 0.0f)
+		{
+			return 0;
+		}
+
+		// The world sphere's radius grows with the largest scale of the transform, so their ratio converts
+		// object space errors to world space
+		const float objectRadius = model.GetBoundingSphere().Radius;
+		const float scale = objectRadius > 0.0f ? radius / objectRadius : 1.0f;
+
+		// Measured at the point of the sphere nearest to the camera, where the error looks largest
+		const float screenSize = camera.GetProjectedSize(scale, camera.GetDepth(center) - radius);
+
+		return model.SelectLod(m_LodThreshold / screenSize);
+	}
+
 	void SimpleRenderSystem::RenderGameObjects(FrameInfo& frameInfo)
 	{
+		m_Candidates.clear();
+		m_CandidateSpheres.Clear();
+		m_DrawList.clear();
+
+		// Only entities with a model are visited, straight from the scene's packed model array
+		frameInfo.Scene.ForEachModel([this](VEEntity, VEModel* model, TransformComponent& transform)
+		{
+			// Skip models whose vertex data is still being uploaded
+			if (!model->IsResident())
+			{
+				return;
+			}
+
+			assert(!transform.IsDirty() && "VEScene::UpdateTransforms must run before rendering.");
+
+			const VEBoundingSphere sphere = model->GetBoundingSphere().Transform(transform.GetWorldMatrix());
+
+			m_Candidates.push_back({ model, &transform, 0 });
+			m_CandidateSpheres.Add(sphere.Center.x, sphere.Center.y, sphere.Center.z, sphere.Radius);
+		});
+
+		const VEFrustum frustum(frameInfo.Camera.GetProjectionMatrix() * frameInfo.Camera.GetViewMatrix());
+
+		float planes[VEFrustum::PLANE_COUNT * 4];
+		frustum.GetPlanes(planes);
+
+		// The SIMD sphere pass rejects most objects, the box catches long thin ones the sphere is too loose for
+		VECulling::CullSpheres(planes, m_CandidateSpheres, m_VisibleIndices);
+
+		for (uint32_t index : m_VisibleIndices)
+		{
+			DrawItem item = m_Candidates[index];
+
+			if (frustum.Intersects(item.Model->GetBoundingBox().Transform(item.Transform->GetWorldMatrix())))
+			{
+				const glm::vec3 center = {
+					m_CandidateSpheres.GetCenterX()[index],
+					m_CandidateSpheres.GetCenterY()[index],
+					m_CandidateSpheres.GetCenterZ()[index]
+				};
+
+				item.Lod = SelectLod(frameInfo.Camera, *item.Model, center, m_CandidateSpheres.GetRadius()[index]);
+				m_DrawList.push_back(item);
+			}
+		}
+
+		m_VisibleCount = static_cast<uint32_t>(m_DrawList.size());
+		m_CulledCount = static_cast<uint32_t>(m_Candidates.size()) - m_VisibleCount;
+
+		// Group the objects by model and LOD so every pair becomes one contiguous run of instances
+		std::sort(m_DrawList.begin(), m_DrawList.end(),
+			[](const DrawItem& a, const DrawItem& b) { return a.Model < b.Model || (a.Model == b.Model && a.Lod < b.Lod); });
+
+		m_DrawCallCount = 0;
+		m_IndirectCommandCount = 0;
+		m_InstanceCount = static_cast<uint32_t>(m_DrawList.size());
+		m_TriangleCount = 0;
+		m_MeshletCount = 0;
+		m_CulledMeshletCount = 0;
+		m_IndirectCommands.clear();
+		m_CompactedIndices.clear();
+		m_CompactedCommands.clear();
+
+		if (m_DrawList.empty())
+		{
+			return;
+		}
+
+		ReserveInstances(frameInfo.FrameIndex, m_InstanceCount);
+
+		auto& instanceBuffer = m_InstanceBuffers[frameInfo.FrameIndex];
+		InstanceData* instances = static_cast<InstanceData*>(instanceBuffer->GetMappedMemory());
+
+		for (uint32_t i = 0; i < m_InstanceCount; i++)
+		{
+			// Vertex positions are packed relative to the model's bounds, world * translate(offset) * scale(scale)
+			// turns them straight into world space. Normals are unpacked in the shader and keep the normal matrix
+			const glm::mat4& world = m_DrawList[i].Transform->GetWorldMatrix();
+			const glm::vec3& scale = m_DrawList[i].Model->GetPositionScale();
+
+			instances[i].ModelMatrix[0]				= world[0] * scale.x;
+			instances[i].ModelMatrix[1]				= world[1] * scale.y;
+			instances[i].ModelMatrix[2]				= world[2] * scale.z;
+			instances[i].ModelMatrix[3]				= world * glm::vec4(m_DrawList[i].Model->GetPositionOffset(), 1.0f);
+			instances[i].NormalMatrix				= glm::mat4(m_DrawList[i].Transform->GetWorldNormalMatrix());
+		}
+
+		instanceBuffer->Flush();
+
 		m_Pipeline->Bind(frameInfo.CommandBuffer);
 
+		VkDescriptorSet descriptorSets[] = { frameInfo.GlobalDescriptorSet, m_InstanceDescriptorSets[frameInfo.FrameIndex] };
+
 		vkCmdBindDescriptorSets(frameInfo.CommandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_PipelineLayout,
 			0,
-			1,
-			&frameInfo.GlobalDescriptorSet,
+			2,
+			descriptorSets,
 			0,
 			nullptr);
 
-		for (auto& kv : frameInfo.GameObjects)
+		const glm::vec3 cameraPosition = frameInfo.Camera.GetPosition();
+
+		// firstInstance offsets gl_InstanceIndex, so each run reads its own slice of the instance buffer
+		uint32_t first = 0;
+
+		while (first < m_InstanceCount)
 		{
-			auto& obj = kv.second;
+			VEModel* model = m_DrawList[first].Model;
+			const uint32_t lod = m_DrawList[first].Lod;
+			uint32_t last = first + 1;
 
-			if (obj.m_Model == nullptr)
+			while (last < m_InstanceCount && m_DrawList[last].Model == model && m_DrawList[last].Lod == lod)
 			{
-				continue;
+				last++;
 			}
 
-			SimplePushConstantData push = {};
+			const bool pooled = m_UseIndirect && model->GetGeometryPool() == m_GeometryPool;
 
-			push.ModelMatrix						= obj.m_Transform.Mat4();
-			push.NormalMatrix						= obj.m_Transform.NormalMatrix();
+			// Models outside of the pool always stay on the instanced path
+			if (m_MeshletCulling &&
+				pooled &&
+				lod == 0 &&
+				model->GetMeshletCount() >= MIN_CULLED_MESHLETS &&
+				last - first <= MAX_CULLED_INSTANCES)
+			{
+				CullMeshlets(frustum, cameraPosition, first, last);
+			}
+			else if (pooled)
+			{
+				m_IndirectCommands.push_back(model->GetDrawCommand(last - first, first, lod));
+				m_TriangleCount += (last - first) * (model->GetLod(lod).IndexCount / 3);
+			}
+			else
+			{
+				model->Bind(frameInfo.CommandBuffer);
+				model->Draw(frameInfo.CommandBuffer, last - first, first, lod);
 
-			vkCmdPushConstants(frameInfo.CommandBuffer,
-				m_PipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push);
+				m_DrawCallCount++;
+				m_TriangleCount += (last - first) * (model->GetLod(lod).IndexCount / 3);
+			}
 
-			obj.m_Model->Bind(frameInfo.CommandBuffer);
-			obj.m_Model->Draw(frameInfo.CommandBuffer);
+			first = last;
 		}
+
+		if (!m_CompactedIndices.empty())
+		{
+			const uint32_t indexCount = static_cast<uint32_t>(m_CompactedIndices.size());
+
+			ReserveCompactedIndices(frameInfo.FrameIndex, indexCount);
+
+			auto& indexBuffer = m_CompactedIndexBuffers[frameInfo.FrameIndex];
+			indexBuffer->WriteToBuffer(m_CompactedIndices.data(), sizeof(uint32_t) * indexCount);
+			indexBuffer->Flush();
+		}
+
+		// All of the pooled models go out together
+		DrawIndirect(frameInfo.CommandBuffer, frameInfo.FrameIndex);
 	}
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
+#include "VE_Buffer.h"
 #include "VE_Camera.h"
+#include "VE_Culling.h"
+#include "VE_Descriptors.h"
 #include "VE_Device.h"
 #include "VE_FrameInfo.h"
-#include "VE_GameObject.h"
+#include "VE_GeometryPool.h"
 #include "VE_Pipeline.h"
+#include "VE_Scene.h"
 
 #include <memory>
 #include <vector>
@@ -14,22 +18,114 @@ namespace VulkanEngine {
 	class SimpleRenderSystem
 	{
 	public:
-		SimpleRenderSystem(VEDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		// Models packed into geometryPool are drawn with indirect commands instead of one draw call each
+		SimpleRenderSystem(VEDevice& device,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout,
+			VEGeometryPool* geometryPool = nullptr);
 		~SimpleRenderSystem();
 
 		// Delete the copy constructor and copy operator
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+		// Roughly one pixel at 1080p
+		static constexpr float DEFAULT_LOD_THRESHOLD = 1.0f / 1080.0f;
+
+		// Meshlet culling turns every instance into its own draw and copies its indices each frame, so it only
+		// pays off for detailed models with few instances
+		static constexpr uint32_t MIN_CULLED_MESHLETS = 16;
+		static constexpr uint32_t MAX_CULLED_INSTANCES = 64;
+
+		// Objects outside the camera's frustum are skipped, the rest are drawn with one instanced draw per model and LOD
 		void RenderGameObjects(FrameInfo& frameInfo);
 
+		// Every object is drawn at the coarsest LOD whose error covers at most this fraction of the screen height.
+		// 0 always draws LOD 0
+		void SetLodThreshold(float screenFraction) { m_LodThreshold = screenFraction; }
+		float GetLodThreshold() const { return m_LodThreshold; }
+
+		// Pooled models drawn at LOD 0 cull their meshlets against the frustum and the camera direction, and only
+		// the indices of the ones left are drawn, see MIN_CULLED_MESHLETS. Off by default
+		void SetMeshletCulling(bool enabled) { m_MeshletCulling = enabled; }
+		bool GetMeshletCulling() const { return m_MeshletCulling; }
+
+		uint32_t GetVisibleCount() const { return m_VisibleCount; }
+		uint32_t GetCulledCount() const { return m_CulledCount; }
+
+		uint32_t GetDrawCallCount() const { return m_DrawCallCount; }
+		uint32_t GetIndirectCommandCount() const { return m_IndirectCommandCount; }
+		uint32_t GetInstanceCount() const { return m_InstanceCount; }
+		uint32_t GetTriangleCount() const { return m_TriangleCount; }
+		uint32_t GetMeshletCount() const { return m_MeshletCount; }
+		uint32_t GetCulledMeshletCount() const { return m_CulledMeshletCount; }
+
 	private:
+		struct DrawItem
+		{
+			VEModel* Model;
+			TransformComponent* Transform;
+			uint32_t Lod;
+		};
+
+
+		void CreateInstanceBuffers();
 		void CreatePipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void CreatePipeline(VkRenderPass renderPass);
 
+		// Grows the instance buffer of a frame so it holds at least instanceCount instances
+		void ReserveInstances(uint32_t frameIndex, uint32_t instanceCount);
+		void ReserveIndirectCommands(uint32_t frameIndex, uint32_t commandCount);
+		void ReserveCompactedIndices(uint32_t frameIndex, uint32_t indexCount);
+
+		// Culls the meshlets of every instance in [first, last) of the draw list into the compacted indices
+		void CullMeshlets(const VEFrustum& frustum, const glm::vec3& cameraPosition, uint32_t first, uint32_t last);
+
+		void DrawIndirect(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void DrawIndirectRange(VkCommandBuffer commandBuffer, VkBuffer indirectBuffer, uint32_t first, uint32_t count);
+
+		// center and radius are the object's world space bounding sphere
+		uint32_t SelectLod(const VECamera& camera, const VEModel& model, const glm::vec3& center, float radius) const;
+
 	private:
 		VEDevice& m_Device;
 		std::unique_ptr<VEPipeline> m_Pipeline;
 		VkPipelineLayout m_PipelineLayout;
+
+		// Per frame storage buffers with the model and normal matrix of every instance
+		std::unique_ptr<VEDescriptorSetLayout> m_InstanceSetLayout;
+		std::unique_ptr<VEDescriptorPool> m_InstancePool;
+		std::vector<std::unique_ptr<VEBuffer>> m_InstanceBuffers;
+		std::vector<VkDescriptorSet> m_InstanceDescriptorSets;
+
+		// Per frame VkDrawIndexedIndirectCommand records, one per model in the geometry pool
+		VEGeometryPool* m_GeometryPool = nullptr;
+		std::vector<std::unique_ptr<VEBuffer>> m_IndirectBuffers;
+		std::vector<VkDrawIndexedIndirectCommand> m_IndirectCommands;
+		bool m_UseIndirect = false;
+
+		// Per frame index buffers with the indices of the meshlets that survived culling, drawn with indirect
+		// commands after the regular ones
+		std::vector<std::unique_ptr<VEBuffer>> m_CompactedIndexBuffers;
+		std::vector<uint32_t> m_CompactedIndices;
+		std::vector<VkDrawIndexedIndirectCommand> m_CompactedCommands;
+		bool m_MeshletCulling = false;
+
+		// Reused every frame to avoid allocating while culling and grouping objects by model
+		std::vector<DrawItem> m_Candidates;
+		VESphereList m_CandidateSpheres;
+		std::vector<uint32_t> m_VisibleIndices;
+		std::vector<DrawItem> m_DrawList;
+
+		float m_LodThreshold = DEFAULT_LOD_THRESHOLD;
+
+		uint32_t m_DrawCallCount = 0;
+		uint32_t m_IndirectCommandCount = 0;
+		uint32_t m_InstanceCount = 0;
+		uint32_t m_VisibleCount = 0;
+		uint32_t m_CulledCount = 0;
+		uint32_t m_TriangleCount = 0;
+		uint32_t m_MeshletCount = 0;
+		uint32_t m_CulledMeshletCount = 0;
 	};
 }
\ No newline at end of file
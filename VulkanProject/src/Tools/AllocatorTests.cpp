@@ -0,0 +1,283 @@
+#include "AllocatorTests.h"
+
+#include "VE_BuddyAllocator.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Counts the checks and prints the ones that fail with the test they belong to
+	class TestContext
+	{
+	public:
+		void Check(bool condition, const char* test, const char* description)
+		{
+			m_CheckCount++;
+
+			if (!condition)
+			{
+				std::cout << "FAILED " << test << ": " << description << std::endl;
+				m_FailureCount++;
+			}
+		}
+
+		uint32_t GetCheckCount() const { return m_CheckCount; }
+		uint32_t GetFailureCount() const { return m_FailureCount; }
+
+	private:
+		uint32_t m_CheckCount = 0;
+		uint32_t m_FailureCount = 0;
+	};
+
+	static constexpr uint64_t CAPACITY = 1ull << 20;
+	static constexpr uint64_t MIN_BLOCK = 256;
+
+	// True when none of the [offset, offset + size) ranges overlap
+	static bool AreDisjoint(std::vector<std::pair<uint64_t, uint64_t>> ranges)
+	{
+		std::sort(ranges.begin(), ranges.end());
+
+		for (size_t i = 1; i < ranges.size(); i++)
+		{
+			if (ranges[i - 1].first + ranges[i - 1].second > ranges[i].first)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	static void TestRoundTrips(TestContext& context, std::mt19937& random)
+	{
+		const char* test = "round trips";
+
+		VEBuddyAllocator allocator(CAPACITY, MIN_BLOCK);
+		std::uniform_int_distribution<uint64_t> size(1, 16 * 1024);
+
+		// Random interleaved allocations and frees, the live ranges must never overlap
+		std::vector<std::pair<uint64_t, uint64_t>> live;
+		bool disjoint = true;
+		bool sized = true;
+		uint64_t requested = 0;
+
+		for (int i = 0; i < 10000; i++)
+		{
+			if (!live.empty() && (random() % 3 == 0 || live.size() > 64))
+			{
+				const size_t index = random() % live.size();
+
+				allocator.Free(live[index].first);
+				requested -= live[index].second;
+
+				live[index] = live.back();
+				live.pop_back();
+				continue;
+			}
+
+			const uint64_t bytes = size(random);
+			const uint64_t offset = allocator.Allocate(bytes);
+
+			if (offset == VEBuddyAllocator::INVALID_OFFSET)
+			{
+				continue;
+			}
+
+			const uint64_t blockSize = allocator.GetAllocationSize(offset);
+			sized = sized && blockSize >= bytes && blockSize >= MIN_BLOCK && (blockSize & (blockSize - 1)) == 0;
+
+			live.push_back({ offset, bytes });
+			requested += bytes;
+
+			disjoint = disjoint && offset + bytes <= CAPACITY && AreDisjoint(live);
+		}
+
+		context.Check(disjoint, test, "live allocations overlap or leave the capacity");
+		context.Check(sized, test, "allocation sizes aren't powers of two covering the request");
+		context.Check(allocator.GetStats().BytesRequested == requested, test, "requested bytes don't match the live allocations");
+
+		for (const auto& allocation : live)
+		{
+			allocator.Free(allocation.first);
+		}
+
+		const VEBuddyAllocator::Stats stats = allocator.GetStats();
+
+		context.Check(allocator.IsEmpty(), test, "allocations left after freeing everything");
+		context.Check(stats.BytesAllocated == 0 && stats.BytesRequested == 0, test, "bytes still counted after freeing everything");
+		context.Check(allocator.Allocate(0) == VEBuddyAllocator::INVALID_OFFSET, test, "zero sized allocation succeeded");
+		context.Check(allocator.Allocate(CAPACITY + 1) == VEBuddyAllocator::INVALID_OFFSET, test, "allocation larger than the capacity succeeded");
+	}
+
+	static void TestMerging(TestContext& context, std::mt19937& random)
+	{
+		const char* test = "merging";
+
+		VEBuddyAllocator allocator(CAPACITY, MIN_BLOCK);
+
+		// Split everything down to the smallest blocks, then free them in random order
+		std::vector<uint64_t> offsets;
+
+		for (uint64_t offset = allocator.Allocate(MIN_BLOCK); offset != VEBuddyAllocator::INVALID_OFFSET; offset = allocator.Allocate(MIN_BLOCK))
+		{
+			offsets.push_back(offset);
+		}
+
+		context.Check(offsets.size() == CAPACITY / MIN_BLOCK, test, "the capacity didn't split into minimum sized blocks");
+		context.Check(allocator.GetStats().FreeBlockCount == 0, test, "free blocks left after filling the capacity");
+
+		std::shuffle(offsets.begin(), offsets.end(), random);
+
+		for (uint64_t offset : offsets)
+		{
+			allocator.Free(offset);
+		}
+
+		const VEBuddyAllocator::Stats stats = allocator.GetStats();
+
+		context.Check(stats.FreeBlockCount == 1 && stats.LargestFreeBlock == CAPACITY, test, "the buddies didn't merge back into one block");
+		context.Check(allocator.Allocate(CAPACITY) == 0, test, "the whole capacity can't be allocated after merging");
+	}
+
+	static void TestAlignment(TestContext& context, std::mt19937& random)
+	{
+		const char* test = "alignment";
+
+		VEBuddyAllocator allocator(CAPACITY, MIN_BLOCK);
+		std::uniform_int_distribution<uint64_t> size(1, 4096);
+		std::uniform_int_distribution<uint32_t> alignmentShift(0, 16);
+
+		std::vector<std::pair<uint64_t, uint64_t>> live;
+		bool aligned = true;
+
+		for (int i = 0; i < 2000; i++)
+		{
+			const uint64_t alignment = 1ull << alignmentShift(random);
+			const uint64_t bytes = size(random);
+			const uint64_t offset = allocator.Allocate(bytes, alignment);
+
+			if (offset == VEBuddyAllocator::INVALID_OFFSET)
+			{
+				// Full, start over
+				for (const auto& allocation : live)
+				{
+					allocator.Free(allocation.first);
+				}
+
+				live.clear();
+				continue;
+			}
+
+			aligned = aligned && offset % alignment == 0;
+			live.push_back({ offset, bytes });
+		}
+
+		context.Check(aligned, test, "an offset isn't a multiple of its alignment");
+		context.Check(AreDisjoint(live), test, "aligned allocations overlap");
+	}
+
+	static void TestBlockList(TestContext& context)
+	{
+		const char* test = "block list";
+
+		const uint64_t quarter = CAPACITY / 4;
+		VEBuddyBlockList blockList(CAPACITY, MIN_BLOCK);
+
+		uint32_t blockIndex = 0;
+		uint64_t offset = 0;
+
+		context.Check(!blockList.Allocate(MIN_BLOCK, 1, blockIndex, offset), test, "allocated from a list without blocks");
+		context.Check(blockList.AddBlock() == 0, test, "the first block isn't slot 0");
+
+		// Four quarters fill the first block, the fifth needs a new one
+		std::vector<std::pair<uint32_t, uint64_t>> allocations;
+
+		for (int i = 0; i < 4; i++)
+		{
+			const bool allocated = blockList.Allocate(quarter, 1, blockIndex, offset);
+
+			context.Check(allocated && blockIndex == 0, test, "a quarter didn't fit in the first block");
+			allocations.push_back({ blockIndex, offset });
+		}
+
+		context.Check(!blockList.Allocate(quarter, 1, blockIndex, offset), test, "allocated past a full block");
+		context.Check(blockList.AddBlock() == 1, test, "the second block isn't slot 1");
+		context.Check(blockList.Allocate(quarter, 1, blockIndex, offset) && blockIndex == 1, test, "didn't fall over to the new block");
+
+		// The second block is released as soon as it is empty, the first one is kept
+		context.Check(blockList.Free(blockIndex, offset), test, "an empty second block wasn't released");
+		context.Check(blockList.GetBlock(1) == nullptr, test, "a released block is still there");
+		context.Check(blockList.AddBlock() == 1, test, "a new block didn't reuse the released slot");
+
+		bool released = false;
+
+		for (const auto& allocation : allocations)
+		{
+			released = blockList.Free(allocation.first, allocation.second) || released;
+		}
+
+		context.Check(!released && blockList.GetBlock(0) != nullptr, test, "the first block was released");
+		context.Check(blockList.GetBlock(0)->IsEmpty(), test, "the first block isn't empty after freeing everything");
+	}
+
+	static void TestFragmentation(TestContext& context)
+	{
+		const char* test = "fragmentation";
+
+		VEBuddyAllocator allocator(CAPACITY, MIN_BLOCK);
+		std::vector<uint64_t> offsets;
+
+		for (uint64_t offset = allocator.Allocate(MIN_BLOCK); offset != VEBuddyAllocator::INVALID_OFFSET; offset = allocator.Allocate(MIN_BLOCK))
+		{
+			offsets.push_back(offset);
+		}
+
+		std::sort(offsets.begin(), offsets.end());
+
+		// Freeing every other block frees half of the memory, but no two free blocks are buddies
+		for (size_t i = 0; i < offsets.size(); i += 2)
+		{
+			allocator.Free(offsets[i]);
+		}
+
+		VEBuddyAllocator::Stats stats = allocator.GetStats();
+
+		context.Check(stats.LargestFreeBlock == MIN_BLOCK, test, "free blocks merged with allocated buddies");
+		context.Check(stats.FreeBlockCount == offsets.size() / 2, test, "wrong number of free blocks");
+		context.Check(stats.Fragmentation() > 0.99f, test, "a checkerboard of free blocks isn't reported as fragmented");
+		context.Check(allocator.Allocate(MIN_BLOCK * 2) == VEBuddyAllocator::INVALID_OFFSET, test, "allocated a block larger than any free one");
+
+		for (size_t i = 1; i < offsets.size(); i += 2)
+		{
+			allocator.Free(offsets[i]);
+		}
+
+		stats = allocator.GetStats();
+
+		context.Check(stats.Fragmentation() == 0.0f && stats.FreeBlockCount == 1, test, "still fragmented after freeing everything");
+	}
+
+	int RunAllocatorTests(int argc, char** argv)
+	{
+		const uint32_t seed = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 1234;
+
+		std::mt19937 random(seed);
+		TestContext context;
+
+		TestRoundTrips(context, random);
+		TestMerging(context, random);
+		TestAlignment(context, random);
+		TestBlockList(context);
+		TestFragmentation(context);
+
+		std::cout << "allocator: " << context.GetCheckCount() - context.GetFailureCount() << " of "
+			<< context.GetCheckCount() << " checks passed (seed " << seed << ")" << std::endl;
+
+		return context.GetFailureCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace VulkanEngine {
+
+	// Usage: --test-allocator [seed]
+	// Checks VEBuddyAllocator and VEBuddyBlockList on the CPU: round trips, merging, alignment, growing into new
+	// blocks and fragmentation. Prints every failed check and returns a process exit code
+	int RunAllocatorTests(int argc, char** argv);
+}
\ No newline at end of file
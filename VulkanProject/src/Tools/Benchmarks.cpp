@@ -0,0 +1,678 @@
+#include "Benchmarks.h"
+
+#include "VE_Culling.h"
+#include "VE_DepthSort.h"
+#include "VE_Frustum.h"
+#include "VE_Model.h"
+#include "VE_Scene.h"
+#include "VE_TransformBatch.h"
+#include "VE_Utils.h"
+#include "VE_VertexTable.h"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace std {
+
+	// The vertex hash LoadModel used with std::unordered_map, kept as the reference for the weld benchmark
+	template <>
+	struct hash<VulkanEngine::VEModel::Vertex>
+	{
+		size_t operator()(VulkanEngine::VEModel::Vertex const& vertex) const
+		{
+			size_t seed = 0;
+			VulkanEngine::HashCombine(seed, vertex.Position, vertex.Color, vertex.Normal, vertex.UV);
+			return seed;
+		}
+	};
+}
+
+namespace VulkanEngine {
+
+	// A few float roundings of the terms of the plane distance
+	static constexpr double BOUNDARY_EPSILON = 1.0e-6;
+
+	// True when the sphere touches one of the planes closely enough for rounding to decide whether it is visible
+	static bool IsOnFrustumBoundary(const float* planes, const VESphereList& spheres, uint32_t index)
+	{
+		const double x = spheres.GetCenterX()[index];
+		const double y = spheres.GetCenterY()[index];
+		const double z = spheres.GetCenterZ()[index];
+		const double radius = spheres.GetRadius()[index];
+
+		for (uint32_t p = 0; p < VEFrustum::PLANE_COUNT; p++)
+		{
+			const float* plane = planes + p * 4;
+
+			const double margin = plane[0] * x + plane[1] * y + plane[2] * z + plane[3] + radius;
+			const double magnitude = std::abs(plane[0] * x) + std::abs(plane[1] * y) + std::abs(plane[2] * z) + std::abs(plane[3]) + radius;
+
+			if (std::abs(margin) <= BOUNDARY_EPSILON * magnitude)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	int RunCullingBenchmark(int argc, char** argv)
+	{
+		const uint32_t objectCount = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 100000;
+		const int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 100;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		// Objects scattered around a camera in the middle of the scene, so roughly a tenth of them are visible
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> radius(0.25f, 4.0f);
+
+		VESphereList spheres = {};
+		spheres.Reserve(objectCount);
+
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			spheres.Add(position(random), position(random), position(random), radius(random));
+		}
+
+		const glm::mat4 projection = glm::perspective(glm::radians(50.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+		const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+		const VEFrustum frustum(projection * view);
+
+		float planes[VEFrustum::PLANE_COUNT * 4];
+		frustum.GetPlanes(planes);
+
+		std::vector<uint32_t> reference = {};
+		VECulling::CullSpheres(planes, spheres, reference, VECulling::Path::Scalar);
+
+		std::cout << objectCount << " spheres, " << reference.size() << " visible, best path "
+			<< VECulling::GetPathName(VECulling::GetBestPath()) << std::endl;
+
+		double scalarTime = 0.0;
+
+		for (VECulling::Path path : { VECulling::Path::Scalar, VECulling::Path::SSE, VECulling::Path::AVX2 })
+		{
+			if (path == VECulling::Path::AVX2 && VECulling::GetBestPath() != VECulling::Path::AVX2)
+			{
+				continue;
+			}
+
+			std::vector<uint32_t> visible = {};
+
+			auto start = Clock::now();
+
+			for (int i = 0; i < iterations; i++)
+			{
+				VECulling::CullSpheres(planes, spheres, visible, path);
+			}
+
+			double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+			if (path == VECulling::Path::Scalar)
+			{
+				scalarTime = time;
+			}
+
+			// The paths round differently, so spheres right on a plane may disagree. Only the others are errors
+			std::vector<uint32_t> differences = {};
+			std::set_symmetric_difference(visible.begin(), visible.end(), reference.begin(), reference.end(), std::back_inserter(differences));
+
+			uint32_t boundaryCount = 0;
+
+			for (uint32_t index : differences)
+			{
+				boundaryCount += IsOnFrustumBoundary(planes, spheres, index) ? 1 : 0;
+			}
+
+			const bool valid = boundaryCount == differences.size();
+
+			std::cout << "\t" << VECulling::GetPathName(path) << ":\t" << time << " ms (" << scalarTime / time << "x)";
+
+			if (boundaryCount > 0)
+			{
+				std::cout << ", " << boundaryCount << " spheres on a plane differ";
+			}
+
+			std::cout << (valid ? "" : " OUTPUT MISMATCH") << std::endl;
+
+			if (!valid)
+			{
+				return EXIT_FAILURE;
+			}
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	// The layout VEScene replaced, one map node per object with the optional components behind pointers.
+	// There is no device to create models with, so HasModel stands in for the null check on Model
+	struct LegacyGameObject
+	{
+		glm::vec3 Color{};
+		TransformComponent Transform{};
+		std::shared_ptr<VEModel> Model{};
+		bool HasModel = false;
+		std::unique_ptr<PointLightComponent> PointLight = nullptr;
+	};
+
+	int RunSceneBenchmark(int argc, char** argv)
+	{
+		const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		const glm::mat4 rotateLight = glm::rotate(glm::mat4(1.0f), 0.01f, { 0.0f, -1.0f, 0.0f });
+
+		for (uint32_t entityCount : { 10000u, 100000u, 1000000u })
+		{
+			std::mt19937 random(1234);
+			std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+
+			std::unordered_map<uint32_t, LegacyGameObject> legacy;
+			VEScene scene;
+			scene.Reserve(entityCount, entityCount / 100 + 1);
+
+			// Nine in ten entities have a model and one in a hundred is a point light
+			for (uint32_t i = 0; i < entityCount; i++)
+			{
+				const glm::vec3 translation{ position(random), position(random), position(random) };
+
+				LegacyGameObject object = {};
+				object.Transform.SetTranslation(translation);
+
+				VEEntity entity = scene.CreateEntity();
+				scene.GetTransform(entity).SetTranslation(translation);
+
+				if (i % 100 == 0)
+				{
+					object.PointLight = std::make_unique<PointLightComponent>();
+					scene.GetPointLights().Add(entity);
+				}
+				else if (i % 10 != 0)
+				{
+					// SetModel removes the entry for a null model, the pool itself keeps it like any other
+					object.HasModel = true;
+					scene.GetModels().Add(entity, nullptr);
+				}
+
+				legacy.emplace(i, std::move(object));
+			}
+
+			// What the render systems do each frame, minus the matrix math and draw recording
+			float legacySum = 0.0f;
+
+			auto start = Clock::now();
+
+			for (int frame = 0; frame < iterations; frame++)
+			{
+				for (auto& kv : legacy)
+				{
+					auto& obj = kv.second;
+
+					if (obj.HasModel)
+					{
+						legacySum += obj.Transform.GetTranslation().x * obj.Transform.GetScale().x;
+					}
+				}
+
+				for (auto& kv : legacy)
+				{
+					auto& obj = kv.second;
+
+					if (obj.PointLight != nullptr)
+					{
+						obj.Transform.SetTranslation(glm::vec3(rotateLight * glm::vec4(obj.Transform.GetTranslation(), 1.0f)));
+						legacySum += obj.PointLight->LightIntensity;
+					}
+				}
+			}
+
+			const double legacyTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+			float sceneSum = 0.0f;
+
+			start = Clock::now();
+
+			for (int frame = 0; frame < iterations; frame++)
+			{
+				scene.ForEachModel([&sceneSum](VEEntity, VEModel*, TransformComponent& transform)
+				{
+					sceneSum += transform.GetTranslation().x * transform.GetScale().x;
+				});
+
+				scene.ForEachPointLight([&](VEEntity, PointLightComponent& light, TransformComponent& transform)
+				{
+					transform.SetTranslation(glm::vec3(rotateLight * glm::vec4(transform.GetTranslation(), 1.0f)));
+					sceneSum += light.LightIntensity;
+				});
+			}
+
+			const double sceneTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+			// The sums are printed so the loops can't be optimized away, the visit order differs so they only roughly match
+			std::cout << entityCount << " entities:\tmap " << legacyTime << " ms\tscene " << sceneTime << " ms ("
+				<< legacyTime / sceneTime << "x)\tchecksums " << legacySum << " / " << sceneSum << std::endl;
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	// World matrix composed from the parent chain with TransformComponent::Mat4, independent of the scene's update order
+	static const glm::mat4& GetReferenceWorldMatrix(VEScene& scene, VEEntity entity, std::vector<glm::mat4>& matrices, std::vector<uint8_t>& known)
+	{
+		if (!known[entity])
+		{
+			const VEEntity parent = scene.GetParent(entity);
+			const glm::mat4 local = scene.GetTransform(entity).Mat4();
+
+			matrices[entity] = parent == NULL_ENTITY ? local : GetReferenceWorldMatrix(scene, parent, matrices, known) * local;
+			known[entity] = 1;
+		}
+
+		return matrices[entity];
+	}
+
+	// Largest error of any world matrix, relative to the largest element of the expected matrix
+	static float GetMaxWorldMatrixError(VEScene& scene, uint32_t entityCount)
+	{
+		std::vector<glm::mat4> matrices(entityCount);
+		std::vector<uint8_t> known(entityCount, 0);
+		float maxError = 0.0f;
+
+		for (VEEntity entity = 0; entity < entityCount; entity++)
+		{
+			const float* expected = &GetReferenceWorldMatrix(scene, entity, matrices, known)[0][0];
+			const float* actual = &scene.GetTransform(entity).GetWorldMatrix()[0][0];
+
+			float magnitude = 1.0f;
+
+			for (int e = 0; e < 16; e++)
+			{
+				magnitude = std::max(magnitude, std::abs(expected[e]));
+			}
+
+			for (int e = 0; e < 16; e++)
+			{
+				maxError = std::max(maxError, std::abs(actual[e] - expected[e]) / magnitude);
+			}
+		}
+
+		return maxError;
+	}
+
+	// Builds a random tree where parents are often created after their children, so SortHierarchy has to reorder it,
+	// then moves and reparents a few entities and checks the world matrices after each update
+	static bool CheckHierarchy(uint32_t entityCount)
+	{
+		constexpr float MAX_ERROR = 1.0e-4f;
+
+		std::mt19937 random(4321);
+		std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+		std::uniform_real_distribution<float> angle(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+
+		VEScene scene;
+		scene.Reserve(entityCount);
+
+		for (uint32_t i = 0; i < entityCount; i++)
+		{
+			TransformComponent& transform = scene.GetTransform(scene.CreateEntity());
+			transform.SetTranslation({ position(random), position(random), position(random) });
+			transform.SetRotation({ angle(random), angle(random), angle(random) });
+			transform.SetScale({ scale(random), scale(random), scale(random) });
+		}
+
+		// Every entity but the first in the shuffled order gets a parent from earlier in that order
+		std::vector<VEEntity> order(entityCount);
+
+		for (uint32_t i = 0; i < entityCount; i++)
+		{
+			order[i] = i;
+		}
+
+		std::shuffle(order.begin(), order.end(), random);
+
+		for (uint32_t i = 1; i < entityCount; i++)
+		{
+			scene.SetParent(order[i], order[std::uniform_int_distribution<uint32_t>(0, i - 1)(random)]);
+		}
+
+		scene.UpdateTransforms();
+		float maxError = GetMaxWorldMatrixError(scene, entityCount);
+
+		// Fewer moved transforms than a SIMD block take the scalar update, their descendants still have to follow
+		scene.GetTransform(order[0]).SetTranslation({ position(random), position(random), position(random) });
+		scene.GetTransform(order[1]).SetRotation({ angle(random), angle(random), angle(random) });
+
+		scene.UpdateTransforms();
+		maxError = std::max(maxError, GetMaxWorldMatrixError(scene, entityCount));
+
+		// Only order[0] is an ancestor of order[1], so moving a later subtree under it can't create a cycle
+		scene.SetParent(order[entityCount - 1], order[1]);
+		scene.SetParent(order[entityCount / 2], order[1]);
+		scene.SetParent(order[entityCount / 3], NULL_ENTITY);
+		scene.GetTransform(order[1]).SetScale({ scale(random), scale(random), scale(random) });
+
+		scene.UpdateTransforms();
+		maxError = std::max(maxError, GetMaxWorldMatrixError(scene, entityCount));
+
+		const bool valid = maxError < MAX_ERROR;
+
+		std::cout << "\tHierarchy of " << entityCount << " entities, max relative error " << maxError
+			<< (valid ? "" : " OUTPUT MISMATCH") << std::endl;
+
+		return valid;
+	}
+
+	int RunTransformBenchmark(int argc, char** argv)
+	{
+		const uint32_t transformCount = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 100000;
+		const int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 20;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		// Angles well outside [-pi, pi] so the range reduction of the SIMD sincos is exercised
+		std::mt19937 random(1234);
+		std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> angle(-20.0f, 20.0f);
+		std::uniform_real_distribution<float> scale(0.1f, 5.0f);
+
+		std::vector<TransformComponent> transforms(transformCount);
+		VETransformBatch batch = {};
+		batch.Reserve(transformCount);
+
+		for (auto& transform : transforms)
+		{
+			transform.SetTranslation({ position(random), position(random), position(random) });
+			transform.SetRotation({ angle(random), angle(random), angle(random) });
+			transform.SetScale({ scale(random), scale(random), scale(random) });
+
+			batch.Add(&transform.GetTranslation().x, &transform.GetRotation().x, &transform.GetScale().x);
+		}
+
+		std::vector<glm::mat4> referenceMatrices(transformCount);
+		std::vector<glm::mat3> referenceNormals(transformCount);
+
+		auto start = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			for (uint32_t t = 0; t < transformCount; t++)
+			{
+				referenceMatrices[t] = transforms[t].Mat4();
+				referenceNormals[t] = transforms[t].NormalMatrix();
+			}
+		}
+
+		const double referenceTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+		std::cout << transformCount << " transforms, best path " << VECulling::GetPathName(VECulling::GetBestPath()) << std::endl;
+		std::cout << "\tTransformComponent:\t" << referenceTime << " ms" << std::endl;
+
+		if (!CheckHierarchy(1000))
+		{
+			return EXIT_FAILURE;
+		}
+
+		for (VECulling::Path path : { VECulling::Path::Scalar, VECulling::Path::SSE, VECulling::Path::AVX2 })
+		{
+			if (path == VECulling::Path::AVX2 && VECulling::GetBestPath() != VECulling::Path::AVX2)
+			{
+				continue;
+			}
+
+			std::vector<glm::mat4> matrices(transformCount);
+			std::vector<glm::mat3> normals(transformCount);
+
+			start = Clock::now();
+
+			for (int i = 0; i < iterations; i++)
+			{
+				batch.Compute(&matrices[0][0][0], &normals[0][0][0], path);
+			}
+
+			const double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+			// Error relative to the magnitude of each element, translations are copied and always exact
+			float maxError = 0.0f;
+
+			for (uint32_t t = 0; t < transformCount; t++)
+			{
+				const float* expected = &referenceMatrices[t][0][0];
+				const float* actual = &matrices[t][0][0];
+
+				for (int e = 0; e < 16; e++)
+				{
+					maxError = std::max(maxError, std::abs(actual[e] - expected[e]) / std::max(1.0f, std::abs(expected[e])));
+				}
+
+				expected = &referenceNormals[t][0][0];
+				actual = &normals[t][0][0];
+
+				for (int e = 0; e < 9; e++)
+				{
+					maxError = std::max(maxError, std::abs(actual[e] - expected[e]) / std::max(1.0f, std::abs(expected[e])));
+				}
+			}
+
+			const bool valid = path == VECulling::Path::Scalar ? maxError == 0.0f : maxError < 1.0e-5f;
+
+			std::cout << "\t" << VECulling::GetPathName(path) << ":\t" << time << " ms (" << referenceTime / time
+				<< "x), max relative error " << maxError << (valid ? "" : " OUTPUT MISMATCH") << std::endl;
+
+			if (!valid)
+			{
+				return EXIT_FAILURE;
+			}
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	int RunDepthSortBenchmark(int argc, char** argv)
+	{
+		const uint32_t spriteCount = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 10000;
+		const int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1000;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		// Sprites on a coarse grid, so many share a distance the way lights placed in a pattern do
+		std::mt19937 random(1234);
+		std::uniform_int_distribution<int> cell(-50, 50);
+
+		std::vector<float> distances(spriteCount);
+
+		for (float& distance : distances)
+		{
+			const glm::vec3 offset(cell(random), cell(random) * 0.5f, cell(random));
+			distance = glm::dot(offset, offset);
+		}
+
+		// The map keeps one sprite per distance, the ones it drops are what the old light pass lost
+		size_t mapSize = 0;
+
+		auto start = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			std::map<float, uint32_t> sorted;
+
+			for (uint32_t s = 0; s < spriteCount; s++)
+			{
+				sorted[distances[s]] = s;
+			}
+
+			mapSize = sorted.size();
+		}
+
+		const double mapTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+		std::vector<uint32_t> reference(spriteCount);
+
+		start = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			for (uint32_t s = 0; s < spriteCount; s++)
+			{
+				reference[s] = s;
+			}
+
+			std::stable_sort(reference.begin(), reference.end(),
+				[&distances](uint32_t a, uint32_t b) { return distances[a] > distances[b]; });
+		}
+
+		const double stableSortTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+		VEDepthSort depthSort = {};
+		depthSort.Reserve(spriteCount);
+
+		const uint32_t* sorted = nullptr;
+
+		start = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			depthSort.Clear();
+
+			for (uint32_t s = 0; s < spriteCount; s++)
+			{
+				depthSort.Add(distances[s], s);
+			}
+
+			sorted = depthSort.Sort(VEDepthSort::Order::BackToFront);
+		}
+
+		const double depthSortTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+		// Both sorts are stable, so the orders must be identical, not just equally sorted
+		const bool valid = std::equal(reference.begin(), reference.end(), sorted);
+
+		std::cout << spriteCount << " sprites" << std::endl;
+		std::cout << "\tstd::map:\t" << mapTime << " ms, kept " << mapSize << " of " << spriteCount << std::endl;
+		std::cout << "\tstd::stable_sort:\t" << stableSortTime << " ms" << std::endl;
+		std::cout << "\tVEDepthSort:\t" << depthSortTime << " ms (" << mapTime / depthSortTime << "x map, "
+			<< stableSortTime / depthSortTime << "x stable_sort)" << (valid ? "" : " OUTPUT MISMATCH") << std::endl;
+
+		return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int RunVertexWeldBenchmark(int argc, char** argv)
+	{
+		const uint32_t gridSize = argc > 2 ? static_cast<uint32_t>(std::max(1, std::atoi(argv[2]))) : 1024;
+		const int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 5;
+
+		using Clock = std::chrono::high_resolution_clock;
+		using Vertex = VEModel::Vertex;
+
+		// Six corners per quad the way an OBJ file lists them. The UVs restart every 16 quads, so the vertices
+		// along those columns are split into seams like a real texture layout does
+		std::vector<Vertex> corners;
+		corners.reserve(static_cast<size_t>(gridSize) * gridSize * 6);
+
+		const uint32_t quadCorners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+
+		for (uint32_t z = 0; z < gridSize; z++)
+		{
+			for (uint32_t x = 0; x < gridSize; x++)
+			{
+				for (const auto& corner : quadCorners)
+				{
+					const float px = static_cast<float>(x + corner[0]);
+					const float pz = static_cast<float>(z + corner[1]);
+
+					Vertex vertex = {};
+					vertex.Position = { px, std::sin(px * 0.1f) * std::cos(pz * 0.1f), pz };
+					vertex.Color = { 1.0f, 1.0f, 1.0f };
+					vertex.Normal = glm::normalize(glm::vec3(-std::cos(px * 0.1f) * 0.1f, 1.0f, std::sin(pz * 0.1f) * 0.1f));
+					vertex.UV = { static_cast<float>(x % 16 + corner[0]) / 16.0f, static_cast<float>(z % 16 + corner[1]) / 16.0f };
+
+					corners.push_back(vertex);
+				}
+			}
+		}
+
+		// The loop LoadModel used to run, a count and two lookups per corner
+		std::vector<Vertex> referenceVertices;
+		std::vector<uint32_t> referenceIndices;
+
+		auto start = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+			referenceVertices.clear();
+			referenceIndices.clear();
+
+			for (const Vertex& vertex : corners)
+			{
+				if (uniqueVertices.count(vertex) == 0)
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(referenceVertices.size());
+					referenceVertices.push_back(vertex);
+				}
+
+				referenceIndices.push_back(uniqueVertices[vertex]);
+			}
+		}
+
+		const double mapTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+
+		start = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			VEVertexTable uniqueVertices(sizeof(Vertex), corners.size() / 4);
+			vertices.clear();
+			indices.clear();
+			indices.reserve(corners.size());
+
+			for (const Vertex& vertex : corners)
+			{
+				const uint32_t newIndex = static_cast<uint32_t>(vertices.size());
+				vertices.push_back(vertex);
+
+				const uint32_t vertexIndex = uniqueVertices.FindOrInsert(vertices.data(), newIndex);
+
+				if (vertexIndex != newIndex)
+				{
+					vertices.pop_back();
+				}
+
+				indices.push_back(vertexIndex);
+			}
+		}
+
+		const double tableTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+
+		// Both keep the vertices in order of first use, so the outputs must be identical
+		const bool valid = vertices == referenceVertices && indices == referenceIndices;
+
+		std::cout << corners.size() << " indices, " << referenceVertices.size() << " unique vertices" << std::endl;
+		std::cout << "\tstd::unordered_map:\t" << mapTime << " ms" << std::endl;
+		std::cout << "\tVEVertexTable:\t" << tableTime << " ms (" << mapTime / tableTime << "x)"
+			<< (valid ? "" : " OUTPUT MISMATCH") << std::endl;
+
+		return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
\ No newline at end of file
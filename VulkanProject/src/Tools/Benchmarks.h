@@ -0,0 +1,27 @@
+#pragma once
+
+namespace VulkanEngine {
+
+	// Command line microbenchmarks of engine systems that run on the CPU alone, without a window or device.
+	// Each returns a process exit code
+
+	// Usage: --bench-culling [objectCount] [iterations]
+	int RunCullingBenchmark(int argc, char** argv);
+
+	// Usage: --bench-scene [iterations]
+	// Per frame iteration over 10k, 100k and 1M entities, VEScene against the old map of game objects
+	int RunSceneBenchmark(int argc, char** argv);
+
+	// Usage: --bench-transforms [transformCount] [iterations]
+	// Checks every VETransformBatch path against TransformComponent, the scalar one must match bit for bit
+	// and that VEScene's world matrices match the parent chains composed by hand after moving and reparenting
+	int RunTransformBenchmark(int argc, char** argv);
+
+	// Usage: --bench-depth-sort [spriteCount] [iterations]
+	// Back to front sprite sorting, VEDepthSort against std::map and std::stable_sort
+	int RunDepthSortBenchmark(int argc, char** argv);
+
+	// Usage: --bench-vertex-weld [gridSize] [iterations]
+	// Welds the corners of a gridSize * gridSize quad mesh, VEVertexTable against the std::unordered_map LoadModel used
+	int RunVertexWeldBenchmark(int argc, char** argv);
+}
\ No newline at end of file
@@ -0,0 +1,389 @@
+#include "FrameBenchmark.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <utility>
+
+namespace VulkanEngine {
+
+	// Nearest rank percentile, sorted must be in ascending order
+	static double GetPercentile(const std::vector<double>& sorted, double percentile)
+	{
+		if (sorted.empty())
+		{
+			return 0.0;
+		}
+
+		const size_t rank = static_cast<size_t>(percentile / 100.0 * (sorted.size() - 1) + 0.5);
+		return sorted[std::min(rank, sorted.size() - 1)];
+	}
+
+	static double GetMean(const std::vector<double>& values)
+	{
+		double sum = 0.0;
+
+		for (double value : values)
+		{
+			sum += value;
+		}
+
+		return values.empty() ? 0.0 : sum / values.size();
+	}
+
+	// Gathers one member of every frame, sorted for the percentiles
+	template<typename T>
+	static std::vector<double> GetSortedSamples(const std::vector<BenchmarkFrame>& frames, T BenchmarkFrame::* member)
+	{
+		std::vector<double> samples;
+		samples.reserve(frames.size());
+
+		for (const BenchmarkFrame& frame : frames)
+		{
+			samples.push_back(static_cast<double>(frame.*member));
+		}
+
+		std::sort(samples.begin(), samples.end());
+
+		return samples;
+	}
+
+	// Paths and device names only need quotes and backslashes escaped
+	static std::string EscapeJson(const std::string& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				escaped += '\\';
+			}
+
+			escaped += c;
+		}
+
+		return escaped;
+	}
+
+	// Recursive descent over one JSON value starting at position, which ends up just past it
+	class JsonValidator
+	{
+	public:
+		explicit JsonValidator(const std::string& text) : m_Text{ text } {}
+
+		bool ParseDocument()
+		{
+			return ParseValue(0) && (SkipWhitespace(), m_Position == m_Text.size());
+		}
+
+	private:
+		static constexpr uint32_t MAX_DEPTH = 64;
+
+		void SkipWhitespace()
+		{
+			while (m_Position < m_Text.size() && std::strchr(" \t\r\n", m_Text[m_Position]) != nullptr)
+			{
+				m_Position++;
+			}
+		}
+
+		bool Accept(char c)
+		{
+			SkipWhitespace();
+
+			if (m_Position < m_Text.size() && m_Text[m_Position] == c)
+			{
+				m_Position++;
+				return true;
+			}
+
+			return false;
+		}
+
+		bool AcceptDigits()
+		{
+			const size_t start = m_Position;
+
+			while (m_Position < m_Text.size() && m_Text[m_Position] >= '0' && m_Text[m_Position] <= '9')
+			{
+				m_Position++;
+			}
+
+			return m_Position > start;
+		}
+
+		bool ParseValue(uint32_t depth)
+		{
+			if (depth > MAX_DEPTH)
+			{
+				return false;
+			}
+
+			SkipWhitespace();
+
+			if (m_Position == m_Text.size())
+			{
+				return false;
+			}
+
+			switch (m_Text[m_Position])
+			{
+			case '{': return ParseObject(depth);
+			case '[': return ParseArray(depth);
+			case '"': return ParseString();
+			case 't': return ParseLiteral("true");
+			case 'f': return ParseLiteral("false");
+			case 'n': return ParseLiteral("null");
+			default: return ParseNumber();
+			}
+		}
+
+		bool ParseObject(uint32_t depth)
+		{
+			m_Position++;
+
+			if (Accept('}'))
+			{
+				return true;
+			}
+
+			do
+			{
+				SkipWhitespace();
+
+				if (m_Position == m_Text.size() || m_Text[m_Position] != '"' || !ParseString() || !Accept(':') || !ParseValue(depth + 1))
+				{
+					return false;
+				}
+			} while (Accept(','));
+
+			return Accept('}');
+		}
+
+		bool ParseArray(uint32_t depth)
+		{
+			m_Position++;
+
+			if (Accept(']'))
+			{
+				return true;
+			}
+
+			do
+			{
+				if (!ParseValue(depth + 1))
+				{
+					return false;
+				}
+			} while (Accept(','));
+
+			return Accept(']');
+		}
+
+		bool ParseString()
+		{
+			m_Position++;
+
+			while (m_Position < m_Text.size())
+			{
+				const char c = m_Text[m_Position++];
+
+				if (c == '"')
+				{
+					return true;
+				}
+
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					return false;
+				}
+
+				if (c == '\\')
+				{
+					if (m_Position == m_Text.size() || std::strchr("\"\\/bfnrtu", m_Text[m_Position]) == nullptr)
+					{
+						return false;
+					}
+
+					m_Position++;
+				}
+			}
+
+			return false;
+		}
+
+		bool ParseLiteral(const char* literal)
+		{
+			const size_t length = std::strlen(literal);
+
+			if (m_Text.compare(m_Position, length, literal) != 0)
+			{
+				return false;
+			}
+
+			m_Position += length;
+			return true;
+		}
+
+		// Rejects what streams print for values JSON can't hold, like nan and inf
+		bool ParseNumber()
+		{
+			if (m_Text[m_Position] == '-')
+			{
+				m_Position++;
+			}
+
+			const size_t integerStart = m_Position;
+
+			// No leading zeros
+			if (!AcceptDigits() || (m_Text[integerStart] == '0' && m_Position - integerStart > 1))
+			{
+				return false;
+			}
+
+			if (m_Position < m_Text.size() && m_Text[m_Position] == '.')
+			{
+				m_Position++;
+
+				if (!AcceptDigits())
+				{
+					return false;
+				}
+			}
+
+			if (m_Position < m_Text.size() && (m_Text[m_Position] == 'e' || m_Text[m_Position] == 'E'))
+			{
+				m_Position++;
+
+				if (m_Position < m_Text.size() && (m_Text[m_Position] == '+' || m_Text[m_Position] == '-'))
+				{
+					m_Position++;
+				}
+
+				if (!AcceptDigits())
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+	private:
+		const std::string& m_Text;
+		size_t m_Position = 0;
+	};
+
+	bool IsValidJson(const std::string& text)
+	{
+		return JsonValidator(text).ParseDocument();
+	}
+
+	BenchmarkSettings ParseBenchmarkSettings(int argc, char** argv)
+	{
+		BenchmarkSettings settings = {};
+
+		// Flags can go anywhere, everything else is positional
+		std::vector<const char*> arguments;
+
+		for (int i = 2; i < argc; i++)
+		{
+			if (std::strcmp(argv[i], "--meshlet-culling") == 0)
+			{
+				settings.MeshletCulling = true;
+			}
+			else
+			{
+				arguments.push_back(argv[i]);
+			}
+		}
+
+		const size_t count = arguments.size();
+
+		if (count > 0) settings.FrameCount = static_cast<uint32_t>(std::max(1, std::atoi(arguments[0])));
+		if (count > 1) settings.ObjectCount = static_cast<uint32_t>(std::max(0, std::atoi(arguments[1])));
+		if (count > 2) settings.LightCount = static_cast<uint32_t>(std::max(0, std::atoi(arguments[2])));
+		if (count > 3) settings.MeshPath = arguments[3];
+		if (count > 4) settings.OutputPath = arguments[4];
+
+		return settings;
+	}
+
+	void WriteBenchmarkReport(std::ostream& out,
+		const BenchmarkSettings& settings,
+		const char* deviceName,
+		const std::vector<BenchmarkFrame>& frames)
+	{
+		const std::vector<double> frameTimes = GetSortedSamples(frames, &BenchmarkFrame::FrameTime);
+
+		out << "{\n";
+		out << "\t\"device\": \"" << EscapeJson(deviceName) << "\",\n";
+		out << "\t\"settings\": {\n";
+		out << "\t\t\"frames\": " << settings.FrameCount << ",\n";
+		out << "\t\t\"warmupFrames\": " << settings.WarmupFrames << ",\n";
+		out << "\t\t\"timeStep\": " << settings.TimeStep << ",\n";
+		out << "\t\t\"objects\": " << settings.ObjectCount << ",\n";
+		out << "\t\t\"lights\": " << settings.LightCount << ",\n";
+		out << "\t\t\"mesh\": \"" << EscapeJson(settings.MeshPath) << "\",\n";
+		out << "\t\t\"headless\": " << (settings.Headless ? "true" : "false") << ",\n";
+		out << "\t\t\"meshletCulling\": " << (settings.MeshletCulling ? "true" : "false") << "\n";
+		out << "\t},\n";
+
+		out << "\t\"frameTimeMs\": {\n";
+		out << "\t\t\"mean\": " << GetMean(frameTimes) << ",\n";
+		out << "\t\t\"min\": " << (frameTimes.empty() ? 0.0 : frameTimes.front()) << ",\n";
+		out << "\t\t\"p50\": " << GetPercentile(frameTimes, 50.0) << ",\n";
+		out << "\t\t\"p95\": " << GetPercentile(frameTimes, 95.0) << ",\n";
+		out << "\t\t\"p99\": " << GetPercentile(frameTimes, 99.0) << ",\n";
+		out << "\t\t\"max\": " << (frameTimes.empty() ? 0.0 : frameTimes.back()) << "\n";
+		out << "\t},\n";
+
+		const std::pair<const char*, double BenchmarkFrame::*> systems[] = {
+			{ "wait", &BenchmarkFrame::WaitTime },
+			{ "lightUpdate", &BenchmarkFrame::LightUpdateTime },
+			{ "transformUpdate", &BenchmarkFrame::TransformUpdateTime },
+			{ "sceneRender", &BenchmarkFrame::SceneRenderTime },
+			{ "lightRender", &BenchmarkFrame::LightRenderTime },
+			{ "submit", &BenchmarkFrame::SubmitTime }
+		};
+
+		out << "\t\"systemTimeMs\": {\n";
+
+		for (size_t i = 0; i < std::size(systems); i++)
+		{
+			const std::vector<double> samples = GetSortedSamples(frames, systems[i].second);
+
+			out << "\t\t\"" << systems[i].first << "\": { \"mean\": " << GetMean(samples)
+				<< ", \"p95\": " << GetPercentile(samples, 95.0) << " }" << (i + 1 < std::size(systems) ? ",\n" : "\n");
+		}
+
+		out << "\t},\n";
+
+		const std::pair<const char*, uint32_t BenchmarkFrame::*> counters[] = {
+			{ "visibleObjects", &BenchmarkFrame::VisibleObjects },
+			{ "culledObjects", &BenchmarkFrame::CulledObjects },
+			{ "drawCalls", &BenchmarkFrame::DrawCalls },
+			{ "indirectCommands", &BenchmarkFrame::IndirectCommands },
+			{ "instances", &BenchmarkFrame::Instances },
+			{ "triangles", &BenchmarkFrame::Triangles },
+			{ "meshlets", &BenchmarkFrame::Meshlets },
+			{ "culledMeshlets", &BenchmarkFrame::CulledMeshlets },
+			{ "uploadedLights", &BenchmarkFrame::UploadedLights },
+			{ "billboards", &BenchmarkFrame::Billboards }
+		};
+
+		out << "\t\"meanCounts\": {\n";
+
+		for (size_t i = 0; i < std::size(counters); i++)
+		{
+			out << "\t\t\"" << counters[i].first << "\": " << GetMean(GetSortedSamples(frames, counters[i].second))
+				<< (i + 1 < std::size(counters) ? ",\n" : "\n");
+		}
+
+		out << "\t}\n";
+		out << "}" << std::endl;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Synthetic scene and fixed frame loop of Application's benchmark mode. Every run with the same settings
+	// renders the same frames: the timestep is constant, the camera follows a scripted orbit and the scene
+	// is generated from a fixed seed
+	struct BenchmarkSettings
+	{
+		uint32_t FrameCount = 600;
+		uint32_t WarmupFrames = 30;			// Rendered but not recorded, so pipelines and caches settle first
+		float TimeStep = 1.0f / 60.0f;
+		uint32_t ObjectCount = 10000;
+		uint32_t LightCount = 256;
+		std::string MeshPath = "Models/smooth_vase.obj";
+		std::string OutputPath;				// JSON report, printed to stdout when empty
+		bool Headless = true;
+		bool MeshletCulling = false;		// See SimpleRenderSystem::SetMeshletCulling
+	};
+
+	// CPU time in milliseconds spent in each part of one frame, and what the frame drew
+	struct BenchmarkFrame
+	{
+		double FrameTime = 0.0;
+		double WaitTime = 0.0;				// BeginFrame, mostly waiting for the frame's fence
+		double LightUpdateTime = 0.0;
+		double TransformUpdateTime = 0.0;	// Includes animating the lights before their world matrices are updated
+		double SceneRenderTime = 0.0;		// Culling and recording the models
+		double LightRenderTime = 0.0;
+		double SubmitTime = 0.0;
+
+		uint32_t VisibleObjects = 0;
+		uint32_t CulledObjects = 0;
+		uint32_t DrawCalls = 0;
+		uint32_t IndirectCommands = 0;
+		uint32_t Instances = 0;
+		uint32_t Triangles = 0;				// After LOD selection and meshlet culling
+		uint32_t Meshlets = 0;
+		uint32_t CulledMeshlets = 0;
+		uint32_t UploadedLights = 0;
+		uint32_t Billboards = 0;
+	};
+
+	// Usage: --benchmark [frameCount] [objectCount] [lightCount] [meshPath] [outputPath] [--meshlet-culling]
+	BenchmarkSettings ParseBenchmarkSettings(int argc, char** argv);
+
+	// Percentiles of the frame time, mean and p95 of every part of the frame and the mean draw counts
+	void WriteBenchmarkReport(std::ostream& out,
+		const BenchmarkSettings& settings,
+		const char* deviceName,
+		const std::vector<BenchmarkFrame>& frames);
+
+	// Strict syntax check of a whole JSON document, the report is checked with it before it is written out
+	bool IsValidJson(const std::string& text);
+}
\ No newline at end of file
@@ -0,0 +1,280 @@
+#include "MeshTools.h"
+
+#include "VE_MeshCache.h"
+#include "VE_MeshOptimizer.h"
+#include "VE_Model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace VulkanEngine {
+
+	int RunMeshConverter(int argc, char** argv)
+	{
+		if (argc < 3)
+		{
+			std::cerr << "Usage: " << argv[0] << " --convert-mesh <input.obj> [output.vemesh]" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		const std::string inputPath = argv[2];
+		const std::string outputPath = argc > 3 ? argv[3] : VEMeshCache::GetCachePath(inputPath);
+
+		VEModel::Builder builder = {};
+
+		try
+		{
+			builder.LoadModel(inputPath);
+			builder.Optimize();
+			builder.GenerateLods();
+			builder.BuildMeshlets();
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to load " << inputPath << ": " << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		if (!VEMeshCache::WriteToFile(outputPath, inputPath, builder))
+		{
+			return EXIT_FAILURE;
+		}
+
+		std::cout << inputPath << " -> " << outputPath << " ("
+			<< builder.Vertices.size() << " vertices, "
+			<< builder.Indices.size() << " indices)" << std::endl;
+
+		for (size_t lod = 0; lod < builder.Lods.size(); lod++)
+		{
+			std::cout << "\tLOD " << lod << ": " << builder.Lods[lod].IndexCount / 3 << " triangles, error "
+				<< builder.Lods[lod].Error << std::endl;
+		}
+
+		std::cout << "\t" << builder.Meshlets.size() << " meshlets" << std::endl;
+
+		return EXIT_SUCCESS;
+	}
+
+	// Every triangle rotated so its smallest vertex comes first, in sorted order, so two index buffers that draw the
+	// same triangles compare equal
+	static std::vector<uint64_t> GetSortedTriangles(const VEModel::Builder& builder)
+	{
+		std::vector<uint64_t> triangles;
+		triangles.reserve(builder.Indices.size() / 3);
+
+		for (size_t i = 0; i + 2 < builder.Indices.size(); i += 3)
+		{
+			const VEModel::Vertex* corners[3] = {
+				&builder.Vertices[builder.Indices[i + 0]],
+				&builder.Vertices[builder.Indices[i + 1]],
+				&builder.Vertices[builder.Indices[i + 2]]
+			};
+
+			// Vertex indices change when the vertices are reordered, so compare by position instead
+			uint64_t hashes[3];
+
+			for (int corner = 0; corner < 3; corner++)
+			{
+				const glm::vec3& position = corners[corner]->Position;
+				hashes[corner] = std::hash<float>{}(position.x) ^ (std::hash<float>{}(position.y) << 1) ^ (std::hash<float>{}(position.z) << 2);
+			}
+
+			const int first = static_cast<int>(std::min_element(hashes, hashes + 3) - hashes);
+
+			uint64_t triangle = 0;
+
+			for (int corner = 0; corner < 3; corner++)
+			{
+				triangle = triangle * 1099511628211ull ^ hashes[(first + corner) % 3];
+			}
+
+			triangles.push_back(triangle);
+		}
+
+		std::sort(triangles.begin(), triangles.end());
+
+		return triangles;
+	}
+
+	int RunMeshOptimizerReport(int argc, char** argv)
+	{
+		if (argc < 3)
+		{
+			std::cerr << "Usage: " << argv[0] << " --analyze-mesh <input.obj> [cacheSize]" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		const std::string inputPath = argv[2];
+		const uint32_t cacheSize = argc > 3 ?
+			static_cast<uint32_t>(std::max(3, std::atoi(argv[3]))) :
+			VEMeshOptimizer::ANALYZE_CACHE_SIZE;
+
+		VEModel::Builder original = {};
+
+		try
+		{
+			original.LoadModel(inputPath);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Failed to load " << inputPath << ": " << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		const std::vector<uint64_t> originalTriangles = GetSortedTriangles(original);
+
+		std::cout << inputPath << ": " << original.Vertices.size() << " vertices, " << original.Indices.size() / 3
+			<< " triangles, " << cacheSize << " entry FIFO cache" << std::endl;
+
+		auto report = [&](const char* name, const VEModel::Builder& builder, double time)
+		{
+			const VEMeshOptimizer::VertexCacheStats stats = VEMeshOptimizer::AnalyzeVertexCache(builder.Indices,
+				static_cast<uint32_t>(builder.Vertices.size()), cacheSize);
+
+			const bool identical = GetSortedTriangles(builder) == originalTriangles;
+
+			std::cout << "\t" << name << "ACMR " << stats.ACMR << ", ATVR " << stats.ATVR;
+
+			if (time > 0.0)
+			{
+				std::cout << " (" << time << " ms)";
+			}
+
+			std::cout << (identical ? "" : " OUTPUT MISMATCH") << std::endl;
+
+			return identical;
+		};
+
+		bool identical = report("Original:  ", original, 0.0);
+
+		for (bool optimizeOverdraw : { false, true })
+		{
+			VEModel::Builder optimized = original;
+
+			auto start = Clock::now();
+			optimized.Optimize(optimizeOverdraw);
+			double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			identical &= report(optimizeOverdraw ? "Overdraw:  " : "Optimized: ", optimized, time);
+		}
+
+		return identical ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int RunMeshLoadBenchmark(int argc, char** argv)
+	{
+		if (argc < 3)
+		{
+			std::cerr << "Usage: " << argv[0] << " --bench-mesh-load <input.obj> [iterations]" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		const std::string inputPath = argv[2];
+		const int iterations = argc > 3 ? std::max(1, std::atoi(argv[3])) : 10;
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		VEModel::Builder builder = {};
+
+		auto objStart = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			builder.LoadModel(inputPath);
+		}
+
+		double objTime = std::chrono::duration<double, std::milli>(Clock::now() - objStart).count() / iterations;
+
+		if (!VEMeshCache::Write(inputPath, builder))
+		{
+			return EXIT_FAILURE;
+		}
+
+		auto cacheStart = Clock::now();
+
+		for (int i = 0; i < iterations; i++)
+		{
+			if (!VEMeshCache::Load(inputPath, builder))
+			{
+				std::cerr << "Failed to load the mesh cache for " << inputPath << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+
+		double cacheTime = std::chrono::duration<double, std::milli>(Clock::now() - cacheStart).count() / iterations;
+
+		std::cout << inputPath << ": " << builder.Vertices.size() << " vertices, " << builder.Indices.size() << " indices" << std::endl;
+		std::cout << "\tOBJ parse:   " << objTime << " ms" << std::endl;
+		std::cout << "\tCache load:  " << cacheTime << " ms" << std::endl;
+		std::cout << "\tSpeedup:     " << (cacheTime > 0.0 ? objTime / cacheTime : 0.0) << "x" << std::endl;
+
+		return EXIT_SUCCESS;
+	}
+
+	int RunMeshImportBenchmark(int argc, char** argv)
+	{
+		if (argc < 3)
+		{
+			std::cerr << "Usage: " << argv[0] << " --bench-mesh-import <input.obj> [maxThreads]" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		const std::string inputPath = argv[2];
+		const uint32_t maxThreads = argc > 3 ?
+			static_cast<uint32_t>(std::max(1, std::atoi(argv[3]))) :
+			std::max(1u, std::thread::hardware_concurrency());
+
+		using Clock = std::chrono::high_resolution_clock;
+
+		VEModel::Builder serial = {};
+
+		auto serialStart = Clock::now();
+		serial.LoadModel(inputPath, 1);
+		double serialTime = std::chrono::duration<double, std::milli>(Clock::now() - serialStart).count();
+
+		std::cout << inputPath << ": " << serial.Vertices.size() << " vertices, " << serial.Indices.size() << " indices" << std::endl;
+		std::cout << "\t1 thread:\t" << serialTime << " ms" << std::endl;
+
+		// Powers of two, then maxThreads itself when it isn't one
+		std::vector<uint32_t> threadCounts = {};
+
+		for (uint32_t threads = 2; threads <= maxThreads; threads *= 2)
+		{
+			threadCounts.push_back(threads);
+		}
+
+		if (maxThreads > 1 && threadCounts.back() != maxThreads)
+		{
+			threadCounts.push_back(maxThreads);
+		}
+
+		for (uint32_t threads : threadCounts)
+		{
+			VEModel::Builder parallel = {};
+
+			auto start = Clock::now();
+			parallel.LoadModel(inputPath, threads);
+			double time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+			const bool identical = parallel.Vertices == serial.Vertices && parallel.Indices == serial.Indices;
+
+			std::cout << "\t" << threads << " threads:\t" << time << " ms (" << serialTime / time << "x)"
+				<< (identical ? "" : " OUTPUT MISMATCH") << std::endl;
+
+			if (!identical)
+			{
+				return EXIT_FAILURE;
+			}
+		}
+
+		return EXIT_SUCCESS;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+
+namespace VulkanEngine {
+
+	// Command line entry points that work on mesh files without creating a window or device.
+	// Each returns a process exit code
+
+	// Usage: --convert-mesh <input.obj> [output.vemesh]
+	int RunMeshConverter(int argc, char** argv);
+
+	// Prints the simulated vertex cache ACMR and ATVR of the mesh as loaded, after the vertex cache pass and
+	// after the overdraw pass, and checks that neither pass changed the set of triangles
+	// Usage: --analyze-mesh <input.obj> [cacheSize]
+	int RunMeshOptimizerReport(int argc, char** argv);
+
+	// Usage: --bench-mesh-load <input.obj> [iterations]
+	int RunMeshLoadBenchmark(int argc, char** argv);
+
+	// Usage: --bench-mesh-import <input.obj> [maxThreads]
+	int RunMeshImportBenchmark(int argc, char** argv);
+}
\ No newline at end of file
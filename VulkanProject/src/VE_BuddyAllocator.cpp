@@ -0,0 +1,213 @@
+#include "VE_BuddyAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace VulkanEngine {
+
+	uint64_t VEBuddyAllocator::RoundUpToPowerOfTwo(uint64_t value)
+	{
+		uint64_t result = 1;
+
+		while (result < value)
+		{
+			result <<= 1;
+		}
+
+		return result;
+	}
+
+	uint32_t VEBuddyAllocator::Log2(uint64_t value)
+	{
+		uint32_t result = 0;
+
+		while (value > 1)
+		{
+			value >>= 1;
+			result++;
+		}
+
+		return result;
+	}
+
+	VEBuddyAllocator::VEBuddyAllocator(uint64_t capacity, uint64_t minBlockSize)
+	{
+		assert(capacity >= minBlockSize && "Buddy allocator capacity must be at least the minimum block size.");
+
+		m_MinBlockSize	= RoundUpToPowerOfTwo(std::max<uint64_t>(minBlockSize, 1));
+		m_Capacity		= 1ull << Log2(capacity);
+		m_MaxOrder		= Log2(m_Capacity / m_MinBlockSize);
+
+		m_FreeBlocks.resize(m_MaxOrder + 1);
+		m_FreeBlocks[m_MaxOrder].insert(0);
+	}
+
+	uint64_t VEBuddyAllocator::Allocate(uint64_t size, uint64_t alignment)
+	{
+		assert((alignment & (alignment - 1)) == 0 && "Alignment must be a power of two.");
+
+		// Blocks are always aligned to their own size, so a large enough block satisfies any alignment
+		const uint64_t blockSize = RoundUpToPowerOfTwo(std::max({ size, alignment, m_MinBlockSize }));
+
+		if (size == 0 || blockSize > m_Capacity)
+		{
+			return INVALID_OFFSET;
+		}
+
+		const uint32_t order = Log2(blockSize / m_MinBlockSize);
+
+		// Find the smallest free block that fits
+		uint32_t freeOrder = order;
+
+		while (freeOrder <= m_MaxOrder && m_FreeBlocks[freeOrder].empty())
+		{
+			freeOrder++;
+		}
+
+		if (freeOrder > m_MaxOrder)
+		{
+			return INVALID_OFFSET;
+		}
+
+		auto it = m_FreeBlocks[freeOrder].begin();
+		uint64_t offset = *it;
+		m_FreeBlocks[freeOrder].erase(it);
+
+		// Split it down to the requested size, returning the upper halves to the free lists
+		while (freeOrder > order)
+		{
+			freeOrder--;
+			m_FreeBlocks[freeOrder].insert(offset + BlockSize(freeOrder));
+		}
+
+		m_Allocations[offset] = { order, size };
+		m_BytesRequested += size;
+		m_BytesAllocated += BlockSize(order);
+
+		return offset;
+	}
+
+	void VEBuddyAllocator::Free(uint64_t offset)
+	{
+		auto it = m_Allocations.find(offset);
+		assert(it != m_Allocations.end() && "Freeing an offset that was not allocated.");
+
+		if (it == m_Allocations.end())
+		{
+			return;
+		}
+
+		uint32_t order = it->second.Order;
+
+		m_BytesRequested -= it->second.Size;
+		m_BytesAllocated -= BlockSize(order);
+		m_Allocations.erase(it);
+
+		// Merge with the buddy for as long as it is also free
+		while (order < m_MaxOrder)
+		{
+			const uint64_t buddy = offset ^ BlockSize(order);
+			auto buddyIt = m_FreeBlocks[order].find(buddy);
+
+			if (buddyIt == m_FreeBlocks[order].end())
+			{
+				break;
+			}
+
+			m_FreeBlocks[order].erase(buddyIt);
+			offset = std::min(offset, buddy);
+			order++;
+		}
+
+		m_FreeBlocks[order].insert(offset);
+	}
+
+	uint64_t VEBuddyAllocator::GetAllocationSize(uint64_t offset) const
+	{
+		auto it = m_Allocations.find(offset);
+		return it == m_Allocations.end() ? 0 : BlockSize(it->second.Order);
+	}
+
+	VEBuddyAllocator::Stats VEBuddyAllocator::GetStats() const
+	{
+		Stats stats = {};
+
+		stats.Capacity			= m_Capacity;
+		stats.BytesRequested	= m_BytesRequested;
+		stats.BytesAllocated	= m_BytesAllocated;
+		stats.AllocationCount	= static_cast<uint32_t>(m_Allocations.size());
+
+		for (uint32_t order = 0; order <= m_MaxOrder; order++)
+		{
+			stats.FreeBlockCount += static_cast<uint32_t>(m_FreeBlocks[order].size());
+
+			if (!m_FreeBlocks[order].empty())
+			{
+				stats.LargestFreeBlock = BlockSize(order);
+			}
+		}
+
+		return stats;
+	}
+
+	VEBuddyBlockList::VEBuddyBlockList(uint64_t blockSize, uint64_t minBlockSize)
+		: m_BlockSize{ blockSize }, m_MinBlockSize{ minBlockSize }
+	{
+	}
+
+	bool VEBuddyBlockList::Allocate(uint64_t size, uint64_t alignment, uint32_t& blockIndex, uint64_t& offset)
+	{
+		for (uint32_t i = 0; i < m_Blocks.size(); i++)
+		{
+			if (m_Blocks[i] == nullptr)
+			{
+				continue;
+			}
+
+			offset = m_Blocks[i]->Allocate(size, alignment);
+
+			if (offset != VEBuddyAllocator::INVALID_OFFSET)
+			{
+				blockIndex = i;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	uint32_t VEBuddyBlockList::AddBlock()
+	{
+		uint32_t slot = 0;
+
+		while (slot < m_Blocks.size() && m_Blocks[slot] != nullptr)
+		{
+			slot++;
+		}
+
+		if (slot == m_Blocks.size())
+		{
+			m_Blocks.emplace_back();
+		}
+
+		m_Blocks[slot] = std::make_unique<VEBuddyAllocator>(m_BlockSize, m_MinBlockSize);
+
+		return slot;
+	}
+
+	bool VEBuddyBlockList::Free(uint32_t blockIndex, uint64_t offset)
+	{
+		assert(blockIndex < m_Blocks.size() && m_Blocks[blockIndex] != nullptr && "Freeing from a released block.");
+
+		m_Blocks[blockIndex]->Free(offset);
+
+		if (blockIndex == 0 || !m_Blocks[blockIndex]->IsEmpty())
+		{
+			return false;
+		}
+
+		m_Blocks[blockIndex].reset();
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Power of two buddy allocator that hands out offsets into a range of memory it doesn't own.
+	// Has no Vulkan dependencies so the algorithm can be exercised on the CPU alone
+	class VEBuddyAllocator
+	{
+	public:
+		static constexpr uint64_t INVALID_OFFSET = ~0ull;
+
+		struct Stats
+		{
+			uint64_t Capacity			= 0;	// Size of the managed range
+			uint64_t BytesRequested		= 0;	// Sum of the sizes passed to Allocate
+			uint64_t BytesAllocated		= 0;	// Sum of the block sizes handed out, including rounding
+			uint64_t LargestFreeBlock	= 0;
+			uint32_t AllocationCount	= 0;
+			uint32_t FreeBlockCount		= 0;
+
+			// 0 when all free memory is one contiguous block, approaching 1 as it is split into small pieces
+			float Fragmentation() const
+			{
+				const uint64_t freeBytes = Capacity - BytesAllocated;
+				return freeBytes == 0 ? 0.0f : 1.0f - static_cast<float>(LargestFreeBlock) / static_cast<float>(freeBytes);
+			}
+		};
+
+		// Capacity and minBlockSize are rounded down and up to powers of two respectively
+		VEBuddyAllocator(uint64_t capacity, uint64_t minBlockSize = 256);
+
+		// Returns INVALID_OFFSET when there is no free block large enough. Alignment must be a power of two
+		uint64_t Allocate(uint64_t size, uint64_t alignment = 1);
+		void Free(uint64_t offset);
+
+		bool IsEmpty() const { return m_Allocations.empty(); }
+		uint64_t GetCapacity() const { return m_Capacity; }
+		uint64_t GetAllocationSize(uint64_t offset) const;
+		Stats GetStats() const;
+
+		static uint64_t RoundUpToPowerOfTwo(uint64_t value);
+		static uint32_t Log2(uint64_t value);
+
+	private:
+		struct Allocation
+		{
+			uint32_t Order;
+			uint64_t Size;
+		};
+
+		uint64_t BlockSize(uint32_t order) const { return m_MinBlockSize << order; }
+
+	private:
+		uint64_t m_Capacity;
+		uint64_t m_MinBlockSize;
+		uint32_t m_MaxOrder;
+
+		// Free block offsets for every order, order 0 being the minimum block size
+		std::vector<std::unordered_set<uint64_t>> m_FreeBlocks;
+		std::unordered_map<uint64_t, Allocation> m_Allocations;
+
+		uint64_t m_BytesRequested = 0;
+		uint64_t m_BytesAllocated = 0;
+	};
+
+	// Equally sized buddy allocators, added when none of the existing ones has room. Only decides where allocations
+	// go, VEDeviceAllocator backs every block with its own device memory
+	class VEBuddyBlockList
+	{
+	public:
+		VEBuddyBlockList(uint64_t blockSize, uint64_t minBlockSize);
+
+		// Tries the blocks in order. Returns false when none of them has room, AddBlock and try again
+		bool Allocate(uint64_t size, uint64_t alignment, uint32_t& blockIndex, uint64_t& offset);
+
+		// Adds an empty block, in the slot of a released one when there is one, and returns its index
+		uint32_t AddBlock();
+
+		// Returns true when the block became empty and was released. The first block is kept to avoid churn
+		bool Free(uint32_t blockIndex, uint64_t offset);
+
+		uint64_t GetBlockSize() const { return m_BlockSize; }
+		uint32_t GetSlotCount() const { return static_cast<uint32_t>(m_Blocks.size()); }
+
+		// Null for released slots
+		const VEBuddyAllocator* GetBlock(uint32_t blockIndex) const { return m_Blocks[blockIndex].get(); }
+
+	private:
+		uint64_t m_BlockSize;
+		uint64_t m_MinBlockSize;
+		std::vector<std::unique_ptr<VEBuddyAllocator>> m_Blocks;
+	};
+}
\ No newline at end of file
@@ -31,6 +31,23 @@ namespace VulkanEngine {
         return instanceSize;
     }
 
+    /**
+     * Resolves VK_WHOLE_SIZE to the end of this buffer's allocation, since the memory may be shared with other buffers
+     *
+     * @param size Size of the memory range, or VK_WHOLE_SIZE
+     *
+     * @return Size of the range to flush or invalidate
+     */
+    VkDeviceSize VEBuffer::GetMappedRangeSize(VkDeviceSize size) const
+    {
+        if (size == VK_WHOLE_SIZE && !m_Allocation.Dedicated)
+        {
+            return m_Allocation.Size;
+        }
+
+        return size;
+    }
+
     VEBuffer::VEBuffer(VEDevice& device, VkDeviceSize instanceSize,
         uint32_t instanceCount, VkBufferUsageFlags usageFlags,
         VkMemoryPropertyFlags memoryPropertyFlags, VkDeviceSize minOffsetAlignment)
@@ -42,19 +59,21 @@ namespace VulkanEngine {
     {
         m_AlignmentSize = GetAlignment(instanceSize, minOffsetAlignment);
         m_BufferSize = m_AlignmentSize * instanceCount;
-        device.CreateBuffer(m_BufferSize, usageFlags, memoryPropertyFlags, m_Buffer, m_Memory);
+        device.CreateBuffer(m_BufferSize, usageFlags, memoryPropertyFlags, m_Buffer, m_Allocation);
     }
 
     VEBuffer::~VEBuffer()
     {
         Unmap();
-        vkDestroyBuffer(m_Device.Device(), m_Buffer, nullptr);
-        vkFreeMemory(m_Device.Device(), m_Memory, nullptr);
+        m_Device.DestroyBuffer(m_Buffer, m_Allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note Host visible memory is persistently mapped by the device allocator, so this only hands out
+     * a pointer into the existing mapping
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -63,23 +82,26 @@ namespace VulkanEngine {
      */
     VkResult VEBuffer::Map(VkDeviceSize size, VkDeviceSize offset)
     {
-        assert(m_Buffer && m_Memory && "Called map on buffer before create");
+        assert(m_Buffer && m_Allocation.Memory && "Called map on buffer before create");
+
+        if (m_Allocation.Mapped == nullptr)
+        {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+
+        m_Mapped = static_cast<char*>(m_Allocation.Mapped) + offset;
 
-        return vkMapMemory(m_Device.Device(), m_Memory, offset, size, 0, &m_Mapped);
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The underlying memory stays mapped until its allocation is freed
      */
     void VEBuffer::Unmap()
     {
-        if (m_Mapped)
-        {
-            vkUnmapMemory(m_Device.Device(), m_Memory);
-            m_Mapped = nullptr;
-        }
+        m_Mapped = nullptr;
     }
 
     /**
@@ -122,9 +144,9 @@ namespace VulkanEngine {
     {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = m_Memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = m_Allocation.Memory;
+        mappedRange.offset = m_Allocation.Offset + offset;
+        mappedRange.size = GetMappedRangeSize(size);
         return vkFlushMappedMemoryRanges(m_Device.Device(), 1, &mappedRange);
     }
 
@@ -143,9 +165,9 @@ namespace VulkanEngine {
     {
         VkMappedMemoryRange mappedRange = {};
         mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = m_Memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        mappedRange.memory = m_Allocation.Memory;
+        mappedRange.offset = m_Allocation.Offset + offset;
+        mappedRange.size = GetMappedRangeSize(size);
         return vkInvalidateMappedMemoryRanges(m_Device.Device(), 1, &mappedRange);
     }
 
@@ -40,12 +40,13 @@ namespace VulkanEngine {
 
     private:
         static VkDeviceSize GetAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+        VkDeviceSize GetMappedRangeSize(VkDeviceSize size) const;
 
     private:
         VEDevice& m_Device;
         void* m_Mapped = nullptr;
         VkBuffer m_Buffer = VK_NULL_HANDLE;
-        VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+        VEAllocation m_Allocation = {};
 
         VkDeviceSize m_BufferSize;
         uint32_t m_InstanceCount;
@@ -1,6 +1,7 @@
 #include "VE_Camera.h"
 
 #include <cassert>
+#include <cmath>
 #include <limits>
 
 namespace VulkanEngine {
@@ -130,4 +131,22 @@ namespace VulkanEngine {
 		m_InverseViewMatrix[3][1] = position.y;
 		m_InverseViewMatrix[3][2] = position.z;
 	}	
+
+	float VECamera::GetDepth(const glm::vec3& position) const
+	{
+		return m_ViewMatrix[0][2] * position.x + m_ViewMatrix[1][2] * position.y + m_ViewMatrix[2][2] * position.z + m_ViewMatrix[3][2];
+	}
+
+	float VECamera::GetProjectedSize(float size, float depth) const
+	{
+		// Clip space spans two units of height, orthographic projections don't shrink with depth
+		const float projectedSize = size * std::abs(m_ProjectionMatrix[1][1]) * 0.5f;
+
+		if (m_ProjectionMatrix[2][3] == 0.0f)
+		{
+			return projectedSize;
+		}
+
+		return depth > 0.0f ? projectedSize / depth : std::numeric_limits<float>::max();
+	}
 }
\ No newline at end of file
@@ -28,6 +28,13 @@ namespace VulkanEngine {
 		const glm::mat4& GetInverseViewMatrix() const { return m_InverseViewMatrix; }
 		const glm::vec3 GetPosition() const { return glm::vec3(m_InverseViewMatrix[3]); }
 
+		// Distance of a world space position in front of the camera, along the view direction
+		float GetDepth(const glm::vec3& position) const;
+
+		// Fraction of the viewport height a world space length at the given depth covers. Lengths at or behind
+		// the camera cover everything
+		float GetProjectedSize(float size, float depth) const;
+
 	private:
 		glm::mat4 m_ProjectionMatrix{ 1.0f };
 		glm::mat4 m_ViewMatrix{1.0f};
@@ -0,0 +1,306 @@
+#include "VE_Culling.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define VE_CULLING_X86
+	#include <immintrin.h>
+
+	#ifdef _MSC_VER
+		#include <intrin.h>
+		#define VE_TARGET_AVX2
+	#else
+		#include <cpuid.h>
+		#define VE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#endif
+#endif
+
+namespace VulkanEngine {
+
+	static constexpr uint32_t PLANE_COUNT = 6;
+
+	void VESphereList::Clear()
+	{
+		m_CenterX.clear();
+		m_CenterY.clear();
+		m_CenterZ.clear();
+		m_Radius.clear();
+		m_Count = 0;
+	}
+
+	void VESphereList::Reserve(uint32_t count)
+	{
+		const size_t padded = (count + PADDING - 1) / PADDING * PADDING;
+
+		m_CenterX.reserve(padded);
+		m_CenterY.reserve(padded);
+		m_CenterZ.reserve(padded);
+		m_Radius.reserve(padded);
+	}
+
+	uint32_t VESphereList::Add(float x, float y, float z, float radius)
+	{
+		// Grow a whole block at a time. The padding spheres have a negative radius so they are never visible
+		if (m_Count % PADDING == 0)
+		{
+			const size_t padded = m_Count + PADDING;
+
+			m_CenterX.resize(padded, 0.0f);
+			m_CenterY.resize(padded, 0.0f);
+			m_CenterZ.resize(padded, 0.0f);
+			m_Radius.resize(padded, -1.0e30f);
+		}
+
+		m_CenterX[m_Count] = x;
+		m_CenterY[m_Count] = y;
+		m_CenterZ[m_Count] = z;
+		m_Radius[m_Count] = radius;
+
+		return m_Count++;
+	}
+
+	VECulling::Path VECulling::GetBestPath()
+	{
+#ifdef VE_CULLING_X86
+		static const Path path = []()
+		{
+			// AVX2 needs both the CPU feature and the OS saving the upper halves of the ymm registers
+			bool avx2 = false;
+
+	#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+
+			if (info[0] >= 7)
+			{
+				__cpuid(info, 1);
+				const bool osxsave = (info[2] & (1 << 27)) != 0;
+				const bool fma = (info[2] & (1 << 12)) != 0;
+
+				__cpuidex(info, 7, 0);
+				const bool avx2Bit = (info[1] & (1 << 5)) != 0;
+
+				avx2 = osxsave && fma && avx2Bit && (_xgetbv(0) & 0x6) == 0x6;
+			}
+	#else
+			__builtin_cpu_init();
+			avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+	#endif
+
+			// SSE2 is part of every x64 CPU
+			return avx2 ? Path::AVX2 : Path::SSE;
+		}();
+
+		return path;
+#else
+		return Path::Scalar;
+#endif
+	}
+
+	const char* VECulling::GetPathName(Path path)
+	{
+		switch (path)
+		{
+		case Path::SSE:		return "SSE";
+		case Path::AVX2:	return "AVX2";
+		default:			return "Scalar";
+		}
+	}
+
+	uint32_t VECulling::CullSpheres(const float* planes, const VESphereList& spheres, std::vector<uint32_t>& visible)
+	{
+		return CullSpheres(planes, spheres, visible, GetBestPath());
+	}
+
+	uint32_t VECulling::CullSpheres(const float* planes, const VESphereList& spheres, std::vector<uint32_t>& visible, Path path)
+	{
+		// The kernels write a whole register's worth of indices before compacting, so leave room for the padding
+		visible.resize(static_cast<size_t>(spheres.GetCount()) + VESphereList::PADDING);
+
+		uint32_t count = 0;
+
+		switch (path)
+		{
+		case Path::AVX2:	count = CullSpheresAVX2(planes, spheres, visible.data()); break;
+		case Path::SSE:		count = CullSpheresSSE(planes, spheres, visible.data()); break;
+		default:			count = CullSpheresScalar(planes, spheres, visible.data()); break;
+		}
+
+		visible.resize(count);
+		return count;
+	}
+
+	uint32_t VECulling::CullSpheresScalar(const float* planes, const VESphereList& spheres, uint32_t* visible)
+	{
+		const float* centerX = spheres.GetCenterX();
+		const float* centerY = spheres.GetCenterY();
+		const float* centerZ = spheres.GetCenterZ();
+		const float* radius = spheres.GetRadius();
+
+		uint32_t count = 0;
+
+		for (uint32_t i = 0; i < spheres.GetCount(); i++)
+		{
+			bool inside = true;
+
+			for (uint32_t p = 0; p < PLANE_COUNT; p++)
+			{
+				// Summed in the same order as the SSE kernel so both round the same way. The AVX2 kernel fuses
+				// the multiplies and adds, spheres touching a plane can come out differently there
+				const float* plane = planes + p * 4;
+				float distance = plane[0] * centerX[i] + plane[3];
+				distance = plane[1] * centerY[i] + distance;
+				distance = plane[2] * centerZ[i] + distance;
+
+				inside &= distance >= -radius[i];
+			}
+
+			// Branchless compaction, the index is always written but only kept when the sphere is visible
+			visible[count] = i;
+			count += inside ? 1 : 0;
+		}
+
+		return count;
+	}
+
+#ifdef VE_CULLING_X86
+	static inline uint32_t LowestSetBit(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<uint32_t>(index);
+#else
+		return static_cast<uint32_t>(__builtin_ctz(mask));
+#endif
+	}
+
+	uint32_t VECulling::CullSpheresSSE(const float* planes, const VESphereList& spheres, uint32_t* visible)
+	{
+		const float* centerX = spheres.GetCenterX();
+		const float* centerY = spheres.GetCenterY();
+		const float* centerZ = spheres.GetCenterZ();
+		const float* radius = spheres.GetRadius();
+
+		__m128 planeX[PLANE_COUNT], planeY[PLANE_COUNT], planeZ[PLANE_COUNT], planeW[PLANE_COUNT];
+
+		for (uint32_t p = 0; p < PLANE_COUNT; p++)
+		{
+			planeX[p] = _mm_set1_ps(planes[p * 4 + 0]);
+			planeY[p] = _mm_set1_ps(planes[p * 4 + 1]);
+			planeZ[p] = _mm_set1_ps(planes[p * 4 + 2]);
+			planeW[p] = _mm_set1_ps(planes[p * 4 + 3]);
+		}
+
+		const uint32_t count = spheres.GetCount();
+
+		uint32_t visibleCount = 0;
+
+		// The arrays are padded, so the last block can be read in full. Padding spheres are never visible
+		for (uint32_t i = 0; i < count; i += 4)
+		{
+			const __m128 x = _mm_loadu_ps(centerX + i);
+			const __m128 y = _mm_loadu_ps(centerY + i);
+			const __m128 z = _mm_loadu_ps(centerZ + i);
+			const __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+			for (uint32_t p = 0; p < PLANE_COUNT; p++)
+			{
+				__m128 distance = _mm_add_ps(_mm_mul_ps(planeX[p], x), planeW[p]);
+				distance = _mm_add_ps(_mm_mul_ps(planeY[p], y), distance);
+				distance = _mm_add_ps(_mm_mul_ps(planeZ[p], z), distance);
+
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+			}
+
+			uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+
+			// Only the visible lanes are appended, lowest index first
+			while (mask != 0)
+			{
+				visible[visibleCount++] = i + LowestSetBit(mask);
+				mask &= mask - 1;
+			}
+		}
+
+		return visibleCount;
+	}
+
+	VE_TARGET_AVX2
+	uint32_t VECulling::CullSpheresAVX2(const float* planes, const VESphereList& spheres, uint32_t* visible)
+	{
+		const float* centerX = spheres.GetCenterX();
+		const float* centerY = spheres.GetCenterY();
+		const float* centerZ = spheres.GetCenterZ();
+		const float* radius = spheres.GetRadius();
+
+		__m256 planeX[PLANE_COUNT], planeY[PLANE_COUNT], planeZ[PLANE_COUNT], planeW[PLANE_COUNT];
+
+		for (uint32_t p = 0; p < PLANE_COUNT; p++)
+		{
+			planeX[p] = _mm256_set1_ps(planes[p * 4 + 0]);
+			planeY[p] = _mm256_set1_ps(planes[p * 4 + 1]);
+			planeZ[p] = _mm256_set1_ps(planes[p * 4 + 2]);
+			planeW[p] = _mm256_set1_ps(planes[p * 4 + 3]);
+		}
+
+		const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const uint32_t count = spheres.GetCount();
+
+		uint32_t visibleCount = 0;
+
+		for (uint32_t i = 0; i < count; i += 8)
+		{
+			const __m256 x = _mm256_loadu_ps(centerX + i);
+			const __m256 y = _mm256_loadu_ps(centerY + i);
+			const __m256 z = _mm256_loadu_ps(centerZ + i);
+			const __m256 negativeRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(radius + i));
+
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+			for (uint32_t p = 0; p < PLANE_COUNT; p++)
+			{
+				__m256 distance = _mm256_fmadd_ps(planeX[p], x, planeW[p]);
+				distance = _mm256_fmadd_ps(planeY[p], y, distance);
+				distance = _mm256_fmadd_ps(planeZ[p], z, distance);
+
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+			}
+
+			uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+
+			if (mask == 0)
+			{
+				continue;
+			}
+
+			// Fully visible blocks are stored as they are, partially visible ones are compacted lane by lane
+			if (mask == 0xFF)
+			{
+				const __m256i indices = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), laneOffsets);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(visible + visibleCount), indices);
+				visibleCount += 8;
+				continue;
+			}
+
+			while (mask != 0)
+			{
+				visible[visibleCount++] = i + LowestSetBit(mask);
+				mask &= mask - 1;
+			}
+		}
+
+		return visibleCount;
+	}
+#else
+	uint32_t VECulling::CullSpheresSSE(const float* planes, const VESphereList& spheres, uint32_t* visible)
+	{
+		return CullSpheresScalar(planes, spheres, visible);
+	}
+
+	uint32_t VECulling::CullSpheresAVX2(const float* planes, const VESphereList& spheres, uint32_t* visible)
+	{
+		return CullSpheresScalar(planes, spheres, visible);
+	}
+#endif
+}
\ No newline at end of file
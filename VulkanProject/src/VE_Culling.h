@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// World space bounding spheres stored as separate arrays, so a SIMD register can load the same
+	// component of 4 or 8 spheres at once. The arrays are padded to a multiple of the widest kernel
+	class VESphereList
+	{
+	public:
+		static constexpr uint32_t PADDING = 8;
+
+		void Clear();
+		void Reserve(uint32_t count);
+
+		// Returns the index of the sphere, which is what the cull kernels write to the visible list
+		uint32_t Add(float x, float y, float z, float radius);
+
+		uint32_t GetCount() const { return m_Count; }
+
+		const float* GetCenterX() const { return m_CenterX.data(); }
+		const float* GetCenterY() const { return m_CenterY.data(); }
+		const float* GetCenterZ() const { return m_CenterZ.data(); }
+		const float* GetRadius() const { return m_Radius.data(); }
+
+	private:
+		std::vector<float> m_CenterX;
+		std::vector<float> m_CenterY;
+		std::vector<float> m_CenterZ;
+		std::vector<float> m_Radius;
+		uint32_t m_Count = 0;
+	};
+
+	// Tests every sphere against six planes (xyz normal pointing inwards, w distance, 24 floats in total)
+	// and writes the indices of the spheres that are at least partially inside into visible, in order
+	class VECulling
+	{
+	public:
+		enum class Path { Scalar, SSE, AVX2 };
+
+		// Widest path the CPU running the program supports
+		static Path GetBestPath();
+		static const char* GetPathName(Path path);
+
+		// Returns the number of visible spheres, visible is resized to match
+		static uint32_t CullSpheres(const float* planes, const VESphereList& spheres, std::vector<uint32_t>& visible);
+		static uint32_t CullSpheres(const float* planes, const VESphereList& spheres, std::vector<uint32_t>& visible, Path path);
+
+	private:
+		static uint32_t CullSpheresScalar(const float* planes, const VESphereList& spheres, uint32_t* visible);
+		static uint32_t CullSpheresSSE(const float* planes, const VESphereList& spheres, uint32_t* visible);
+		static uint32_t CullSpheresAVX2(const float* planes, const VESphereList& spheres, uint32_t* visible);
+	};
+}
\ No newline at end of file
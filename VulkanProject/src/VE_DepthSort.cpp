@@ -0,0 +1,139 @@
+#include "VE_DepthSort.h"
+
+#include <cstring>
+
+namespace VulkanEngine {
+
+	// Below this count an insertion sort beats the histogram passes
+	static constexpr uint32_t INSERTION_SORT_THRESHOLD = 32;
+
+	static constexpr uint32_t RADIX_BITS = 8;
+	static constexpr uint32_t RADIX_SIZE = 1 << RADIX_BITS;
+	static constexpr uint32_t PASS_COUNT = 32 / RADIX_BITS;
+
+	// Maps a float to an unsigned integer with the same ordering: negative floats have every bit flipped
+	// so larger magnitudes sort first, positive floats only have the sign bit set so they sort after them
+	static uint32_t ToSortableKey(float key)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &key, sizeof(bits));
+
+		return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+	}
+
+	void VEDepthSort::Clear()
+	{
+		m_Keys.clear();
+		m_Indices.clear();
+	}
+
+	void VEDepthSort::Reserve(uint32_t count)
+	{
+		m_Keys.reserve(count);
+		m_Indices.reserve(count);
+		m_SwapKeys.reserve(count);
+		m_SwapIndices.reserve(count);
+	}
+
+	void VEDepthSort::Add(float key, uint32_t index)
+	{
+		m_Keys.push_back(ToSortableKey(key));
+		m_Indices.push_back(index);
+	}
+
+	const uint32_t* VEDepthSort::Sort(Order order)
+	{
+		// Back to front sorts the complemented keys ascending, which keeps equal keys in insertion order
+		if (order == Order::BackToFront)
+		{
+			for (uint32_t& key : m_Keys)
+			{
+				key = ~key;
+			}
+		}
+
+		if (m_Keys.size() < INSERTION_SORT_THRESHOLD)
+		{
+			InsertionSort();
+		}
+		else
+		{
+			RadixSort();
+		}
+
+		return m_Indices.data();
+	}
+
+	void VEDepthSort::InsertionSort()
+	{
+		for (size_t i = 1; i < m_Keys.size(); i++)
+		{
+			const uint32_t key = m_Keys[i];
+			const uint32_t index = m_Indices[i];
+
+			size_t j = i;
+
+			while (j > 0 && m_Keys[j - 1] > key)
+			{
+				m_Keys[j] = m_Keys[j - 1];
+				m_Indices[j] = m_Indices[j - 1];
+				j--;
+			}
+
+			m_Keys[j] = key;
+			m_Indices[j] = index;
+		}
+	}
+
+	void VEDepthSort::RadixSort()
+	{
+		const uint32_t count = static_cast<uint32_t>(m_Keys.size());
+
+		m_SwapKeys.resize(count);
+		m_SwapIndices.resize(count);
+
+		// Count every digit of every pass in one read of the keys
+		uint32_t histograms[PASS_COUNT][RADIX_SIZE] = {};
+
+		for (uint32_t key : m_Keys)
+		{
+			for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+			{
+				histograms[pass][(key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1)]++;
+			}
+		}
+
+		for (uint32_t pass = 0; pass < PASS_COUNT; pass++)
+		{
+			uint32_t* histogram = histograms[pass];
+			const uint32_t shift = pass * RADIX_BITS;
+
+			// Every key has the same digit, this pass would not move anything. Distances that are close
+			// together often share their top byte, so this regularly skips a pass
+			if (histogram[(m_Keys[0] >> shift) & (RADIX_SIZE - 1)] == count)
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+
+			for (uint32_t digit = 0; digit < RADIX_SIZE; digit++)
+			{
+				const uint32_t digitCount = histogram[digit];
+				histogram[digit] = offset;
+				offset += digitCount;
+			}
+
+			for (uint32_t i = 0; i < count; i++)
+			{
+				const uint32_t destination = histogram[(m_Keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+
+				m_SwapKeys[destination] = m_Keys[i];
+				m_SwapIndices[destination] = m_Indices[i];
+			}
+
+			m_Keys.swap(m_SwapKeys);
+			m_Indices.swap(m_SwapIndices);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Sorts indices by a float key, such as the squared distance of a sprite to the camera, with an LSD radix sort.
+	// The sort is stable, so equal keys keep the order they were added in, and the arrays are kept between
+	// frames, so sorting allocates nothing once they have grown to the largest count seen
+	class VEDepthSort
+	{
+	public:
+		enum class Order { FrontToBack, BackToFront };
+
+		void Clear();
+		void Reserve(uint32_t count);
+
+		void Add(float key, uint32_t index);
+
+		uint32_t GetCount() const { return static_cast<uint32_t>(m_Keys.size()); }
+
+		// Returns the added indices ordered by key, valid until the next Clear or Add. Sorts once per Clear
+		const uint32_t* Sort(Order order);
+
+	private:
+		void InsertionSort();
+		void RadixSort();
+
+	private:
+		std::vector<uint32_t> m_Keys;
+		std::vector<uint32_t> m_Indices;
+
+		// Second pair of arrays the radix passes ping pong with
+		std::vector<uint32_t> m_SwapKeys;
+		std::vector<uint32_t> m_SwapIndices;
+	};
+}
\ No newline at end of file
@@ -1,7 +1,10 @@
 #include "VE_Device.h"
 
 // std headers
+#include <chrono>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -19,6 +22,19 @@ namespace VulkanEngine {
         return VK_FALSE;
     }
 
+    // FNV-1a over the pipeline cache data, enough to catch a corrupt or truncated file
+    static uint64_t GetPipelineCacheChecksum(const char* data, size_t size)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+
     VkResult CreateDebugUtilsMessengerEXT(VkInstance instance,
         const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo,
         const VkAllocationCallbacks* pAllocator,
@@ -56,10 +72,23 @@ namespace VulkanEngine {
         PickPhysicalDevice();
         CreateLogicalDevice();
         CreateCommandPool();
+        CreatePipelineCache();
+
+        m_Allocator = std::make_unique<VEDeviceAllocator>(m_Device, m_PhysicalDevice, m_Properties.limits);
     }
 
     VEDevice::~VEDevice()
     {
+        m_Allocator.reset();
+
+        SavePipelineCache();
+        vkDestroyPipelineCache(m_Device, m_PipelineCache, nullptr);
+
+        if (m_TransferCommandPool != m_CommandPool)
+        {
+            vkDestroyCommandPool(m_Device, m_TransferCommandPool, nullptr);
+        }
+
         vkDestroyCommandPool(m_Device, m_CommandPool, nullptr);
         vkDestroyDevice(m_Device, nullptr);
 
@@ -68,7 +97,11 @@ namespace VulkanEngine {
             DestroyDebugUtilsMessengerEXT(m_Instance, m_DebugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+        if (m_Surface != VK_NULL_HANDLE)
+        {
+            vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
+        }
+
         vkDestroyInstance(m_Instance, nullptr);
     }
 
@@ -153,14 +186,16 @@ namespace VulkanEngine {
 
         vkGetPhysicalDeviceProperties(m_PhysicalDevice, &m_Properties);
         std::cout << "physical device: " << m_Properties.deviceName << std::endl;
+
+        m_QueueFamilies = FindQueueFamilies(m_PhysicalDevice);
     }
 
     void VEDevice::CreateLogicalDevice() 
     {
-        QueueFamilyIndices indices = FindQueueFamilies(m_PhysicalDevice);
+        QueueFamilyIndices indices = m_QueueFamilies;
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily };
+        std::set<uint32_t> uniqueQueueFamilies = { indices.GraphicsFamily, indices.PresentFamily, indices.TransferFamily, indices.ComputeFamily };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -174,10 +209,19 @@ namespace VulkanEngine {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
 
         deviceFeatures.samplerAnisotropy = VK_TRUE;
 
+        // Used by the indirect draw path, which falls back to direct draws without them
+        deviceFeatures.multiDrawIndirect                        = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance                = supportedFeatures.drawIndirectFirstInstance;
+
+        m_EnabledFeatures = deviceFeatures;
+
         VkDeviceCreateInfo createInfo = {};
 
         createInfo.sType                                        = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -185,9 +229,11 @@ namespace VulkanEngine {
         createInfo.queueCreateInfoCount                         = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos                            = queueCreateInfos.data();
 
+        auto deviceExtensions                                   = GetRequiredDeviceExtensions();
+
         createInfo.pEnabledFeatures                             = &deviceFeatures;
-        createInfo.enabledExtensionCount                        = static_cast<uint32_t>(m_DeviceExtensions.size());
-        createInfo.ppEnabledExtensionNames                      = m_DeviceExtensions.data();
+        createInfo.enabledExtensionCount                        = static_cast<uint32_t>(deviceExtensions.size());
+        createInfo.ppEnabledExtensionNames                      = deviceExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -208,26 +254,178 @@ namespace VulkanEngine {
 
         vkGetDeviceQueue(m_Device, indices.GraphicsFamily, 0, &m_GraphicsQueue);
         vkGetDeviceQueue(m_Device, indices.PresentFamily, 0, &m_PresentQueue);
+        vkGetDeviceQueue(m_Device, indices.TransferFamily, 0, &m_TransferQueue);
+        vkGetDeviceQueue(m_Device, indices.ComputeFamily, 0, &m_ComputeQueue);
     }
 
     void VEDevice::CreateCommandPool() 
     {
-        QueueFamilyIndices queueFamilyIndices = FindPhysicalQueueFamilies();
+        m_CommandPool = CreateCommandPool(m_QueueFamilies.GraphicsFamily);
 
+        // Without a dedicated transfer family the transfer queue is the graphics queue, so the pool can be shared
+        m_TransferCommandPool = m_QueueFamilies.HasDedicatedTransferFamily()
+            ? CreateCommandPool(m_QueueFamilies.TransferFamily)
+            : m_CommandPool;
+    }
+
+    VkCommandPool VEDevice::CreateCommandPool(uint32_t queueFamily)
+    {
         VkCommandPoolCreateInfo poolInfo = {};
 
         poolInfo.sType                                          = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        poolInfo.queueFamilyIndex                               = queueFamilyIndices.GraphicsFamily;
+        poolInfo.queueFamilyIndex                               = queueFamily;
         poolInfo.flags                                          = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
-        if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &m_CommandPool) != VK_SUCCESS) 
+        VkCommandPool commandPool;
+
+        if (vkCreateCommandPool(m_Device, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) 
         {
             throw std::runtime_error("failed to create command pool!");
         }
+
+        return commandPool;
+    }
+
+    void VEDevice::CreatePipelineCache()
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<char> initialData = LoadPipelineCacheData();
+
+        VkPipelineCacheCreateInfo cacheInfo = {};
+
+        cacheInfo.sType                                         = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize                               = initialData.size();
+        cacheInfo.pInitialData                                  = initialData.empty() ? nullptr : initialData.data();
+
+        if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+        {
+            // The data passed the header checks but the driver still refused it, start over with an empty cache
+            cacheInfo.initialDataSize                           = 0;
+            cacheInfo.pInitialData                              = nullptr;
+
+            if (vkCreatePipelineCache(m_Device, &cacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline cache!");
+            }
+
+            initialData.clear();
+        }
+
+        m_PipelineCacheWarm = !initialData.empty();
+
+        float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+        std::cout << "pipeline cache: " << (m_PipelineCacheWarm ? "warm, " : "cold, ")
+            << initialData.size() / 1024 << " KiB loaded in " << loadTime << " ms" << std::endl;
+    }
+
+    std::vector<char> VEDevice::LoadPipelineCacheData()
+    {
+        std::ifstream file(PIPELINE_CACHE_PATH, std::ios::binary);
+
+        if (!file.is_open())
+        {
+            return {};
+        }
+
+        std::error_code error;
+        const uintmax_t fileSize = std::filesystem::file_size(PIPELINE_CACHE_PATH, error);
+
+        PipelineCacheFileHeader header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(PipelineCacheFileHeader));
+
+        // DataSize is checked against the file before anything is allocated for it
+        if (error ||
+            !file.good() ||
+            header.Magic != PipelineCacheFileHeader::MAGIC ||
+            header.DataSize != fileSize - sizeof(PipelineCacheFileHeader))
+        {
+            std::cout << "pipeline cache: discarding " << PIPELINE_CACHE_PATH << ", it is truncated or corrupt" << std::endl;
+            return {};
+        }
+
+        // Anything built by another driver, device or version of the format is thrown away
+        if (header.Version != PipelineCacheFileHeader::VERSION ||
+            header.VendorID != m_Properties.vendorID ||
+            header.DeviceID != m_Properties.deviceID ||
+            header.DriverVersion != m_Properties.driverVersion ||
+            memcmp(header.PipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+        {
+            std::cout << "pipeline cache: discarding " << PIPELINE_CACHE_PATH << ", it was written for a different device, driver or format" << std::endl;
+            return {};
+        }
+
+        std::vector<char> data(static_cast<size_t>(header.DataSize));
+        file.read(data.data(), data.size());
+
+        if (static_cast<uint64_t>(file.gcount()) != header.DataSize ||
+            GetPipelineCacheChecksum(data.data(), data.size()) != header.DataChecksum)
+        {
+            std::cout << "pipeline cache: discarding " << PIPELINE_CACHE_PATH << ", it is truncated or corrupt" << std::endl;
+            return {};
+        }
+
+        return data;
+    }
+
+    void VEDevice::SavePipelineCache()
+    {
+        size_t dataSize = 0;
+
+        if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0)
+        {
+            return;
+        }
+
+        std::vector<char> data(dataSize);
+
+        if (vkGetPipelineCacheData(m_Device, m_PipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+        {
+            return;
+        }
+
+        PipelineCacheFileHeader header;
+
+        header.VendorID                                         = m_Properties.vendorID;
+        header.DeviceID                                         = m_Properties.deviceID;
+        header.DriverVersion                                    = m_Properties.driverVersion;
+        header.DataSize                                         = dataSize;
+        header.DataChecksum                                     = GetPipelineCacheChecksum(data.data(), dataSize);
+        memcpy(header.PipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+        // Write to a temporary file first so a crash while saving never leaves a truncated cache behind
+        const std::string tempPath = std::string(PIPELINE_CACHE_PATH) + ".tmp";
+
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+            file.write(reinterpret_cast<const char*>(&header), sizeof(PipelineCacheFileHeader));
+            file.write(data.data(), dataSize);
+
+            if (!file.good())
+            {
+                std::cerr << "failed to write pipeline cache: " << tempPath << std::endl;
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, PIPELINE_CACHE_PATH, error);
+
+        if (error)
+        {
+            std::cerr << "failed to write pipeline cache: " << PIPELINE_CACHE_PATH << " (" << error.message() << ")" << std::endl;
+            std::filesystem::remove(tempPath, error);
+        }
     }
 
     void VEDevice::CreateSurface() 
     {
+        if (IsHeadless())
+        {
+            return;
+        }
+
         m_Window.CreateWindowSurface(m_Instance, &m_Surface);
     }
 
@@ -237,7 +435,12 @@ namespace VulkanEngine {
         bool extensionsSupported                                = CheckDeviceExtensionSupport(device);
         bool SwapChainAdequate                                  = false;
 
-        if (extensionsSupported) 
+        // Offscreen rendering needs no swap chain
+        if (IsHeadless())
+        {
+            SwapChainAdequate                                   = true;
+        }
+        else if (extensionsSupported) 
         {
             SwapChainSupportDetails SwapChainSupport            = QuerySwapChainSupport(device);
             SwapChainAdequate                                   = !SwapChainSupport.Formats.empty() && !SwapChainSupport.PresentModes.empty();
@@ -306,12 +509,17 @@ namespace VulkanEngine {
 
     std::vector<const char*> VEDevice::GetRequiredExtensions() 
     {
-        uint32_t glfwExtensionCount = 0;
-        const char** glfwExtensions;
+        std::vector<const char*> extensions;
 
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+        if (!IsHeadless())
+        {
+            uint32_t glfwExtensionCount = 0;
+            const char** glfwExtensions;
 
-        std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (EnableValidationLayers) 
         {
@@ -321,6 +529,16 @@ namespace VulkanEngine {
         return extensions;
     }
 
+    std::vector<const char*> VEDevice::GetRequiredDeviceExtensions()
+    {
+        if (IsHeadless())
+        {
+            return {};
+        }
+
+        return m_DeviceExtensions;
+    }
+
     void VEDevice::HasGflwRequiredInstanceExtensions() 
     {
         uint32_t extensionCount = 0;
@@ -360,7 +578,8 @@ namespace VulkanEngine {
         std::vector<VkExtensionProperties> availableExtensions(extensionCount);
         vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(m_DeviceExtensions.begin(), m_DeviceExtensions.end());
+        auto deviceExtensions = GetRequiredDeviceExtensions();
+        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
 
         for (const auto& extension : availableExtensions) 
         {
@@ -389,8 +608,17 @@ namespace VulkanEngine {
                 indices.GraphicsFamilyHasValue = true;
             }
 
+            // Headless frames are never presented, the graphics family is used in place of a present family
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface, &presentSupport);
+
+            if (IsHeadless())
+            {
+                presentSupport = indices.GraphicsFamilyHasValue && indices.GraphicsFamily == static_cast<uint32_t>(i);
+            }
+            else
+            {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Surface, &presentSupport);
+            }
 
             if (queueFamily.queueCount > 0 && presentSupport) 
             {
@@ -406,6 +634,46 @@ namespace VulkanEngine {
             i++;
         }
 
+        if (!indices.IsComplete())
+        {
+            return indices;
+        }
+
+        indices.TransferFamily  = indices.GraphicsFamily;
+        indices.ComputeFamily   = indices.GraphicsFamily;
+
+        // Prefer families that can't do graphics: a transfer only family is usually backed by the copy engines,
+        // and a compute family without graphics runs asynchronously next to rendering
+        int transferScore = 0;
+        int computeScore = 0;
+
+        for (uint32_t family = 0; family < queueFamilyCount; family++)
+        {
+            const VkQueueFlags flags = queueFamilies[family].queueFlags;
+
+            if (queueFamilies[family].queueCount == 0 || (flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                continue;
+            }
+
+            if (flags & VK_QUEUE_TRANSFER_BIT)
+            {
+                const int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+
+                if (score > transferScore)
+                {
+                    indices.TransferFamily = family;
+                    transferScore = score;
+                }
+            }
+
+            if ((flags & VK_QUEUE_COMPUTE_BIT) && computeScore == 0)
+            {
+                indices.ComputeFamily = family;
+                computeScore = 1;
+            }
+        }
+
         return indices;
     }
 
@@ -475,7 +743,7 @@ namespace VulkanEngine {
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
-    void VEDevice::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& bufferMemory) 
+    void VEDevice::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VEAllocation& bufferAllocation) 
     {
         VkBufferCreateInfo bufferInfo = {};
 
@@ -492,27 +760,45 @@ namespace VulkanEngine {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(m_Device, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo = {};
-
-        allocInfo.sType                                         = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize                                = memRequirements.size;
-        allocInfo.memoryTypeIndex                               = FindMemoryType(memRequirements.memoryTypeBits, properties);
+        // Buffers share large memory blocks instead of each getting their own vkAllocateMemory
+        try
+        {
+            bufferAllocation = m_Allocator->Allocate(memRequirements, FindMemoryType(memRequirements.memoryTypeBits, properties));
+        }
+        catch (...)
+        {
+            vkDestroyBuffer(m_Device, buffer, nullptr);
+            buffer = VK_NULL_HANDLE;
+            throw;
+        }
 
-        if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS)
+        // Nothing owns the buffer or its memory until this returns, so a failed bind has to release both
+        if (vkBindBufferMemory(m_Device, buffer, bufferAllocation.Memory, bufferAllocation.Offset) != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+            DestroyBuffer(buffer, bufferAllocation);
+            buffer = VK_NULL_HANDLE;
+            throw std::runtime_error("failed to bind vertex buffer memory!");
         }
+    }
 
-        vkBindBufferMemory(m_Device, buffer, bufferMemory, 0);
+    void VEDevice::DestroyBuffer(VkBuffer buffer, VEAllocation& bufferAllocation)
+    {
+        vkDestroyBuffer(m_Device, buffer, nullptr);
+        m_Allocator->Free(bufferAllocation);
     }
 
     VkCommandBuffer VEDevice::BeginSingleTimeCommands()
+    {
+        return BeginSingleTimeCommands(m_CommandPool);
+    }
+
+    VkCommandBuffer VEDevice::BeginSingleTimeCommands(VkCommandPool commandPool)
     {
         VkCommandBufferAllocateInfo allocInfo = {};
 
         allocInfo.sType                                         = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level                                         = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool                                   = m_CommandPool;
+        allocInfo.commandPool                                   = commandPool;
         allocInfo.commandBufferCount                            = 1;
 
         VkCommandBuffer commandBuffer;
@@ -543,24 +829,121 @@ namespace VulkanEngine {
         vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &commandBuffer);
     }
 
-    void VEDevice::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
+    void VEDevice::EndTransferCommands(VkCommandBuffer transferCommands, const VkBufferMemoryBarrier* bufferBarrier, const VkImageMemoryBarrier* imageBarrier)
+    {
+        if (!m_QueueFamilies.HasDedicatedTransferFamily())
+        {
+            EndSingleTimeCommands(transferCommands);
+            return;
+        }
+
+        // Release the destination from the transfer family...
+        vkCmdPipelineBarrier(transferCommands,
+            VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+            0, nullptr,
+            bufferBarrier ? 1 : 0, bufferBarrier,
+            imageBarrier ? 1 : 0, imageBarrier);
+
+        vkEndCommandBuffer(transferCommands);
+
+        // ...and acquire it on the graphics family with the same barrier once the copy is done
+        VkCommandBuffer acquireCommands = BeginSingleTimeCommands(m_CommandPool);
+
+        vkCmdPipelineBarrier(acquireCommands,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+            0, nullptr,
+            bufferBarrier ? 1 : 0, bufferBarrier,
+            imageBarrier ? 1 : 0, imageBarrier);
+
+        vkEndCommandBuffer(acquireCommands);
+
+        VkSemaphoreCreateInfo semaphoreInfo = {};
+        semaphoreInfo.sType                                     = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+        auto freeCommandBuffers = [&]()
+        {
+            vkFreeCommandBuffers(m_Device, m_TransferCommandPool, 1, &transferCommands);
+            vkFreeCommandBuffers(m_Device, m_CommandPool, 1, &acquireCommands);
+        };
+
+        VkSemaphore transferComplete;
+
+        if (vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &transferComplete) != VK_SUCCESS)
+        {
+            freeCommandBuffers();
+            throw std::runtime_error("failed to create transfer semaphore!");
+        }
+
+        VkSubmitInfo transferSubmit = {};
+
+        transferSubmit.sType                                    = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        transferSubmit.commandBufferCount                       = 1;
+        transferSubmit.pCommandBuffers                          = &transferCommands;
+        transferSubmit.signalSemaphoreCount                     = 1;
+        transferSubmit.pSignalSemaphores                        = &transferComplete;
+
+        VkPipelineStageFlags waitStage                          = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+
+        VkSubmitInfo acquireSubmit = {};
+
+        acquireSubmit.sType                                     = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireSubmit.waitSemaphoreCount                        = 1;
+        acquireSubmit.pWaitSemaphores                           = &transferComplete;
+        acquireSubmit.pWaitDstStageMask                         = &waitStage;
+        acquireSubmit.commandBufferCount                        = 1;
+        acquireSubmit.pCommandBuffers                           = &acquireCommands;
+
+        if (vkQueueSubmit(m_TransferQueue, 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            vkDestroySemaphore(m_Device, transferComplete, nullptr);
+            freeCommandBuffers();
+            throw std::runtime_error("failed to submit transfer command buffer!");
+        }
+
+        if (vkQueueSubmit(m_GraphicsQueue, 1, &acquireSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+        {
+            // The transfer is already in flight and signals the semaphore
+            vkQueueWaitIdle(m_TransferQueue);
+            vkDestroySemaphore(m_Device, transferComplete, nullptr);
+            freeCommandBuffers();
+            throw std::runtime_error("failed to submit queue ownership acquire command buffer!");
+        }
+
+        vkQueueWaitIdle(m_GraphicsQueue);
+
+        vkDestroySemaphore(m_Device, transferComplete, nullptr);
+        freeCommandBuffers();
+    }
+
+    void VEDevice::CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset)
     {
-        VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+        VkCommandBuffer commandBuffer = BeginSingleTimeCommands(m_TransferCommandPool);
 
         VkBufferCopy copyRegion = {};
 
         copyRegion.srcOffset                                    = 0;  // Optional
-        copyRegion.dstOffset                                    = 0;  // Optional
+        copyRegion.dstOffset                                    = dstOffset;
         copyRegion.size                                         = size;
 
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
-        EndSingleTimeCommands(commandBuffer);
+        VkBufferMemoryBarrier barrier = {};
+
+        barrier.sType                                           = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask                                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask                                   = VK_ACCESS_MEMORY_READ_BIT;
+        barrier.srcQueueFamilyIndex                             = m_QueueFamilies.TransferFamily;
+        barrier.dstQueueFamilyIndex                             = m_QueueFamilies.GraphicsFamily;
+        barrier.buffer                                          = dstBuffer;
+        barrier.offset                                          = dstOffset;
+        barrier.size                                            = size;
+
+        EndTransferCommands(commandBuffer, &barrier, nullptr);
     }
 
     void VEDevice::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount)
     {
-        VkCommandBuffer commandBuffer = BeginSingleTimeCommands();
+        VkCommandBuffer commandBuffer = BeginSingleTimeCommands(m_TransferCommandPool);
 
         VkBufferImageCopy region = {};
         region.bufferOffset                                     = 0;
@@ -583,7 +966,24 @@ namespace VulkanEngine {
             1,
             &region);
 
-        EndSingleTimeCommands(commandBuffer);
+        // The image stays in TRANSFER_DST_OPTIMAL, the caller transitions it for sampling as before
+        VkImageMemoryBarrier barrier = {};
+
+        barrier.sType                                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask                                   = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask                                   = VK_ACCESS_MEMORY_READ_BIT;
+        barrier.oldLayout                                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout                                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex                             = m_QueueFamilies.TransferFamily;
+        barrier.dstQueueFamilyIndex                             = m_QueueFamilies.GraphicsFamily;
+        barrier.image                                           = image;
+        barrier.subresourceRange.aspectMask                     = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel                   = 0;
+        barrier.subresourceRange.levelCount                     = 1;
+        barrier.subresourceRange.baseArrayLayer                 = 0;
+        barrier.subresourceRange.layerCount                     = layerCount;
+
+        EndTransferCommands(commandBuffer, nullptr, &barrier);
     }
 
     void VEDevice::CreateImageWithInfo(const VkImageCreateInfo& imageInfo, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory) 
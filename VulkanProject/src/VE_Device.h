@@ -1,9 +1,11 @@
 #pragma once
 #pragma once
 
+#include "VE_DeviceAllocator.h"
 #include "VE_Window.h"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -21,6 +23,28 @@ namespace VulkanEngine {
         bool GraphicsFamilyHasValue = false;
         bool PresentFamilyHasValue = false;
         bool IsComplete() { return GraphicsFamilyHasValue && PresentFamilyHasValue; }
+
+        // Transfer and compute fall back to the graphics family when the device has no dedicated family for them
+        uint32_t TransferFamily;
+        uint32_t ComputeFamily;
+        bool HasDedicatedTransferFamily() { return TransferFamily != GraphicsFamily; }
+        bool HasDedicatedComputeFamily() { return ComputeFamily != GraphicsFamily; }
+    };
+
+    // Prefixed to the driver's pipeline cache data on disk. The driver rejects mismatching data as well,
+    // but checking here means a stale file is never handed to it
+    struct PipelineCacheFileHeader {
+        static constexpr uint32_t MAGIC = 0x43505556; // "VUPC"
+        static constexpr uint32_t VERSION = 2; // 2: checksum of the data
+
+        uint32_t Magic = MAGIC;
+        uint32_t Version = VERSION;
+        uint32_t VendorID = 0;
+        uint32_t DeviceID = 0;
+        uint32_t DriverVersion = 0;
+        uint8_t PipelineCacheUUID[VK_UUID_SIZE] = {};
+        uint64_t DataSize = 0;
+        uint64_t DataChecksum = 0;
     };
 
     class VEDevice {
@@ -41,14 +65,27 @@ namespace VulkanEngine {
         VEDevice& operator=(VEDevice&&) = delete;
 
         VkCommandPool GetCommandPool() { return m_CommandPool; }
+        VkCommandPool GetTransferCommandPool() { return m_TransferCommandPool; }
         VkDevice Device() { return m_Device; }
         VkSurfaceKHR Surface() { return m_Surface; }
+
+        // Without a window there is no surface or swap chain, and the graphics queue stands in for presentation
+        bool IsHeadless() const { return m_Window.IsHeadless(); }
         VkQueue GraphicsQueue() { return m_GraphicsQueue; }
         VkQueue PresentQueue() { return m_PresentQueue; }
+        VkQueue TransferQueue() { return m_TransferQueue; }
+        VkQueue ComputeQueue() { return m_ComputeQueue; }
+        VEDeviceAllocator& GetAllocator() { return *m_Allocator; }
+
+        // Shared by every pipeline, loaded from PIPELINE_CACHE_PATH on startup and written back on destruction
+        static constexpr const char* PIPELINE_CACHE_PATH = "pipeline_cache.bin";
+        VkPipelineCache GetPipelineCache() { return m_PipelineCache; }
+        bool IsPipelineCacheWarm() { return m_PipelineCacheWarm; }
+        void SavePipelineCache();
 
         SwapChainSupportDetails GetSwapChainSupport() { return QuerySwapChainSupport(m_PhysicalDevice); }
         uint32_t FindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
-        QueueFamilyIndices FindPhysicalQueueFamilies() { return FindQueueFamilies(m_PhysicalDevice); }
+        QueueFamilyIndices FindPhysicalQueueFamilies() { return m_QueueFamilies; }
         VkFormat FindSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
         // Buffer Helper Functions
@@ -57,10 +94,14 @@ namespace VulkanEngine {
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            VEAllocation& bufferAllocation);
+        void DestroyBuffer(VkBuffer buffer, VEAllocation& bufferAllocation);
         VkCommandBuffer BeginSingleTimeCommands();
         void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+
+        // Copies run on the transfer queue. When it belongs to a different family than the graphics queue,
+        // ownership of the destination is released by the transfer queue and acquired by the graphics queue
+        void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize dstOffset = 0);
         void CopyBufferToImage(
             VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -70,6 +111,9 @@ namespace VulkanEngine {
             VkImage& image,
             VkDeviceMemory& imageMemory);
 
+        // Optional features are only enabled when the physical device supports them
+        const VkPhysicalDeviceFeatures& GetEnabledFeatures() const { return m_EnabledFeatures; }
+
         VkPhysicalDeviceProperties m_Properties;
 
     private:
@@ -79,10 +123,18 @@ namespace VulkanEngine {
         void PickPhysicalDevice();
         void CreateLogicalDevice();
         void CreateCommandPool();
+        void CreatePipelineCache();
+        std::vector<char> LoadPipelineCacheData();
+        VkCommandPool CreateCommandPool(uint32_t queueFamily);
+        VkCommandBuffer BeginSingleTimeCommands(VkCommandPool commandPool);
+        void EndTransferCommands(VkCommandBuffer transferCommands,
+            const VkBufferMemoryBarrier* bufferBarrier,
+            const VkImageMemoryBarrier* imageBarrier);
 
         // helper functions
         bool IsDeviceSuitable(VkPhysicalDevice device);
         std::vector<const char*> GetRequiredExtensions();
+        std::vector<const char*> GetRequiredDeviceExtensions();
         bool CheckValidationLayerSupport();
         QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device);
         void PopulateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
@@ -96,11 +148,19 @@ namespace VulkanEngine {
         VkPhysicalDevice m_PhysicalDevice = VK_NULL_HANDLE;
         VEWindow& m_Window;
         VkCommandPool m_CommandPool;
+        VkCommandPool m_TransferCommandPool;
+        QueueFamilyIndices m_QueueFamilies;
+        VkPipelineCache m_PipelineCache = VK_NULL_HANDLE;
+        bool m_PipelineCacheWarm = false;
+        VkPhysicalDeviceFeatures m_EnabledFeatures = {};
+        std::unique_ptr<VEDeviceAllocator> m_Allocator;
 
         VkDevice m_Device;
-        VkSurfaceKHR m_Surface;
+        VkSurfaceKHR m_Surface = VK_NULL_HANDLE;
         VkQueue m_GraphicsQueue;
         VkQueue m_PresentQueue;
+        VkQueue m_TransferQueue;
+        VkQueue m_ComputeQueue;
 
         const std::vector<const char*> m_ValidationLayers = { "VK_LAYER_KHRONOS_validation" };
         const std::vector<const char*> m_DeviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
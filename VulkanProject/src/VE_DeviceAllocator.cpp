@@ -0,0 +1,234 @@
+#include "VE_DeviceAllocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace VulkanEngine {
+
+	VEDeviceAllocator::VEDeviceAllocator(VkDevice device, VkPhysicalDevice physicalDevice, const VkPhysicalDeviceLimits& limits)
+		: m_Device{ device }, m_NonCoherentAtomSize{ limits.nonCoherentAtomSize }
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_MemoryProperties);
+		m_BlockLists.resize(m_MemoryProperties.memoryTypeCount);
+		m_Blocks.resize(m_MemoryProperties.memoryTypeCount);
+	}
+
+	VEDeviceAllocator::~VEDeviceAllocator()
+	{
+		for (uint32_t memoryType = 0; memoryType < m_Blocks.size(); memoryType++)
+		{
+			for (uint32_t i = 0; i < m_Blocks[memoryType].size(); i++)
+			{
+				if (m_Blocks[memoryType][i].Memory != VK_NULL_HANDLE)
+				{
+					assert(m_BlockLists[memoryType]->GetBlock(i)->IsEmpty() && "Destroying the allocator while buffers are still alive.");
+					vkFreeMemory(m_Device, m_Blocks[memoryType][i].Memory, nullptr);
+				}
+			}
+		}
+	}
+
+	VEAllocation VEDeviceAllocator::Allocate(const VkMemoryRequirements& requirements, uint32_t memoryType)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		VkDeviceSize size = requirements.size;
+		VkDeviceSize alignment = requirements.alignment;
+
+		// Keep non coherent allocations on their own atoms so flushing one never touches a neighbour
+		if (IsHostVisible(memoryType) && !IsHostCoherent(memoryType))
+		{
+			alignment = std::max(alignment, m_NonCoherentAtomSize);
+			size = (size + m_NonCoherentAtomSize - 1) / m_NonCoherentAtomSize * m_NonCoherentAtomSize;
+		}
+
+		VEAllocation allocation = {};
+		allocation.MemoryType = memoryType;
+
+		const VkDeviceSize blockSize = GetBlockSize(memoryType);
+
+		if (size > blockSize / 2)
+		{
+			allocation.Memory		= AllocateMemory(requirements.size, memoryType, &allocation.Mapped);
+			allocation.Offset		= 0;
+			allocation.Size			= requirements.size;
+			allocation.Dedicated	= true;
+
+			m_DedicatedBytes += requirements.size;
+			m_DedicatedCount++;
+
+			return allocation;
+		}
+
+		auto& blockList = m_BlockLists[memoryType];
+
+		if (blockList == nullptr)
+		{
+			blockList = std::make_unique<VEBuddyBlockList>(blockSize, MIN_BLOCK_SIZE);
+		}
+
+		uint32_t blockIndex = 0;
+		uint64_t offset = 0;
+
+		// None of the existing blocks has room, back a new one with memory. The memory is allocated first so a
+		// failure leaves the list untouched
+		if (!blockList->Allocate(size, alignment, blockIndex, offset))
+		{
+			Block block = {};
+			block.Memory = AllocateMemory(blockSize, memoryType, &block.Mapped);
+
+			const uint32_t newIndex = blockList->AddBlock();
+			auto& blocks = m_Blocks[memoryType];
+
+			if (newIndex >= blocks.size())
+			{
+				blocks.resize(newIndex + 1);
+			}
+
+			blocks[newIndex] = block;
+
+			if (!blockList->Allocate(size, alignment, blockIndex, offset))
+			{
+				throw std::runtime_error("allocation does not fit in an empty block!");
+			}
+		}
+
+		const Block& block = m_Blocks[memoryType][blockIndex];
+
+		allocation.Memory		= block.Memory;
+		allocation.Offset		= offset;
+		allocation.Size			= size;
+		allocation.Mapped		= block.Mapped ? static_cast<char*>(block.Mapped) + offset : nullptr;
+		allocation.BlockIndex	= blockIndex;
+
+		return allocation;
+	}
+
+	void VEDeviceAllocator::Free(VEAllocation& allocation)
+	{
+		if (allocation.Memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (allocation.Dedicated)
+		{
+			// Freeing mapped memory implicitly unmaps it
+			vkFreeMemory(m_Device, allocation.Memory, nullptr);
+
+			m_DedicatedBytes -= allocation.Size;
+			m_DedicatedCount--;
+		}
+		else
+		{
+			// Empty blocks go back to the driver
+			if (m_BlockLists[allocation.MemoryType]->Free(allocation.BlockIndex, allocation.Offset))
+			{
+				Block& block = m_Blocks[allocation.MemoryType][allocation.BlockIndex];
+				vkFreeMemory(m_Device, block.Memory, nullptr);
+
+				block = {};
+			}
+		}
+
+		allocation = {};
+	}
+
+	VEDeviceAllocator::Stats VEDeviceAllocator::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Stats stats = {};
+
+		stats.BytesReserved		= m_DedicatedBytes;
+		stats.BytesUsed			= m_DedicatedBytes;
+		stats.DedicatedCount	= m_DedicatedCount;
+		stats.AllocationCount	= m_DedicatedCount;
+
+		VkDeviceSize blockBytes = 0;
+
+		for (const auto& blockList : m_BlockLists)
+		{
+			if (blockList == nullptr)
+			{
+				continue;
+			}
+
+			for (uint32_t i = 0; i < blockList->GetSlotCount(); i++)
+			{
+				if (blockList->GetBlock(i) == nullptr)
+				{
+					continue;
+				}
+
+				auto blockStats = blockList->GetBlock(i)->GetStats();
+
+				stats.BytesReserved		+= blockStats.Capacity;
+				stats.BytesUsed			+= blockStats.BytesRequested;
+				stats.AllocationCount	+= blockStats.AllocationCount;
+				stats.BlockCount		+= 1;
+				stats.Fragmentation		+= blockStats.Fragmentation() * static_cast<float>(blockStats.Capacity);
+
+				blockBytes += blockStats.Capacity;
+			}
+		}
+
+		if (blockBytes > 0)
+		{
+			stats.Fragmentation /= static_cast<float>(blockBytes);
+		}
+
+		return stats;
+	}
+
+	VkDeviceMemory VEDeviceAllocator::AllocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped)
+	{
+		VkMemoryAllocateInfo allocInfo = {};
+
+		allocInfo.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize	= size;
+		allocInfo.memoryTypeIndex	= memoryType;
+
+		VkDeviceMemory memory;
+
+		if (vkAllocateMemory(m_Device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			throw std::runtime_error("failed to allocate device memory!");
+		}
+
+		*mapped = nullptr;
+
+		// Host visible memory stays mapped for its whole lifetime, buffers just hand out pointers into it
+		if (IsHostVisible(memoryType) && vkMapMemory(m_Device, memory, 0, VK_WHOLE_SIZE, 0, mapped) != VK_SUCCESS)
+		{
+			vkFreeMemory(m_Device, memory, nullptr);
+			throw std::runtime_error("failed to map device memory!");
+		}
+
+		return memory;
+	}
+
+	VkDeviceSize VEDeviceAllocator::GetBlockSize(uint32_t memoryType) const
+	{
+		// Small heaps (such as host visible device local memory) get smaller blocks so one block can't exhaust them
+		const uint32_t heapIndex = m_MemoryProperties.memoryTypes[memoryType].heapIndex;
+		const VkDeviceSize heapSize = m_MemoryProperties.memoryHeaps[heapIndex].size;
+
+		const VkDeviceSize blockSize = std::max(std::min(DEFAULT_BLOCK_SIZE, heapSize / 8), MIN_BLOCK_SIZE);
+
+		return 1ull << VEBuddyAllocator::Log2(blockSize);
+	}
+
+	bool VEDeviceAllocator::IsHostVisible(uint32_t memoryType) const
+	{
+		return (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	}
+
+	bool VEDeviceAllocator::IsHostCoherent(uint32_t memoryType) const
+	{
+		return (m_MemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	}
+}
\ No newline at end of file
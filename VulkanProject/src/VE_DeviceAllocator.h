@@ -0,0 +1,84 @@
+#pragma once
+#include "VE_BuddyAllocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// A range of device memory handed out by VEDeviceAllocator
+	struct VEAllocation
+	{
+		VkDeviceMemory Memory	= VK_NULL_HANDLE;
+		VkDeviceSize Offset		= 0;
+		VkDeviceSize Size		= 0;
+		void* Mapped			= nullptr;	// Persistently mapped pointer to Offset, null for device only memory
+
+		uint32_t MemoryType		= 0;
+		uint32_t BlockIndex		= 0;
+		bool Dedicated			= false;
+	};
+
+	// Sub-allocates buffers out of large per memory type blocks so the number of vkAllocateMemory calls
+	// stays small. Requests too large for a block get a dedicated allocation
+	class VEDeviceAllocator
+	{
+	public:
+		struct Stats
+		{
+			VkDeviceSize BytesReserved		= 0;	// Memory allocated from the driver
+			VkDeviceSize BytesUsed			= 0;	// Memory requested by buffers
+			uint32_t BlockCount				= 0;
+			uint32_t DedicatedCount			= 0;
+			uint32_t AllocationCount		= 0;
+			float Fragmentation				= 0.0f;	// Averaged over the blocks, weighted by their size
+		};
+
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE	= 64ull * 1024 * 1024;
+		static constexpr VkDeviceSize MIN_BLOCK_SIZE		= 256;
+
+		VEDeviceAllocator(VkDevice device, VkPhysicalDevice physicalDevice, const VkPhysicalDeviceLimits& limits);
+		~VEDeviceAllocator();
+
+		// Delete the copy constructor and copy operator
+		VEDeviceAllocator(const VEDeviceAllocator&) = delete;
+		VEDeviceAllocator& operator=(const VEDeviceAllocator&) = delete;
+
+		VEAllocation Allocate(const VkMemoryRequirements& requirements, uint32_t memoryType);
+		void Free(VEAllocation& allocation);
+
+		// Ranges of non coherent memory must be flushed/invalidated at multiples of this
+		VkDeviceSize GetNonCoherentAtomSize() const { return m_NonCoherentAtomSize; }
+
+		Stats GetStats();
+
+	private:
+		// Memory behind one slot of a memory type's block list
+		struct Block
+		{
+			VkDeviceMemory Memory = VK_NULL_HANDLE;
+			void* Mapped = nullptr;
+		};
+
+		VkDeviceMemory AllocateMemory(VkDeviceSize size, uint32_t memoryType, void** mapped);
+		VkDeviceSize GetBlockSize(uint32_t memoryType) const;
+		bool IsHostVisible(uint32_t memoryType) const;
+		bool IsHostCoherent(uint32_t memoryType) const;
+
+	private:
+		VkDevice m_Device;
+		VkPhysicalDeviceMemoryProperties m_MemoryProperties;
+		VkDeviceSize m_NonCoherentAtomSize;
+
+		// Per memory type, the lists are created on first use
+		std::vector<std::unique_ptr<VEBuddyBlockList>> m_BlockLists;
+		std::vector<std::vector<Block>> m_Blocks;
+		VkDeviceSize m_DedicatedBytes = 0;
+		uint32_t m_DedicatedCount = 0;
+
+		std::mutex m_Mutex;
+	};
+}
\ No newline at end of file
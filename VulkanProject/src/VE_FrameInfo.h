@@ -1,16 +1,18 @@
 #pragma once
 #include "VE_Camera.h"
-#include "VE_GameObject.h"
+#include "VE_Scene.h"
 
 #include <vulkan/vulkan.h>
 
 namespace VulkanEngine {
 
-#define MAX_LIGHTS 10
+// Capacity of the per frame light storage buffer, lights past it are not shaded
+#define MAX_LIGHTS 4096
 
+	// Matches PointLight in Simple_Shader.frag
 	struct PointLight
 	{
-		glm::vec4 Position{}; // Ignore w
+		glm::vec4 Position{}; // W is the influence radius
 		glm::vec4 Color{};    // W is the intensity
 	};
 
@@ -21,9 +23,8 @@ namespace VulkanEngine {
 		glm::mat4 ViewMatrix{ 1.0f };
 		glm::mat4 InverseViewMatrix{ 1.0f };
 		glm::vec4 AmbientLightColor{ 1.0f, 1.0f, 1.0f, 0.1f }; // W is the intensity
-		
-		PointLight PointLights[MAX_LIGHTS];
-		int NumLights;
+		glm::vec4 ClusterDepth{};	// Near, far, slice scale, slice bias
+		glm::uvec4 ClusterGrid{};	// Clusters along x, y and z
 	};
 
 	struct FrameInfo
@@ -33,6 +34,6 @@ namespace VulkanEngine {
 		VkCommandBuffer CommandBuffer;
 		VECamera& Camera;
 		VkDescriptorSet GlobalDescriptorSet;
-		VEGameObject::Map& GameObjects;
+		VEScene& Scene;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,119 @@
+#include "VE_Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VulkanEngine {
+
+	VEBoundingBox VEBoundingBox::Transform(const glm::mat4& matrix) const
+	{
+		if (IsEmpty())
+		{
+			return *this;
+		}
+
+		// Transform the center and project the extents onto each world axis (Arvo's method)
+		const glm::vec3 center = glm::vec3(matrix * glm::vec4(GetCenter(), 1.0f));
+		const glm::vec3 extents = GetExtents();
+
+		glm::vec3 worldExtents{};
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			worldExtents[axis] = std::abs(matrix[0][axis]) * extents.x +
+				std::abs(matrix[1][axis]) * extents.y +
+				std::abs(matrix[2][axis]) * extents.z;
+		}
+
+		VEBoundingBox result = {};
+
+		result.Min = center - worldExtents;
+		result.Max = center + worldExtents;
+
+		return result;
+	}
+
+	VEBoundingSphere VEBoundingSphere::Transform(const glm::mat4& matrix) const
+	{
+		const float scaleX = glm::dot(glm::vec3(matrix[0]), glm::vec3(matrix[0]));
+		const float scaleY = glm::dot(glm::vec3(matrix[1]), glm::vec3(matrix[1]));
+		const float scaleZ = glm::dot(glm::vec3(matrix[2]), glm::vec3(matrix[2]));
+
+		VEBoundingSphere result = {};
+
+		result.Center = glm::vec3(matrix * glm::vec4(Center, 1.0f));
+		result.Radius = Radius * std::sqrt(std::max({ scaleX, scaleY, scaleZ }));
+
+		return result;
+	}
+
+	VEFrustum::VEFrustum(const glm::mat4& viewProjection)
+	{
+		// glm matrices are column major, so row i is made of the i-th component of every column
+		auto row = [&viewProjection](int i)
+		{
+			return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		};
+
+		const glm::vec4 row0 = row(0);
+		const glm::vec4 row1 = row(1);
+		const glm::vec4 row2 = row(2);
+		const glm::vec4 row3 = row(3);
+
+		m_Planes[LEFT]			= row3 + row0;
+		m_Planes[RIGHT]			= row3 - row0;
+		m_Planes[BOTTOM]		= row3 + row1;
+		m_Planes[TOP]			= row3 - row1;
+		m_Planes[NEAR_PLANE]	= row2;			// Clip space z starts at 0 rather than -w
+		m_Planes[FAR_PLANE]		= row3 - row2;
+
+		// Normalize so the plane equation gives real distances for the sphere test
+		for (auto& plane : m_Planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	void VEFrustum::GetPlanes(float* planes) const
+	{
+		for (int i = 0; i < PLANE_COUNT; i++)
+		{
+			planes[i * 4 + 0] = m_Planes[i].x;
+			planes[i * 4 + 1] = m_Planes[i].y;
+			planes[i * 4 + 2] = m_Planes[i].z;
+			planes[i * 4 + 3] = m_Planes[i].w;
+		}
+	}
+
+	bool VEFrustum::Intersects(const VEBoundingSphere& sphere) const
+	{
+		for (const auto& plane : m_Planes)
+		{
+			if (glm::dot(glm::vec3(plane), sphere.Center) + plane.w < -sphere.Radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool VEFrustum::Intersects(const VEBoundingBox& box) const
+	{
+		const glm::vec3 center = box.GetCenter();
+		const glm::vec3 extents = box.GetExtents();
+
+		for (const auto& plane : m_Planes)
+		{
+			// Distance of the box's furthest corner along the plane normal
+			const float radius = std::abs(plane.x) * extents.x + std::abs(plane.y) * extents.y + std::abs(plane.z) * extents.z;
+
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
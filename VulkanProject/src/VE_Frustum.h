@@ -0,0 +1,54 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+namespace VulkanEngine {
+
+	// Axis aligned bounding box, empty until a point has been added
+	struct VEBoundingBox
+	{
+		glm::vec3 Min{ 1.0f };
+		glm::vec3 Max{ -1.0f };
+
+		bool IsEmpty() const { return Min.x > Max.x; }
+		glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+		glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+		// Box around the transformed box, so it can be a bit larger than the transformed geometry
+		VEBoundingBox Transform(const glm::mat4& matrix) const;
+	};
+
+	struct VEBoundingSphere
+	{
+		glm::vec3 Center{};
+		float Radius = 0.0f;
+
+		// Non uniform scale grows the radius by the largest axis scale
+		VEBoundingSphere Transform(const glm::mat4& matrix) const;
+	};
+
+	// The six planes of a view frustum, pointing inwards, in the space the matrix transforms from
+	class VEFrustum
+	{
+	public:
+		enum Plane { LEFT = 0, RIGHT, BOTTOM, TOP, NEAR_PLANE, FAR_PLANE, PLANE_COUNT };
+
+		VEFrustum() = default;
+
+		// Planes of projection * view are in world space. Expects a depth range of 0 to 1
+		explicit VEFrustum(const glm::mat4& viewProjection);
+
+		// Conservative tests, objects touching the frustum count as visible
+		bool Intersects(const VEBoundingSphere& sphere) const;
+		bool Intersects(const VEBoundingBox& box) const;
+
+		const glm::vec4& GetPlane(Plane plane) const { return m_Planes[plane]; }
+
+		// Writes PLANE_COUNT * 4 floats, the layout VECulling expects
+		void GetPlanes(float* planes) const;
+
+	private:
+		glm::vec4 m_Planes[PLANE_COUNT]{};
+	};
+}
\ No newline at end of file
@@ -2,46 +2,93 @@
 
 namespace VulkanEngine {
 
-	glm::mat4 TransformComponent::Mat4()
+	bool TransformComponent::Update()
 	{
-		const float c3 = glm::cos(Rotation.z);
-		const float s3 = glm::sin(Rotation.z);
-		const float c2 = glm::cos(Rotation.x);
-		const float s2 = glm::sin(Rotation.x);
-		const float c1 = glm::cos(Rotation.y);
-		const float s1 = glm::sin(Rotation.y);
+		if (!m_Dirty)
+		{
+			return false;
+		}
+
+		// Both matrices share the same rotation, so the sines and cosines are only computed once
+		const float c3 = glm::cos(m_Rotation.z);
+		const float s3 = glm::sin(m_Rotation.z);
+		const float c2 = glm::cos(m_Rotation.x);
+		const float s2 = glm::sin(m_Rotation.x);
+		const float c1 = glm::cos(m_Rotation.y);
+		const float s1 = glm::sin(m_Rotation.y);
+
+		const glm::vec3 axisX{ c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 };
+		const glm::vec3 axisY{ c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 };
+		const glm::vec3 axisZ{ c2 * s1, -s2, c1 * c2 };
+
+		m_LocalMatrix[0]		= glm::vec4(m_Scale.x * axisX, 0.0f);
+		m_LocalMatrix[1]		= glm::vec4(m_Scale.y * axisY, 0.0f);
+		m_LocalMatrix[2]		= glm::vec4(m_Scale.z * axisZ, 0.0f);
+		m_LocalMatrix[3]		= glm::vec4(m_Translation, 1.0f);
+
+		const glm::vec3 invScale = 1.0f / m_Scale;
+
+		m_LocalNormalMatrix[0]	= invScale.x * axisX;
+		m_LocalNormalMatrix[1]	= invScale.y * axisY;
+		m_LocalNormalMatrix[2]	= invScale.z * axisZ;
+
+		m_Dirty = false;
+		return true;
+	}
+
+	void TransformComponent::SetLocalMatrices(const glm::mat4& matrix, const glm::mat3& normalMatrix)
+	{
+		m_LocalMatrix		= matrix;
+		m_LocalNormalMatrix	= normalMatrix;
+		m_Dirty				= false;
+	}
+
+	void TransformComponent::SetWorldMatrices(const glm::mat4& matrix, const glm::mat3& normalMatrix)
+	{
+		m_WorldMatrix		= matrix;
+		m_WorldNormalMatrix	= normalMatrix;
+	}
+
+	glm::mat4 TransformComponent::Mat4() const
+	{
+		const float c3 = glm::cos(m_Rotation.z);
+		const float s3 = glm::sin(m_Rotation.z);
+		const float c2 = glm::cos(m_Rotation.x);
+		const float s2 = glm::sin(m_Rotation.x);
+		const float c1 = glm::cos(m_Rotation.y);
+		const float s1 = glm::sin(m_Rotation.y);
 
 		return glm::mat4{
 			{
-				Scale.x * (c1 * c3 + s1 * s2 * s3),
-				Scale.x * (c2 * s3),
-				Scale.x * (c1 * s2 * s3 - c3 * s1),
+				m_Scale.x * (c1 * c3 + s1 * s2 * s3),
+				m_Scale.x * (c2 * s3),
+				m_Scale.x * (c1 * s2 * s3 - c3 * s1),
 				0.0f,
 			},
 			{
-				Scale.y * (c3 * s1 * s2 - c1 * s3),
-				Scale.y * (c2 * c3),
-				Scale.y * (c1 * c3 * s2 + s1 * s3),
+				m_Scale.y * (c3 * s1 * s2 - c1 * s3),
+				m_Scale.y * (c2 * c3),
+				m_Scale.y * (c1 * c3 * s2 + s1 * s3),
 				0.0f,
 			},
 			{
-				Scale.z * (c2 * s1),
-				Scale.z * (-s2),
-				Scale.z * (c1 * c2),
+				m_Scale.z * (c2 * s1),
+				m_Scale.z * (-s2),
+				m_Scale.z * (c1 * c2),
 				0.0f,
 			},
-			{Translation.x, Translation.y, Translation.z, 1.0f} };
+			{m_Translation.x, m_Translation.y, m_Translation.z, 1.0f} };
 	}
 
-	glm::mat3 TransformComponent::NormalMatrix()
+	glm::mat3 TransformComponent::NormalMatrix() const
 	{
-		const float c3 = glm::cos(Rotation.z);
-		const float s3 = glm::sin(Rotation.z);
-		const float c2 = glm::cos(Rotation.x);
-		const float s2 = glm::sin(Rotation.x);
-		const float c1 = glm::cos(Rotation.y);
-		const float s1 = glm::sin(Rotation.y);
-		const glm::vec3 invScale = 1.0f / Scale;
+		const float c3 = glm::cos(m_Rotation.z);
+		const float s3 = glm::sin(m_Rotation.z);
+		const float c2 = glm::cos(m_Rotation.x);
+		const float s2 = glm::sin(m_Rotation.x);
+		const float c1 = glm::cos(m_Rotation.y);
+		const float s1 = glm::sin(m_Rotation.y);
+		const glm::vec3 invScale = 1.0f / m_Scale;
 
 		return glm::mat3{
 			{
@@ -61,14 +108,4 @@ namespace VulkanEngine {
 			}
 		};
 	}
-	VEGameObject VEGameObject::MakePointLight(float intensity, float radius, glm::vec3 color)
-	{
-		VEGameObject gameObj = VEGameObject::CreateGameObject();
-		gameObj.m_Color							= color;
-		gameObj.m_Transform.Scale.x				= radius;
-		gameObj.m_PointLight					= std::make_unique<PointLightComponent>();
-		gameObj.m_PointLight->LightIntensity	= intensity;
-
-		return gameObj;
-	}
 }
\ No newline at end of file
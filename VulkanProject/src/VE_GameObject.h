@@ -3,63 +3,58 @@
 
 #include "glm/gtc/matrix_transform.hpp"
 
-#include <memory>
-#include <unordered_map>
-
 namespace VulkanEngine {
 
-	// Transform a component from object space into the shared world space (model transformation matrix)
-	struct TransformComponent
-	{
-		glm::vec3 Translation{}; // Position offset
-		glm::vec3 Scale{ 1.0f, 1.0f, 1.0f };
-		glm::vec3 Rotation;
-
-		// Matrix corresponds to Translate * R.y * R.x * R.z * Scale transformation
-		// Rotation cenvention uses Tait-Bryan angles with axis order Y(1), X(2), Z(3)
-		glm::mat4 Mat4();
-		glm::mat3 NormalMatrix();
-	};
-
-	struct PointLightComponent
-	{
-		float LightIntensity = 1.0f;
-	};
-
-	class VEGameObject
+	// Transform a component from object space into its parent's space, or world space for a root (model transformation matrix)
+	class TransformComponent
 	{
 	public:
-		using id_t	= unsigned int;
-		using Map	= std::unordered_map<id_t, VEGameObject>;
+		const glm::vec3& GetTranslation() const { return m_Translation; } // Position offset
+		const glm::vec3& GetScale() const { return m_Scale; }
+		const glm::vec3& GetRotation() const { return m_Rotation; }
 
-		static VEGameObject CreateGameObject()
-		{
-			static id_t currentId = 0;
-			return VEGameObject(currentId++);
-		}
+		// Every setter marks the cached matrices dirty
+		void SetTranslation(const glm::vec3& translation) { m_Translation = translation; m_Dirty = true; }
+		void SetScale(const glm::vec3& scale) { m_Scale = scale; m_Dirty = true; }
+		void SetRotation(const glm::vec3& rotation) { m_Rotation = rotation; m_Dirty = true; }
 
-		static VEGameObject MakePointLight(float intensity = 10.0f,
-			float radius = 0.1f,
-			glm::vec3 color = glm::vec3(1.0f));
+		// Recomputes the cached local matrices if the transform changed since the last update, returns whether it did
+		bool Update();
+		bool IsDirty() const { return m_Dirty; }
 
-		VEGameObject(const VEGameObject&) = delete;
-		VEGameObject& operator=(const VEGameObject&) = delete;
-		VEGameObject(VEGameObject&&) = default;
-		VEGameObject& operator=(VEGameObject&&) = default;
+		// Stores local matrices computed elsewhere, such as by a VETransformBatch, and clears the dirty flag
+		void SetLocalMatrices(const glm::mat4& matrix, const glm::mat3& normalMatrix);
 
-		id_t GetId() { return m_Id; }
+		// Cached by Update, stale while the transform is dirty
+		const glm::mat4& GetLocalMatrix() const { return m_LocalMatrix; }
+		const glm::mat3& GetLocalNormalMatrix() const { return m_LocalNormalMatrix; }
 
-		glm::vec3 m_Color{};
-		TransformComponent m_Transform{};
+		// Local matrices combined with every parent's, written by VEScene::UpdateTransforms
+		void SetWorldMatrices(const glm::mat4& matrix, const glm::mat3& normalMatrix);
+		const glm::mat4& GetWorldMatrix() const { return m_WorldMatrix; }
+		const glm::mat3& GetWorldNormalMatrix() const { return m_WorldNormalMatrix; }
 
-		// Optional pointer components
-		std::shared_ptr<VEModel> m_Model{};
-		std::unique_ptr< PointLightComponent> m_PointLight = nullptr;
+		// Matrix corresponds to Translate * R.y * R.x * R.z * Scale transformation
+		// Rotation cenvention uses Tait-Bryan angles with axis order Y(1), X(2), Z(3)
+		glm::mat4 Mat4() const;
+		glm::mat3 NormalMatrix() const;
 
 	private:
-		VEGameObject(id_t objId) : m_Id{ objId } {}
+		glm::vec3 m_Translation{};
+		glm::vec3 m_Scale{ 1.0f, 1.0f, 1.0f };
+		glm::vec3 m_Rotation{};
+
+		glm::mat4 m_LocalMatrix{ 1.0f };
+		glm::mat3 m_LocalNormalMatrix{ 1.0f };
+		glm::mat4 m_WorldMatrix{ 1.0f };
+		glm::mat3 m_WorldNormalMatrix{ 1.0f };
+		bool m_Dirty = true;
+	};
 
-	private:
-		id_t m_Id;
+	struct PointLightComponent
+	{
+		glm::vec3 Color{ 1.0f };
+		float LightIntensity = 1.0f;
+		float Radius = 5.0f; // Distance at which the light fades out completely, lights are culled against it
 	};
 }
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "VE_GeometryPool.h"
+
+#include <cassert>
+#include <limits>
+
+namespace VulkanEngine {
+
+	// Smallest range handed out, keeps tiny meshes from splitting the pool into lots of slivers
+	static constexpr uint64_t MIN_ELEMENTS = 64;
+
+	VEGeometryPool::VEGeometryPool(VEDevice& device, VkDeviceSize vertexStride, VkIndexType indexType, uint32_t vertexCapacity, uint32_t indexCapacity)
+		: m_Device{ device },
+		m_VertexStride{ vertexStride },
+		m_IndexType{ indexType },
+		m_VertexAllocator{ vertexCapacity, MIN_ELEMENTS },
+		m_IndexAllocator{ indexCapacity, MIN_ELEMENTS }
+	{
+		m_VertexBuffer = std::make_unique<VEBuffer>(
+			m_Device,
+			vertexStride,
+			static_cast<uint32_t>(m_VertexAllocator.GetCapacity()),
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		m_IndexBuffer = std::make_unique<VEBuffer>(
+			m_Device,
+			GetIndexSize(),
+			static_cast<uint32_t>(m_IndexAllocator.GetCapacity()),
+			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+	}
+
+	VEGeometryPool::~VEGeometryPool()
+	{
+		assert(m_VertexAllocator.IsEmpty() && m_IndexAllocator.IsEmpty() && "Destroying the geometry pool while models are still alive.");
+	}
+
+	bool VEGeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount, VEGeometryRange& range)
+	{
+		if (m_IndexType == VK_INDEX_TYPE_UINT16 && vertexCount > std::numeric_limits<uint16_t>::max())
+		{
+			return false;
+		}
+
+		const uint64_t firstVertex = m_VertexAllocator.Allocate(vertexCount);
+
+		if (firstVertex == VEBuddyAllocator::INVALID_OFFSET)
+		{
+			return false;
+		}
+
+		const uint64_t firstIndex = m_IndexAllocator.Allocate(indexCount);
+
+		if (firstIndex == VEBuddyAllocator::INVALID_OFFSET)
+		{
+			m_VertexAllocator.Free(firstVertex);
+			return false;
+		}
+
+		range.FirstVertex	= static_cast<uint32_t>(firstVertex);
+		range.VertexCount	= vertexCount;
+		range.FirstIndex	= static_cast<uint32_t>(firstIndex);
+		range.IndexCount	= indexCount;
+
+		return true;
+	}
+
+	void VEGeometryPool::Free(const VEGeometryRange& range)
+	{
+		m_VertexAllocator.Free(range.FirstVertex);
+		m_IndexAllocator.Free(range.FirstIndex);
+	}
+
+	void VEGeometryPool::Bind(VkCommandBuffer commandBuffer)
+	{
+		VkBuffer buffers[] = { m_VertexBuffer->GetBuffer() };
+		VkDeviceSize offsets[] = { 0 };
+
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->GetBuffer(), 0, m_IndexType);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+#include "VE_Buffer.h"
+#include "VE_BuddyAllocator.h"
+#include "VE_Device.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace VulkanEngine {
+
+	// Where a mesh lives inside a VEGeometryPool, in vertices and indices rather than bytes
+	struct VEGeometryRange
+	{
+		uint32_t FirstVertex	= 0;
+		uint32_t VertexCount	= 0;
+		uint32_t FirstIndex		= 0;
+		uint32_t IndexCount		= 0;
+	};
+
+	// Shared vertex and index megabuffers that many models are packed into, so all of them can be drawn
+	// with one set of buffer bindings and a single multi draw indirect call
+	class VEGeometryPool
+	{
+	public:
+		static constexpr uint32_t DEFAULT_VERTEX_CAPACITY	= 1u << 20;
+		static constexpr uint32_t DEFAULT_INDEX_CAPACITY	= 1u << 22;
+
+		// With 16 bit indices the pool only takes meshes whose vertices can all be addressed with them
+		VEGeometryPool(VEDevice& device,
+			VkDeviceSize vertexStride,
+			VkIndexType indexType = VK_INDEX_TYPE_UINT32,
+			uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY,
+			uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY);
+		~VEGeometryPool();
+
+		// Delete the copy constructor and copy operator
+		VEGeometryPool(const VEGeometryPool&) = delete;
+		VEGeometryPool& operator=(const VEGeometryPool&) = delete;
+
+		// Returns false when either buffer has no room left or the mesh has too many vertices for the index type,
+		// the caller should fall back to its own buffers
+		bool Allocate(uint32_t vertexCount, uint32_t indexCount, VEGeometryRange& range);
+		void Free(const VEGeometryRange& range);
+
+		void Bind(VkCommandBuffer commandBuffer);
+
+		VkBuffer GetVertexBuffer() const { return m_VertexBuffer->GetBuffer(); }
+		VkBuffer GetIndexBuffer() const { return m_IndexBuffer->GetBuffer(); }
+		VkDeviceSize GetVertexStride() const { return m_VertexStride; }
+		VkIndexType GetIndexType() const { return m_IndexType; }
+		VkDeviceSize GetIndexSize() const { return m_IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+	private:
+		VEDevice& m_Device;
+		VkDeviceSize m_VertexStride;
+		VkIndexType m_IndexType;
+
+		std::unique_ptr<VEBuffer> m_VertexBuffer;
+		std::unique_ptr<VEBuffer> m_IndexBuffer;
+
+		// Both allocators work in elements, so their offsets can be used as vertexOffset and firstIndex directly
+		VEBuddyAllocator m_VertexAllocator;
+		VEBuddyAllocator m_IndexAllocator;
+	};
+}
\ No newline at end of file
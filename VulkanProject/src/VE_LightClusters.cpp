@@ -0,0 +1,158 @@
+#include "VE_LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace VulkanEngine {
+
+	// Tile range covered by view space x (or y) in [minValue, maxValue] at depths in [nearZ, farZ].
+	// Returns false when the range misses the screen
+	static bool GetTileRange(float scale, float minValue, float maxValue, float nearZ, float farZ, uint32_t tileCount,
+		uint8_t& minTile, uint8_t& maxTile)
+	{
+		// x / z is monotonic in both x and z, so the extremes are at the corners
+		const float corners[4] = {
+			scale * minValue / nearZ,
+			scale * minValue / farZ,
+			scale * maxValue / nearZ,
+			scale * maxValue / farZ
+		};
+
+		const float minNdc = std::min(std::min(corners[0], corners[1]), std::min(corners[2], corners[3]));
+		const float maxNdc = std::max(std::max(corners[0], corners[1]), std::max(corners[2], corners[3]));
+
+		if (maxNdc < -1.0f || minNdc > 1.0f)
+		{
+			return false;
+		}
+
+		auto toTile = [tileCount](float ndc)
+		{
+			const float tile = std::floor((ndc * 0.5f + 0.5f) * tileCount);
+			return static_cast<uint8_t>(std::clamp(tile, 0.0f, static_cast<float>(tileCount - 1)));
+		};
+
+		minTile = toTile(minNdc);
+		maxTile = toTile(maxNdc);
+
+		return true;
+	}
+
+	VELightClusters::VELightClusters(uint32_t maxLightIndices)
+		: m_MaxLightIndices{ maxLightIndices }
+	{
+		m_Clusters.resize(CLUSTER_COUNT);
+	}
+
+	float VELightClusters::GetSliceDepth(uint32_t slice) const
+	{
+		return m_Near * std::pow(m_Far / m_Near, static_cast<float>(slice) / GRID_Z);
+	}
+
+	uint32_t VELightClusters::GetSlice(float depth) const
+	{
+		const float slice = std::floor(std::log(depth) * m_SliceScale + m_SliceBias);
+		return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(GRID_Z - 1)));
+	}
+
+	void VELightClusters::Build(const glm::mat4& view, const glm::mat4& projection, const glm::vec4* lights, uint32_t lightCount)
+	{
+		// Inverse of VECamera::SetPerspectiveProjection's depth terms
+		m_Near = -projection[3][2] / projection[2][2];
+		m_Far = projection[3][2] / (1.0f - projection[2][2]);
+
+		const float logDepthRange = std::log(m_Far / m_Near);
+
+		m_SliceScale = GRID_Z / logDepthRange;
+		m_SliceBias = -std::log(m_Near) * m_SliceScale;
+
+		m_Spans.clear();
+
+		for (auto& cluster : m_Clusters)
+		{
+			cluster = {};
+		}
+
+		// Find the tiles every light covers in each slice it crosses and count the lights per cluster
+		for (uint32_t i = 0; i < lightCount; i++)
+		{
+			const glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(lights[i]), 1.0f));
+			const float radius = lights[i].w;
+
+			if (center.z + radius <= m_Near || center.z - radius >= m_Far)
+			{
+				continue;
+			}
+
+			const float minZ = std::max(center.z - radius, m_Near);
+			const float maxZ = std::min(center.z + radius, m_Far);
+
+			const uint32_t firstSlice = GetSlice(minZ);
+			const uint32_t lastSlice = GetSlice(maxZ);
+
+			for (uint32_t slice = firstSlice; slice <= lastSlice; slice++)
+			{
+				// Only the part of the sphere's depth range inside this slice, so near slices get tight bounds
+				const float nearZ = std::max(minZ, GetSliceDepth(slice));
+				const float farZ = std::min(maxZ, GetSliceDepth(slice + 1));
+
+				Span span = {};
+				span.Light = i;
+				span.Slice = static_cast<uint16_t>(slice);
+
+				if (!GetTileRange(projection[0][0], center.x - radius, center.x + radius, nearZ, farZ, GRID_X, span.MinX, span.MaxX) ||
+					!GetTileRange(projection[1][1], center.y - radius, center.y + radius, nearZ, farZ, GRID_Y, span.MinY, span.MaxY))
+				{
+					continue;
+				}
+
+				m_Spans.push_back(span);
+
+				for (uint32_t y = span.MinY; y <= span.MaxY; y++)
+				{
+					for (uint32_t x = span.MinX; x <= span.MaxX; x++)
+					{
+						m_Clusters[(slice * GRID_Y + y) * GRID_X + x].Count++;
+					}
+				}
+			}
+		}
+
+		// Give every cluster its range of the index list, clusters past the capacity get fewer lights
+		uint32_t offset = 0;
+		m_DroppedCount = 0;
+
+		for (auto& cluster : m_Clusters)
+		{
+			const uint32_t count = std::min(cluster.Count, m_MaxLightIndices - offset);
+
+			m_DroppedCount += cluster.Count - count;
+
+			cluster.Offset = offset;
+			cluster.Count = count;
+			offset += count;
+		}
+
+		m_LightIndices.resize(offset);
+
+		// Fill the lists in light order, the cursors count what has been written to each cluster so far
+		m_Cursors.assign(CLUSTER_COUNT, 0);
+
+		for (const Span& span : m_Spans)
+		{
+			for (uint32_t y = span.MinY; y <= span.MaxY; y++)
+			{
+				for (uint32_t x = span.MinX; x <= span.MaxX; x++)
+				{
+					const uint32_t index = (span.Slice * GRID_Y + y) * GRID_X + x;
+					const Cluster& cluster = m_Clusters[index];
+
+					if (m_Cursors[index] < cluster.Count)
+					{
+						m_LightIndices[cluster.Offset + m_Cursors[index]++] = span.Light;
+					}
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Splits the view frustum into a grid of clusters, screen tiles along x and y and exponential depth slices,
+	// and lists the lights whose sphere of influence touches each cluster. Simple_Shader.frag finds the cluster
+	// of a fragment the same way and only shades with the lights listed there
+	class VELightClusters
+	{
+	public:
+		static constexpr uint32_t GRID_X = 16;
+		static constexpr uint32_t GRID_Y = 9;
+		static constexpr uint32_t GRID_Z = 24;
+		static constexpr uint32_t CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+		// Matches uvec2 in the cluster storage buffer, a range of the light index list
+		struct Cluster
+		{
+			uint32_t Offset;
+			uint32_t Count;
+		};
+
+		// Light references past maxLightIndices are dropped, the lights still render but miss those clusters
+		explicit VELightClusters(uint32_t maxLightIndices);
+
+		// Each light is a world space position in xyz and an influence radius in w.
+		// Expects a perspective projection with a 0 to 1 depth range, the near and far planes are read from it
+		void Build(const glm::mat4& view, const glm::mat4& projection, const glm::vec4* lights, uint32_t lightCount);
+
+		const std::vector<Cluster>& GetClusters() const { return m_Clusters; }
+		const std::vector<uint32_t>& GetLightIndices() const { return m_LightIndices; }
+
+		// Near, far, and the scale and bias turning log(view depth) into a slice index
+		glm::vec4 GetDepthParameters() const { return { m_Near, m_Far, m_SliceScale, m_SliceBias }; }
+
+		uint32_t GetDroppedCount() const { return m_DroppedCount; }
+
+	private:
+		// Range of tiles one light covers in one depth slice
+		struct Span
+		{
+			uint32_t Light;
+			uint16_t Slice;
+			uint8_t MinX, MaxX, MinY, MaxY;
+		};
+
+		float GetSliceDepth(uint32_t slice) const;
+		uint32_t GetSlice(float depth) const;
+
+	private:
+		uint32_t m_MaxLightIndices;
+
+		float m_Near = 0.1f;
+		float m_Far = 1000.0f;
+		float m_SliceScale = 0.0f;
+		float m_SliceBias = 0.0f;
+
+		std::vector<Cluster> m_Clusters;
+		std::vector<uint32_t> m_LightIndices;
+		uint32_t m_DroppedCount = 0;
+
+		// Reused every frame to avoid allocating while binning
+		std::vector<Span> m_Spans;
+		std::vector<uint32_t> m_Cursors;
+	};
+}
\ No newline at end of file
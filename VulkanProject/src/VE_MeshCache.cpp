@@ -0,0 +1,347 @@
+#include "VE_MeshCache.h"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+namespace VulkanEngine {
+
+	VEMappedFile::VEMappedFile(const std::string& filepath)
+	{
+#ifdef _WIN32
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return;
+		}
+
+		m_FileHandle = file;
+
+		LARGE_INTEGER fileSize = {};
+
+		if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			return;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+		if (mapping == nullptr)
+		{
+			return;
+		}
+
+		m_MappingHandle = mapping;
+		m_Data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		m_Size = m_Data != nullptr ? static_cast<size_t>(fileSize.QuadPart) : 0;
+#else
+		m_FileDescriptor = open(filepath.c_str(), O_RDONLY);
+
+		if (m_FileDescriptor < 0)
+		{
+			return;
+		}
+
+		struct stat fileStat = {};
+
+		if (fstat(m_FileDescriptor, &fileStat) != 0 || fileStat.st_size == 0)
+		{
+			return;
+		}
+
+		void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_PRIVATE, m_FileDescriptor, 0);
+
+		if (data == MAP_FAILED)
+		{
+			return;
+		}
+
+		m_Data = static_cast<const uint8_t*>(data);
+		m_Size = static_cast<size_t>(fileStat.st_size);
+#endif
+	}
+
+	VEMappedFile::~VEMappedFile()
+	{
+#ifdef _WIN32
+		if (m_Data != nullptr)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+
+		if (m_MappingHandle != nullptr)
+		{
+			CloseHandle(m_MappingHandle);
+		}
+
+		if (m_FileHandle != nullptr)
+		{
+			CloseHandle(m_FileHandle);
+		}
+#else
+		if (m_Data != nullptr)
+		{
+			munmap(const_cast<uint8_t*>(m_Data), m_Size);
+		}
+
+		if (m_FileDescriptor >= 0)
+		{
+			close(m_FileDescriptor);
+		}
+#endif
+	}
+
+	std::string VEMeshCache::GetCachePath(const std::string& sourcePath)
+	{
+		return sourcePath + ".vemesh";
+	}
+
+	bool VEMeshCache::Load(const std::string& sourcePath, VEModel::Builder& builder)
+	{
+		return LoadFromFile(GetCachePath(sourcePath), sourcePath, builder);
+	}
+
+	bool VEMeshCache::LoadFromFile(const std::string& cachePath, const std::string& sourcePath, VEModel::Builder& builder)
+	{
+		VEMappedFile file(cachePath);
+
+		if (!file.IsValid() || file.GetSize() < sizeof(MeshCacheHeader))
+		{
+			return false;
+		}
+
+		MeshCacheHeader header = {};
+		memcpy(&header, file.GetData(), sizeof(MeshCacheHeader));
+
+		if (header.Magic != MeshCacheHeader::MAGIC ||
+			header.Version != MeshCacheHeader::VERSION ||
+			header.VertexStride != sizeof(VEModel::Vertex) ||
+			header.IndexStride != sizeof(uint32_t))
+		{
+			return false;
+		}
+
+		// The cache is stale if the source file has been modified. A missing source is fine, the cache can be shipped on its own
+		uint64_t sourceSize = 0;
+		int64_t sourceTimestamp = 0;
+
+		if (GetSourceInfo(sourcePath, sourceSize, sourceTimestamp) &&
+			(sourceSize != header.SourceSize || sourceTimestamp != header.SourceTimestamp))
+		{
+			return false;
+		}
+
+		const size_t vertexBytes = static_cast<size_t>(header.VertexCount) * header.VertexStride;
+		const size_t indexBytes = static_cast<size_t>(header.IndexCount) * header.IndexStride;
+		const size_t lodBytes = static_cast<size_t>(header.LodCount) * sizeof(VEModel::Lod);
+		const size_t meshletBytes = static_cast<size_t>(header.MeshletCount) * sizeof(VEMeshOptimizer::Meshlet);
+
+		if (file.GetSize() != sizeof(MeshCacheHeader) + vertexBytes + indexBytes + lodBytes + meshletBytes)
+		{
+			return false;
+		}
+
+		const uint8_t* vertexData = file.GetData() + sizeof(MeshCacheHeader);
+		const uint8_t* indexData = vertexData + vertexBytes;
+		const uint8_t* lodData = indexData + indexBytes;
+		const uint8_t* meshletData = lodData + lodBytes;
+
+		if (Checksum(vertexData, vertexBytes) != header.VertexChecksum ||
+			Checksum(indexData, indexBytes) != header.IndexChecksum)
+		{
+			return false;
+		}
+
+		builder.Vertices.resize(header.VertexCount);
+		builder.Indices.resize(header.IndexCount);
+
+		memcpy(builder.Vertices.data(), vertexData, vertexBytes);
+		memcpy(builder.Indices.data(), indexData, indexBytes);
+
+		builder.Lods.resize(header.LodCount);
+		memcpy(builder.Lods.data(), lodData, lodBytes);
+
+		builder.Meshlets.resize(header.MeshletCount);
+		memcpy(builder.Meshlets.data(), meshletData, meshletBytes);
+
+		// The checksums don't cover the LOD ranges and meshlets, make sure they stay inside the indices
+		for (const VEModel::Lod& lod : builder.Lods)
+		{
+			if (static_cast<uint64_t>(lod.FirstIndex) + lod.IndexCount > header.IndexCount)
+			{
+				builder = {};
+				return false;
+			}
+		}
+
+		const uint64_t meshletIndexCount = builder.Lods.empty() ? header.IndexCount : builder.Lods[0].IndexCount;
+
+		for (const VEMeshOptimizer::Meshlet& meshlet : builder.Meshlets)
+		{
+			if (static_cast<uint64_t>(meshlet.FirstIndex) + meshlet.IndexCount > meshletIndexCount)
+			{
+				builder = {};
+				return false;
+			}
+		}
+
+		builder.BoundingBox.Min			= { header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2] };
+		builder.BoundingBox.Max			= { header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2] };
+		builder.BoundingSphere.Center	= builder.BoundingBox.GetCenter();
+		builder.BoundingSphere.Radius	= header.BoundingRadius;
+
+		return true;
+	}
+
+	bool VEMeshCache::Write(const std::string& sourcePath, const VEModel::Builder& builder)
+	{
+		return WriteToFile(GetCachePath(sourcePath), sourcePath, builder);
+	}
+
+	bool VEMeshCache::WriteToFile(const std::string& cachePath, const std::string& sourcePath, const VEModel::Builder& builder)
+	{
+		const size_t vertexBytes = builder.Vertices.size() * sizeof(VEModel::Vertex);
+		const size_t indexBytes = builder.Indices.size() * sizeof(uint32_t);
+		const size_t lodBytes = builder.Lods.size() * sizeof(VEModel::Lod);
+		const size_t meshletBytes = builder.Meshlets.size() * sizeof(VEMeshOptimizer::Meshlet);
+
+		MeshCacheHeader header = {};
+
+		header.VertexStride		= sizeof(VEModel::Vertex);
+		header.IndexStride		= sizeof(uint32_t);
+		header.VertexCount		= static_cast<uint32_t>(builder.Vertices.size());
+		header.IndexCount		= static_cast<uint32_t>(builder.Indices.size());
+		header.LodCount			= static_cast<uint32_t>(builder.Lods.size());
+		header.MeshletCount		= static_cast<uint32_t>(builder.Meshlets.size());
+		header.VertexChecksum	= Checksum(builder.Vertices.data(), vertexBytes);
+		header.IndexChecksum	= Checksum(builder.Indices.data(), indexBytes);
+
+		GetSourceInfo(sourcePath, header.SourceSize, header.SourceTimestamp);
+
+		// Builders that were filled by hand get their bounds computed here
+		VEBoundingBox boundingBox = builder.BoundingBox;
+		VEBoundingSphere boundingSphere = builder.BoundingSphere;
+
+		if (boundingBox.IsEmpty() && !builder.Vertices.empty())
+		{
+			VEModel::Builder boundsBuilder = {};
+			boundsBuilder.Vertices = builder.Vertices;
+			boundsBuilder.ComputeBounds();
+
+			boundingBox = boundsBuilder.BoundingBox;
+			boundingSphere = boundsBuilder.BoundingSphere;
+		}
+
+		if (!boundingBox.IsEmpty())
+		{
+			for (int i = 0; i < 3; i++)
+			{
+				header.BoundsMin[i] = boundingBox.Min[i];
+				header.BoundsMax[i] = boundingBox.Max[i];
+			}
+
+			header.BoundingRadius = boundingSphere.Radius;
+		}
+
+		// Write to a temporary file first so a partially written cache is never picked up
+		const std::string tempPath = cachePath + ".tmp";
+
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+
+			if (!file.is_open())
+			{
+				std::cerr << "Failed to open mesh cache for writing: " << tempPath << std::endl;
+				return false;
+			}
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(MeshCacheHeader));
+			file.write(reinterpret_cast<const char*>(builder.Vertices.data()), vertexBytes);
+			file.write(reinterpret_cast<const char*>(builder.Indices.data()), indexBytes);
+			file.write(reinterpret_cast<const char*>(builder.Lods.data()), lodBytes);
+			file.write(reinterpret_cast<const char*>(builder.Meshlets.data()), meshletBytes);
+
+			if (!file.good())
+			{
+				std::cerr << "Failed to write mesh cache: " << tempPath << std::endl;
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, cachePath, error);
+
+		if (error)
+		{
+			std::cerr << "Failed to write mesh cache: " << cachePath << " (" << error.message() << ")" << std::endl;
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	uint64_t VEMeshCache::Checksum(const void* data, size_t size)
+	{
+		// FNV-1a, consuming 8 bytes per step
+		const uint64_t prime = 0x100000001b3ull;
+		uint64_t hash = 0xcbf29ce484222325ull;
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		size_t offset = 0;
+
+		for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+		{
+			uint64_t word;
+			memcpy(&word, bytes + offset, sizeof(uint64_t));
+
+			hash = (hash ^ word) * prime;
+		}
+
+		for (; offset < size; offset++)
+		{
+			hash = (hash ^ bytes[offset]) * prime;
+		}
+
+		return hash;
+	}
+
+	bool VEMeshCache::GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& timestamp)
+	{
+		std::error_code error;
+
+		auto fileSize = std::filesystem::file_size(sourcePath, error);
+
+		if (error)
+		{
+			return false;
+		}
+
+		auto writeTime = std::filesystem::last_write_time(sourcePath, error);
+
+		if (error)
+		{
+			return false;
+		}
+
+		size = static_cast<uint64_t>(fileSize);
+		timestamp = static_cast<int64_t>(writeTime.time_since_epoch().count());
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "VE_Model.h"
+
+#include <cstdint>
+#include <string>
+
+namespace VulkanEngine {
+
+	// On-disk layout of a cached mesh. The header is followed by VertexCount vertices, IndexCount indices,
+	// LodCount VEModel::Lod ranges and MeshletCount meshlets
+	struct MeshCacheHeader
+	{
+		static constexpr uint32_t MAGIC		= 0x434D4556; // "VEMC"
+		static constexpr uint32_t VERSION	= 6; // 6: LOD errors bounded in total, not per step
+
+		uint32_t Magic				= MAGIC;
+		uint32_t Version			= VERSION;
+		uint32_t VertexStride		= 0;
+		uint32_t IndexStride		= 0;
+		uint32_t VertexCount		= 0;
+		uint32_t IndexCount			= 0;
+
+		// Used to detect when the source file has changed since the cache was written
+		uint64_t SourceSize			= 0;
+		int64_t SourceTimestamp		= 0;
+
+		uint64_t VertexChecksum		= 0;
+		uint64_t IndexChecksum		= 0;
+
+		// Object space bounding box, and a sphere centered on it
+		float BoundsMin[3]			= {};
+		float BoundsMax[3]			= {};
+		float BoundingRadius		= 0.0f;
+
+		uint32_t LodCount			= 0;
+		uint32_t MeshletCount		= 0;
+
+		// Fills what would otherwise be tail padding, so every byte written to the file is initialized
+		uint32_t Reserved			= 0;
+	};
+
+	static_assert(sizeof(MeshCacheHeader) == 96, "MeshCacheHeader must not have padding.");
+
+	// Read only view of a file mapped into the address space of the process
+	class VEMappedFile
+	{
+	public:
+		VEMappedFile(const std::string& filepath);
+		~VEMappedFile();
+
+		// Delete the copy constructor and copy operator
+		VEMappedFile(const VEMappedFile&) = delete;
+		VEMappedFile& operator=(const VEMappedFile&) = delete;
+
+		bool IsValid() const { return m_Data != nullptr; }
+		const uint8_t* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+		int m_FileDescriptor = -1;
+	};
+
+	class VEMeshCache
+	{
+	public:
+		static std::string GetCachePath(const std::string& sourcePath);
+
+		// Fills the builder from the cache next to sourcePath. Returns false if the cache is missing, stale or corrupt
+		static bool Load(const std::string& sourcePath, VEModel::Builder& builder);
+		static bool LoadFromFile(const std::string& cachePath, const std::string& sourcePath, VEModel::Builder& builder);
+
+		static bool Write(const std::string& sourcePath, const VEModel::Builder& builder);
+		static bool WriteToFile(const std::string& cachePath, const std::string& sourcePath, const VEModel::Builder& builder);
+
+		static uint64_t Checksum(const void* data, size_t size);
+
+	private:
+		static bool GetSourceInfo(const std::string& sourcePath, uint64_t& size, int64_t& timestamp);
+	};
+}
\ No newline at end of file
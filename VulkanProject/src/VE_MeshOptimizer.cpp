@@ -0,0 +1,998 @@
+#include "VE_MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace VulkanEngine {
+
+	// Forsyth's suggested constants
+	static constexpr float CACHE_DECAY_POWER = 1.5f;
+	static constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	static constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	static constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	// Valences past this share the last score, the boost is already tiny there
+	static constexpr uint32_t MAX_SCORED_VALENCE = 32;
+
+	struct VertexScoreTable
+	{
+		float Cache[VEMeshOptimizer::OPTIMIZE_CACHE_SIZE + 1];	// By cache position + 1, 0 is not in the cache
+		float Valence[MAX_SCORED_VALENCE + 1];					// By triangles left to emit
+
+		VertexScoreTable()
+		{
+			constexpr uint32_t cacheSize = VEMeshOptimizer::OPTIMIZE_CACHE_SIZE;
+
+			Cache[0] = 0.0f;
+
+			for (uint32_t position = 0; position < cacheSize; position++)
+			{
+				// The three vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse them
+				Cache[position + 1] = position < 3
+					? LAST_TRIANGLE_SCORE
+					: std::pow(1.0f - static_cast<float>(position - 3) / (cacheSize - 3), CACHE_DECAY_POWER);
+			}
+
+			Valence[0] = 0.0f;
+
+			for (uint32_t valence = 1; valence <= MAX_SCORED_VALENCE; valence++)
+			{
+				Valence[valence] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -VALENCE_BOOST_POWER);
+			}
+		}
+
+		float GetScore(int32_t cachePosition, uint32_t trianglesLeft) const
+		{
+			if (trianglesLeft == 0)
+			{
+				return -1.0f;
+			}
+
+			return Cache[cachePosition + 1] + Valence[std::min(trianglesLeft, MAX_SCORED_VALENCE)];
+		}
+	};
+
+	static const VertexScoreTable s_ScoreTable;
+
+	void VEMeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		assert(indices.size() % 3 == 0 && "Indices must form a triangle list.");
+
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		// Triangles of every vertex, packed with an offset per vertex. The first TrianglesLeft entries of a vertex's
+		// range are the triangles not emitted yet
+		std::vector<uint32_t> trianglesLeft(vertexCount, 0);
+
+		for (uint32_t index : indices)
+		{
+			trianglesLeft[index]++;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + trianglesLeft[vertex];
+		}
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				adjacency[fill[vertex]++] = triangle;
+			}
+		}
+
+		std::vector<int32_t> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			vertexScores[vertex] = s_ScoreTable.GetScore(-1, trianglesLeft[vertex]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			const uint32_t* corners = &indices[triangle * 3];
+			triangleScores[triangle] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+		}
+
+		// The cache briefly holds the new triangle's vertices on top of the full cache before the oldest fall out
+		uint32_t cache[OPTIMIZE_CACHE_SIZE + 3];
+		uint32_t newCache[OPTIMIZE_CACHE_SIZE + 3];
+		uint32_t cacheCount = 0;
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		// Next triangle in input order to fall back on when no cached vertex has triangles left
+		uint32_t inputCursor = 0;
+		uint32_t bestTriangle = 0;
+
+		for (uint32_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+		{
+			if (bestTriangle == INVALID_INDEX)
+			{
+				while (emitted[inputCursor])
+				{
+					inputCursor++;
+				}
+
+				bestTriangle = inputCursor;
+			}
+
+			const uint32_t* corners = &indices[bestTriangle * 3];
+
+			output.insert(output.end(), corners, corners + 3);
+			emitted[bestTriangle] = 1;
+
+			// Move the triangle's vertices to the front of the cache, followed by the rest in their old order
+			uint32_t newCacheCount = 0;
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t vertex = corners[corner];
+
+				newCache[newCacheCount++] = vertex;
+
+				// Remove the triangle from the vertex's remaining triangles
+				uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+				uint32_t& left = trianglesLeft[vertex];
+
+				for (uint32_t i = 0; i < left; i++)
+				{
+					if (triangles[i] == bestTriangle)
+					{
+						std::swap(triangles[i], triangles[left - 1]);
+						left--;
+						break;
+					}
+				}
+			}
+
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				const uint32_t vertex = cache[i];
+
+				if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+				{
+					newCache[newCacheCount++] = vertex;
+				}
+			}
+
+			// Vertices pushed past the end fall out of the cache and lose their cache score
+			for (uint32_t i = OPTIMIZE_CACHE_SIZE; i < newCacheCount; i++)
+			{
+				const uint32_t vertex = newCache[i];
+
+				cachePositions[vertex] = -1;
+				vertexScores[vertex] = s_ScoreTable.GetScore(-1, trianglesLeft[vertex]);
+			}
+
+			cacheCount = std::min(newCacheCount, OPTIMIZE_CACHE_SIZE);
+			std::copy(newCache, newCache + cacheCount, cache);
+
+			for (uint32_t i = 0; i < cacheCount; i++)
+			{
+				const uint32_t vertex = cache[i];
+
+				cachePositions[vertex] = static_cast<int32_t>(i);
+				vertexScores[vertex] = s_ScoreTable.GetScore(static_cast<int32_t>(i), trianglesLeft[vertex]);
+			}
+
+			// Only triangles around the cache changed score, the best of those is the next one
+			bestTriangle = INVALID_INDEX;
+			float bestScore = -1.0f;
+
+			for (uint32_t i = 0; i < newCacheCount; i++)
+			{
+				const uint32_t vertex = newCache[i];
+				const uint32_t* triangles = &adjacency[adjacencyOffsets[vertex]];
+
+				for (uint32_t t = 0; t < trianglesLeft[vertex]; t++)
+				{
+					const uint32_t triangle = triangles[t];
+					const uint32_t* triangleCorners = &indices[triangle * 3];
+
+					const float score = vertexScores[triangleCorners[0]] + vertexScores[triangleCorners[1]] + vertexScores[triangleCorners[2]];
+					triangleScores[triangle] = score;
+
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = triangle;
+					}
+				}
+			}
+		}
+
+		indices = std::move(output);
+	}
+
+	void VEMeshOptimizer::OptimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, size_t positionStride, uint32_t vertexCount)
+	{
+		assert(indices.size() % 3 == 0 && "Indices must form a triangle list.");
+
+		const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		auto getPosition = [positions, positionStride](uint32_t vertex)
+		{
+			return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+		};
+
+		// A cluster starts wherever the simulated cache misses every vertex of a triangle, the order inside a
+		// cluster is kept so the cache behaves the same after the clusters are moved around
+		std::vector<uint32_t> clusterStarts;
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = ANALYZE_CACHE_SIZE + 1;
+
+		for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			uint32_t misses = 0;
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t vertex = indices[triangle * 3 + corner];
+
+				if (timestamp - cacheTimestamps[vertex] > ANALYZE_CACHE_SIZE)
+				{
+					cacheTimestamps[vertex] = timestamp++;
+					misses++;
+				}
+			}
+
+			if (misses == 3 || triangle == 0)
+			{
+				clusterStarts.push_back(triangle);
+			}
+		}
+
+		clusterStarts.push_back(triangleCount);
+
+		const uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+
+		// Area weighted centroid of the whole mesh and of every cluster, and the summed normal of every cluster
+		double meshCentroid[3] = {};
+		double meshArea = 0.0;
+
+		std::vector<float> clusterCentroids(clusterCount * 3, 0.0f);
+		std::vector<float> clusterNormals(clusterCount * 3, 0.0f);
+
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			double centroid[3] = {};
+			double clusterArea = 0.0;
+
+			for (uint32_t triangle = clusterStarts[cluster]; triangle < clusterStarts[cluster + 1]; triangle++)
+			{
+				const float* a = getPosition(indices[triangle * 3 + 0]);
+				const float* b = getPosition(indices[triangle * 3 + 1]);
+				const float* c = getPosition(indices[triangle * 3 + 2]);
+
+				const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				const float normal[3] = {
+					ab[1] * ac[2] - ab[2] * ac[1],
+					ab[2] * ac[0] - ab[0] * ac[2],
+					ab[0] * ac[1] - ab[1] * ac[0]
+				};
+
+				const double area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				for (uint32_t axis = 0; axis < 3; axis++)
+				{
+					centroid[axis] += area * (a[axis] + b[axis] + c[axis]) / 3.0;
+					clusterNormals[cluster * 3 + axis] += normal[axis];
+				}
+
+				clusterArea += area;
+			}
+
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				meshCentroid[axis] += centroid[axis];
+				clusterCentroids[cluster * 3 + axis] = clusterArea > 0.0 ? static_cast<float>(centroid[axis] / clusterArea) : 0.0f;
+			}
+
+			meshArea += clusterArea;
+		}
+
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			meshCentroid[axis] = meshArea > 0.0 ? meshCentroid[axis] / meshArea : 0.0;
+		}
+
+		// How far a cluster faces outwards, outward facing clusters cover the rest from most directions
+		std::vector<float> sortKeys(clusterCount);
+
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			const float* centroid = &clusterCentroids[cluster * 3];
+			const float* normal = &clusterNormals[cluster * 3];
+
+			const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+			float key = 0.0f;
+
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				key += (centroid[axis] - static_cast<float>(meshCentroid[axis])) * (length > 0.0f ? normal[axis] / length : 0.0f);
+			}
+
+			sortKeys[cluster] = key;
+		}
+
+		std::vector<uint32_t> clusterOrder(clusterCount);
+
+		for (uint32_t cluster = 0; cluster < clusterCount; cluster++)
+		{
+			clusterOrder[cluster] = cluster;
+		}
+
+		std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+			[&sortKeys](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+		std::vector<uint32_t> output;
+		output.reserve(indices.size());
+
+		for (uint32_t cluster : clusterOrder)
+		{
+			output.insert(output.end(),
+				indices.begin() + clusterStarts[cluster] * 3,
+				indices.begin() + clusterStarts[cluster + 1] * 3);
+		}
+
+		indices = std::move(output);
+	}
+
+	std::vector<uint32_t> VEMeshOptimizer::OptimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+		uint32_t nextVertex = 0;
+
+		for (uint32_t& index : indices)
+		{
+			if (remap[index] == INVALID_INDEX)
+			{
+				remap[index] = nextVertex++;
+			}
+
+			index = remap[index];
+		}
+
+		return remap;
+	}
+
+	// Sum of squared distances to a set of planes, weighted by the area of the triangle each plane came from
+	struct Quadric
+	{
+		double A00 = 0.0, A01 = 0.0, A02 = 0.0, A11 = 0.0, A12 = 0.0, A22 = 0.0;
+		double B0 = 0.0, B1 = 0.0, B2 = 0.0;
+		double C = 0.0;
+		double Weight = 0.0;
+
+		void AddPlane(const double normal[3], double distance, double weight)
+		{
+			A00 += weight * normal[0] * normal[0];
+			A01 += weight * normal[0] * normal[1];
+			A02 += weight * normal[0] * normal[2];
+			A11 += weight * normal[1] * normal[1];
+			A12 += weight * normal[1] * normal[2];
+			A22 += weight * normal[2] * normal[2];
+			B0 += weight * normal[0] * distance;
+			B1 += weight * normal[1] * distance;
+			B2 += weight * normal[2] * distance;
+			C += weight * distance * distance;
+			Weight += weight;
+		}
+
+		void Add(const Quadric& other)
+		{
+			A00 += other.A00; A01 += other.A01; A02 += other.A02;
+			A11 += other.A11; A12 += other.A12; A22 += other.A22;
+			B0 += other.B0; B1 += other.B1; B2 += other.B2;
+			C += other.C;
+			Weight += other.Weight;
+		}
+
+		// Weighted mean of the squared distances from p to the planes
+		double Evaluate(const float* p) const
+		{
+			const double x = p[0];
+			const double y = p[1];
+			const double z = p[2];
+
+			const double error =
+				A00 * x * x + A11 * y * y + A22 * z * z +
+				2.0 * (A01 * x * y + A02 * x * z + A12 * y * z) +
+				2.0 * (B0 * x + B1 * y + B2 * z) +
+				C;
+
+			return Weight > 0.0 ? std::max(error, 0.0) / Weight : 0.0;
+		}
+	};
+
+	static void GetTriangleNormal(const float* a, const float* b, const float* c, double normal[3])
+	{
+		const double ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const double ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+
+		normal[0] = ab[1] * ac[2] - ab[2] * ac[1];
+		normal[1] = ab[2] * ac[0] - ab[0] * ac[2];
+		normal[2] = ab[0] * ac[1] - ab[1] * ac[0];
+	}
+
+	static const float* GetPosition(const float* positions, size_t positionStride, uint32_t vertex)
+	{
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+	}
+
+	// Gives every vertex the first vertex with a bit identical position. Sorting by the position bits puts
+	// vertices that only differ in their other attributes next to each other
+	static std::vector<uint32_t> GetPositionVertices(const float* positions, size_t positionStride, uint32_t vertexCount)
+	{
+		std::vector<uint32_t> sortedVertices(vertexCount);
+		std::vector<uint32_t> positionVertices(vertexCount);
+
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			sortedVertices[vertex] = vertex;
+		}
+
+		auto lessPosition = [positions, positionStride](uint32_t a, uint32_t b)
+		{
+			return std::memcmp(GetPosition(positions, positionStride, a), GetPosition(positions, positionStride, b), sizeof(float) * 3) < 0;
+		};
+
+		std::sort(sortedVertices.begin(), sortedVertices.end(), lessPosition);
+
+		for (uint32_t first = 0; first < vertexCount;)
+		{
+			uint32_t last = first + 1;
+
+			while (last < vertexCount && !lessPosition(sortedVertices[first], sortedVertices[last]))
+			{
+				last++;
+			}
+
+			for (uint32_t i = first; i < last; i++)
+			{
+				positionVertices[sortedVertices[i]] = sortedVertices[first];
+			}
+
+			first = last;
+		}
+
+		return positionVertices;
+	}
+
+	// Edges used by a single triangle, as the two position vertices packed into 64 bits. Edges are compared by
+	// position, so the two sides of an attribute seam count as one edge
+	static std::vector<uint64_t> GetOpenEdges(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& positionVertices)
+	{
+		std::vector<uint64_t> edges;
+		edges.reserve(indices.size());
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				const uint32_t a = positionVertices[indices[i + corner]];
+				const uint32_t b = positionVertices[indices[i + (corner + 1) % 3]];
+
+				edges.push_back(static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b));
+			}
+		}
+
+		std::sort(edges.begin(), edges.end());
+
+		std::vector<uint64_t> openEdges;
+
+		for (size_t first = 0; first < edges.size();)
+		{
+			size_t last = first + 1;
+
+			while (last < edges.size() && edges[last] == edges[first])
+			{
+				last++;
+			}
+
+			if (last - first == 1)
+			{
+				openEdges.push_back(edges[first]);
+			}
+
+			first = last;
+		}
+
+		return openEdges;
+	}
+
+	float VEMeshOptimizer::Simplify(std::vector<uint32_t>& destination,
+		const std::vector<uint32_t>& indices,
+		const float* positions,
+		size_t positionStride,
+		uint32_t vertexCount,
+		size_t targetIndexCount,
+		float maxError)
+	{
+		assert(indices.size() % 3 == 0 && "Indices must form a triangle list.");
+
+		destination = indices;
+
+		auto getPosition = [positions, positionStride](uint32_t vertex)
+		{
+			return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+		};
+
+		// Vertices sharing a position with another vertex sit on an attribute seam, vertices on open edges on a
+		// border. Neither may move
+		const std::vector<uint32_t> positionVertices = GetPositionVertices(positions, positionStride, vertexCount);
+
+		std::vector<uint32_t> positionCounts(vertexCount, 0);
+		std::vector<uint8_t> locked(vertexCount, 0);
+
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			positionCounts[positionVertices[vertex]]++;
+		}
+
+		for (uint64_t edge : GetOpenEdges(destination, positionVertices))
+		{
+			locked[static_cast<uint32_t>(edge >> 32)] = 1;
+			locked[static_cast<uint32_t>(edge)] = 1;
+		}
+
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			locked[vertex] = positionCounts[positionVertices[vertex]] > 1 || locked[positionVertices[vertex]];
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+
+		for (size_t i = 0; i < destination.size(); i += 3)
+		{
+			const float* a = getPosition(destination[i + 0]);
+
+			double normal[3];
+			GetTriangleNormal(a, getPosition(destination[i + 1]), getPosition(destination[i + 2]), normal);
+
+			const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+			if (length == 0.0)
+			{
+				continue;
+			}
+
+			normal[0] /= length;
+			normal[1] /= length;
+			normal[2] /= length;
+
+			const double distance = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				quadrics[destination[i + corner]].AddPlane(normal, distance, length * 0.5);
+			}
+		}
+
+		struct Collapse
+		{
+			uint32_t Source;
+			uint32_t Target;
+			double Error;
+		};
+
+		const double maxErrorSquared = static_cast<double>(maxError) * maxError;
+		double errorSquared = 0.0;
+
+		std::vector<Collapse> collapses;
+		std::vector<uint32_t> adjacencyOffsets;
+		std::vector<uint32_t> adjacency;
+		std::vector<uint32_t> remap(vertexCount);
+		std::vector<uint8_t> touched(vertexCount);
+
+		// Every pass collapses as many edges as it can without two collapses changing the same triangle, then
+		// rebuilds the adjacency for the next one
+		while (destination.size() > targetIndexCount)
+		{
+			const uint32_t triangleCount = static_cast<uint32_t>(destination.size() / 3);
+
+			adjacencyOffsets.assign(vertexCount + 1, 0);
+
+			for (uint32_t index : destination)
+			{
+				adjacencyOffsets[index + 1]++;
+			}
+
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			{
+				adjacencyOffsets[vertex + 1] += adjacencyOffsets[vertex];
+			}
+
+			adjacency.resize(destination.size());
+			std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					adjacency[fill[destination[triangle * 3 + corner]]++] = triangle;
+				}
+			}
+
+			// Both directions of every edge whose source may move, cheapest first
+			collapses.clear();
+
+			for (uint32_t triangle = 0; triangle < triangleCount; triangle++)
+			{
+				for (uint32_t corner = 0; corner < 3; corner++)
+				{
+					const uint32_t a = destination[triangle * 3 + corner];
+					const uint32_t b = destination[triangle * 3 + (corner + 1) % 3];
+
+					if (!locked[a])
+					{
+						collapses.push_back({ a, b, quadrics[a].Evaluate(getPosition(b)) });
+					}
+
+					if (!locked[b])
+					{
+						collapses.push_back({ b, a, quadrics[b].Evaluate(getPosition(a)) });
+					}
+				}
+			}
+
+			std::sort(collapses.begin(), collapses.end(),
+				[](const Collapse& a, const Collapse& b) { return a.Error < b.Error; });
+
+			for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+			{
+				remap[vertex] = vertex;
+			}
+
+			std::fill(touched.begin(), touched.end(), 0);
+
+			// Every collapse removes about two triangles
+			size_t removableIndices = destination.size() - targetIndexCount;
+			uint32_t collapseCount = 0;
+
+			for (const Collapse& collapse : collapses)
+			{
+				if (collapse.Error > maxErrorSquared || removableIndices == 0)
+				{
+					break;
+				}
+
+				const uint32_t source = collapse.Source;
+				const uint32_t target = collapse.Target;
+
+				if (touched[source] || touched[target])
+				{
+					continue;
+				}
+
+				// Moving the source onto the target must not flip any of the triangles that stay
+				const uint32_t* triangles = &adjacency[adjacencyOffsets[source]];
+				const uint32_t triangleEnd = adjacencyOffsets[source + 1] - adjacencyOffsets[source];
+
+				bool flips = false;
+
+				for (uint32_t t = 0; t < triangleEnd && !flips; t++)
+				{
+					const uint32_t* corners = &destination[triangles[t] * 3];
+
+					if (corners[0] == target || corners[1] == target || corners[2] == target)
+					{
+						continue;
+					}
+
+					const float* before[3];
+					const float* after[3];
+
+					for (uint32_t corner = 0; corner < 3; corner++)
+					{
+						before[corner] = getPosition(corners[corner]);
+						after[corner] = corners[corner] == source ? getPosition(target) : before[corner];
+					}
+
+					double normalBefore[3];
+					double normalAfter[3];
+					GetTriangleNormal(before[0], before[1], before[2], normalBefore);
+					GetTriangleNormal(after[0], after[1], after[2], normalAfter);
+
+					const double dot =
+						normalBefore[0] * normalAfter[0] +
+						normalBefore[1] * normalAfter[1] +
+						normalBefore[2] * normalAfter[2];
+
+					flips = dot <= 0.0;
+				}
+
+				if (flips)
+				{
+					continue;
+				}
+
+				// Lock the neighbourhood for the rest of the pass, the flip test above only holds while it doesn't change
+				for (uint32_t t = 0; t < triangleEnd; t++)
+				{
+					const uint32_t* corners = &destination[triangles[t] * 3];
+
+					touched[corners[0]] = 1;
+					touched[corners[1]] = 1;
+					touched[corners[2]] = 1;
+				}
+
+				remap[source] = target;
+				quadrics[target].Add(quadrics[source]);
+				errorSquared = std::max(errorSquared, collapse.Error);
+
+				removableIndices -= std::min<size_t>(removableIndices, 6);
+				collapseCount++;
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			// Apply the collapses and drop the triangles that lost an edge
+			size_t writeIndex = 0;
+
+			for (size_t i = 0; i < destination.size(); i += 3)
+			{
+				const uint32_t a = remap[destination[i + 0]];
+				const uint32_t b = remap[destination[i + 1]];
+				const uint32_t c = remap[destination[i + 2]];
+
+				if (a != b && b != c && a != c)
+				{
+					destination[writeIndex++] = a;
+					destination[writeIndex++] = b;
+					destination[writeIndex++] = c;
+				}
+			}
+
+			destination.resize(writeIndex);
+		}
+
+		return static_cast<float>(std::sqrt(errorSquared));
+	}
+
+	std::vector<VEMeshOptimizer::Meshlet> VEMeshOptimizer::BuildMeshlets(const std::vector<uint32_t>& indices,
+		const float* positions,
+		size_t positionStride,
+		uint32_t vertexCount,
+		uint32_t maxVertices,
+		uint32_t maxTriangles)
+	{
+		assert(indices.size() % 3 == 0 && "Indices must form a triangle list.");
+		assert(maxVertices >= 3 && maxTriangles >= 1 && "A meshlet has to fit at least one triangle.");
+
+		std::vector<Meshlet> meshlets;
+
+		// The meshlet a vertex was last added to, so unique vertices are counted without clearing anything
+		std::vector<uint32_t> vertexMeshlets(vertexCount, INVALID_INDEX);
+
+		Meshlet meshlet = {};
+		uint32_t meshletVertexCount = 0;
+
+		for (size_t i = 0; i < indices.size(); i += 3)
+		{
+			const uint32_t meshletIndex = static_cast<uint32_t>(meshlets.size());
+
+			uint32_t newVertices = 0;
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				// A triangle can name the same vertex twice, count it once
+				const uint32_t vertex = indices[i + corner];
+				const bool repeated = (corner > 0 && indices[i] == vertex) || (corner > 1 && indices[i + 1] == vertex);
+
+				newVertices += vertexMeshlets[vertex] != meshletIndex && !repeated;
+			}
+
+			if (meshletVertexCount + newVertices > maxVertices || meshlet.IndexCount / 3 == maxTriangles)
+			{
+				meshlets.push_back(meshlet);
+
+				meshlet = {};
+				meshlet.FirstIndex = static_cast<uint32_t>(i);
+				meshletVertexCount = 0;
+
+				// Every vertex of the triangle is new to the next meshlet
+				i -= 3;
+				continue;
+			}
+
+			for (uint32_t corner = 0; corner < 3; corner++)
+			{
+				vertexMeshlets[indices[i + corner]] = meshletIndex;
+			}
+
+			meshletVertexCount += newVertices;
+			meshlet.IndexCount += 3;
+		}
+
+		if (meshlet.IndexCount > 0)
+		{
+			meshlets.push_back(meshlet);
+		}
+
+		// Bounds and normal cones
+		for (Meshlet& current : meshlets)
+		{
+			float min[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float max[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			double axis[3] = {};
+
+			for (uint32_t i = current.FirstIndex; i < current.FirstIndex + current.IndexCount; i += 3)
+			{
+				const float* corners[3] = {
+					GetPosition(positions, positionStride, indices[i + 0]),
+					GetPosition(positions, positionStride, indices[i + 1]),
+					GetPosition(positions, positionStride, indices[i + 2])
+				};
+
+				for (const float* corner : corners)
+				{
+					for (uint32_t component = 0; component < 3; component++)
+					{
+						min[component] = std::min(min[component], corner[component]);
+						max[component] = std::max(max[component], corner[component]);
+					}
+				}
+
+				// Area weighted, so slivers don't pull the axis around
+				double normal[3];
+				GetTriangleNormal(corners[0], corners[1], corners[2], normal);
+
+				axis[0] += normal[0];
+				axis[1] += normal[1];
+				axis[2] += normal[2];
+			}
+
+			float radiusSquared = 0.0f;
+
+			for (uint32_t component = 0; component < 3; component++)
+			{
+				current.Center[component] = (min[component] + max[component]) * 0.5f;
+			}
+
+			for (uint32_t i = current.FirstIndex; i < current.FirstIndex + current.IndexCount; i++)
+			{
+				const float* position = GetPosition(positions, positionStride, indices[i]);
+
+				const float dx = position[0] - current.Center[0];
+				const float dy = position[1] - current.Center[1];
+				const float dz = position[2] - current.Center[2];
+
+				radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+			}
+
+			current.Radius = std::sqrt(radiusSquared);
+
+			const double axisLength = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+
+			if (axisLength == 0.0)
+			{
+				continue;
+			}
+
+			for (uint32_t component = 0; component < 3; component++)
+			{
+				current.ConeAxis[component] = static_cast<float>(axis[component] / axisLength);
+			}
+
+			// The widest angle between the axis and a triangle normal
+			double minDot = 1.0;
+
+			for (uint32_t i = current.FirstIndex; i < current.FirstIndex + current.IndexCount; i += 3)
+			{
+				double normal[3];
+				GetTriangleNormal(GetPosition(positions, positionStride, indices[i + 0]),
+					GetPosition(positions, positionStride, indices[i + 1]),
+					GetPosition(positions, positionStride, indices[i + 2]),
+					normal);
+
+				const double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+				if (length > 0.0)
+				{
+					minDot = std::min(minDot, (normal[0] * current.ConeAxis[0] + normal[1] * current.ConeAxis[1] + normal[2] * current.ConeAxis[2]) / length);
+				}
+			}
+
+			// Every triangle faces away from a view direction within 90 degrees minus the cone angle of the axis.
+			// Cones wider than about 85 degrees leave too little room to be worth testing
+			current.ConeCutoff = minDot > 0.1 ? static_cast<float>(std::sqrt(1.0 - minDot * minDot)) : 1.0f;
+		}
+
+		return meshlets;
+	}
+
+	bool VEMeshOptimizer::Meshlet::IsBackfacing(const float cameraPosition[3]) const
+	{
+		const float dx = Center[0] - cameraPosition[0];
+		const float dy = Center[1] - cameraPosition[1];
+		const float dz = Center[2] - cameraPosition[2];
+
+		const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+
+		// The radius widens the test to every point in the bounds
+		return dx * ConeAxis[0] + dy * ConeAxis[1] + dz * ConeAxis[2] >= ConeCutoff * distance + Radius;
+	}
+
+	bool VEMeshOptimizer::IsClosed(const std::vector<uint32_t>& indices, const float* positions, size_t positionStride, uint32_t vertexCount)
+	{
+		return GetOpenEdges(indices, GetPositionVertices(positions, positionStride, vertexCount)).empty();
+	}
+
+	double VEMeshOptimizer::GetSignedVolume(const std::vector<uint32_t>& indices, const float* positions, size_t positionStride)
+	{
+		// Sum of the tetrahedra between the origin and every triangle
+		double volume = 0.0;
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const float* a = GetPosition(positions, positionStride, indices[i + 0]);
+			const float* b = GetPosition(positions, positionStride, indices[i + 1]);
+			const float* c = GetPosition(positions, positionStride, indices[i + 2]);
+
+			volume +=
+				a[0] * (static_cast<double>(b[1]) * c[2] - static_cast<double>(b[2]) * c[1]) +
+				a[1] * (static_cast<double>(b[2]) * c[0] - static_cast<double>(b[0]) * c[2]) +
+				a[2] * (static_cast<double>(b[0]) * c[1] - static_cast<double>(b[1]) * c[0]);
+		}
+
+		return volume / 6.0;
+	}
+
+	VEMeshOptimizer::VertexCacheStats VEMeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+		uint32_t cacheSize)
+	{
+		VertexCacheStats stats = {};
+
+		// A FIFO cache: a vertex is a hit while fewer than cacheSize vertices were transformed since it was
+		std::vector<uint32_t> cacheTimestamps(vertexCount, 0);
+		uint32_t timestamp = cacheSize + 1;
+
+		for (uint32_t index : indices)
+		{
+			if (timestamp - cacheTimestamps[index] > cacheSize)
+			{
+				cacheTimestamps[index] = timestamp++;
+				stats.TransformedVertices++;
+			}
+		}
+
+		const size_t triangleCount = indices.size() / 3;
+
+		stats.ACMR = triangleCount > 0 ? static_cast<float>(stats.TransformedVertices) / triangleCount : 0.0f;
+		stats.ATVR = vertexCount > 0 ? static_cast<float>(stats.TransformedVertices) / vertexCount : 0.0f;
+
+		return stats;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Reorders the triangles and vertices of an indexed triangle list so the GPU transforms fewer vertices and fetches
+	// them with better locality. None of the passes add or remove triangles, they only change the order
+	class VEMeshOptimizer
+	{
+	public:
+		// Size of the cache the triangle order is tuned for. Larger than most real caches, which is what the
+		// scoring function was designed around, and it still does well on smaller ones
+		static constexpr uint32_t OPTIMIZE_CACHE_SIZE = 32;
+
+		// FIFO cache size AnalyzeVertexCache simulates by default, roughly a post transform cache of current GPUs
+		static constexpr uint32_t ANALYZE_CACHE_SIZE = 16;
+
+		struct VertexCacheStats
+		{
+			uint32_t TransformedVertices = 0;
+			float ACMR = 0.0f; // Average cache miss ratio, transformed vertices per triangle, 0.5 at best and 3 at worst
+			float ATVR = 0.0f; // Average transform to vertex ratio, transformed vertices per vertex, 1 at best
+		};
+
+		// Limits of a meshlet, the sizes NVIDIA recommends for mesh shaders so meshlets built now stay usable there
+		static constexpr uint32_t MAX_MESHLET_VERTICES = 64;
+		static constexpr uint32_t MAX_MESHLET_TRIANGLES = 124;
+
+		// A small run of triangles with bounds tight enough to cull it on its own
+		struct Meshlet
+		{
+			uint32_t FirstIndex = 0;	// Range of the index list the meshlet was built from
+			uint32_t IndexCount = 0;
+			float Center[3] = {};		// Bounding sphere
+			float Radius = 0.0f;
+			float ConeAxis[3] = {};		// Every triangle's normal is within the cone around the axis
+			float ConeCutoff = 1.0f;	// Sine of the cone's half angle, 1 when the triangles face too many ways to ever cull
+
+			// True when every triangle faces away from the camera wherever it is in the bounds. Only valid for meshes
+			// whose back faces can't be seen, see IsClosed
+			bool IsBackfacing(const float cameraPosition[3]) const;
+		};
+
+		// Tom Forsyth's linear speed vertex cache optimization: greedily emits the triangle whose vertices score
+		// highest, where the score favours vertices recently used and vertices with few triangles left
+		static void OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+		// Splits a cache optimized triangle order into clusters where the cache restarts, then sorts the clusters so
+		// the ones facing away from the mesh center, the likely occluders, are drawn first. Keeps most of the cache win
+		static void OptimizeOverdraw(std::vector<uint32_t>& indices, const float* positions, size_t positionStride, uint32_t vertexCount);
+
+		// Renumbers the vertices in the order the indices first use them and rewrites the indices.
+		// Returns the new index of every old vertex, INVALID_INDEX for vertices no triangle uses
+		static std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+		// Garland and Heckbert's quadric error metric simplification. Collapses edges onto one of their vertices until
+		// destination has at most targetIndexCount indices or the next collapse would move the surface further than
+		// maxError, so the result indexes the same vertices. Vertices on open borders and on attribute seams, where
+		// several vertices share a position, never move so no cracks open up.
+		// Returns how far the simplified surface may be from the input, in the units of the positions
+		static float Simplify(std::vector<uint32_t>& destination,
+			const std::vector<uint32_t>& indices,
+			const float* positions,
+			size_t positionStride,
+			uint32_t vertexCount,
+			size_t targetIndexCount,
+			float maxError);
+
+		// Splits the index list into consecutive runs of at most maxVertices unique vertices and maxTriangles
+		// triangles. Run it on a vertex cache optimized order, which keeps neighbouring triangles together
+		static std::vector<Meshlet> BuildMeshlets(const std::vector<uint32_t>& indices,
+			const float* positions,
+			size_t positionStride,
+			uint32_t vertexCount,
+			uint32_t maxVertices = MAX_MESHLET_VERTICES,
+			uint32_t maxTriangles = MAX_MESHLET_TRIANGLES);
+
+		// True when every edge is shared by two triangles, comparing vertices by position. The back faces of a
+		// closed mesh are hidden behind its front faces as long as the camera is outside of it
+		static bool IsClosed(const std::vector<uint32_t>& indices, const float* positions, size_t positionStride, uint32_t vertexCount);
+
+		// Positive when the triangles wind counter clockwise seen from outside of a closed mesh
+		static double GetSignedVolume(const std::vector<uint32_t>& indices, const float* positions, size_t positionStride);
+
+		static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount,
+			uint32_t cacheSize = ANALYZE_CACHE_SIZE);
+
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+	};
+}
\ No newline at end of file
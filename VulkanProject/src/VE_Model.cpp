@@ -1,67 +1,395 @@
 #include "VE_Model.h"
-#include "VE_Utils.h"
+#include "VE_MeshCache.h"
+#include "VE_ThreadPool.h"
+#include "VE_VertexTable.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
 
+#include <algorithm>
 #include <cassert>
-#include <unordered_map>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
 
-namespace std {
+namespace VulkanEngine {
+
+	// VEVertexTable compares the raw bytes of the vertices
+	static_assert(sizeof(VEModel::Vertex) == 11 * sizeof(float), "Vertex must not have padding.");
+
+	// A smooth mesh has about six corners per vertex, the table grows when the guess is too low
+	static size_t GetExpectedVertexCount(size_t cornerCount)
+	{
+		return cornerCount / 4;
+	}
 
-	template <>
-	struct hash<VulkanEngine::VEModel::Vertex>
+	// Shared by every import so only the first parallel load starts threads
+	static VEThreadPool& GetImportThreadPool()
 	{
-		size_t operator()(VulkanEngine::VEModel::Vertex const& vertex) const
+		static VEThreadPool threadPool;
+		return threadPool;
+	}
+
+	static void CalculateBounds(const std::vector<VEModel::Vertex>& vertices, VEBoundingBox& box, VEBoundingSphere& sphere)
+	{
+		box = {};
+		sphere = {};
+
+		if (vertices.empty())
 		{
-			size_t seed = 0;
-			VulkanEngine::HashCombine(seed, vertex.Position, vertex.Color, vertex.Normal, vertex.UV);
-			return seed;
+			return;
 		}
-	};
-}
 
-namespace VulkanEngine {
+		box.Min = vertices[0].Position;
+		box.Max = vertices[0].Position;
+
+		for (const auto& vertex : vertices)
+		{
+			box.Min = glm::min(box.Min, vertex.Position);
+			box.Max = glm::max(box.Max, vertex.Position);
+		}
+
+		// Centered on the box, with the radius reaching the furthest vertex rather than the box corners
+		sphere.Center = box.GetCenter();
+
+		float radiusSquared = 0.0f;
+
+		for (const auto& vertex : vertices)
+		{
+			const glm::vec3 offset = vertex.Position - sphere.Center;
+			radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
+		}
+
+		sphere.Radius = std::sqrt(radiusSquared);
+	}
+
+	static int16_t ToSnorm16(float value)
+	{
+		return static_cast<int16_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	static uint8_t ToUnorm8(float value)
+	{
+		return static_cast<uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+	}
 
-	VEModel::VEModel(VEDevice& device, const VEModel::Builder& builder)
-		: m_Device{ device }
+	// IEEE half float, rounded to nearest even. Out of range values become infinity
+	static uint16_t ToHalf(float value)
 	{
-		CreateVertexBuffers(builder.Vertices);
+		uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t sign = (bits >> 16) & 0x8000;
+		const uint32_t floatExponent = (bits >> 23) & 0xff;
+		uint32_t mantissa = bits & 0x7fffff;
+
+		// Infinity and NaN
+		if (floatExponent == 0xff)
+		{
+			return static_cast<uint16_t>(sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0));
+		}
+
+		const int32_t exponent = static_cast<int32_t>(floatExponent) - 127 + 15;
+
+		if (exponent >= 31)
+		{
+			return static_cast<uint16_t>(sign | 0x7c00);
+		}
+
+		uint32_t shift = 13;
+		uint32_t half = 0;
+
+		if (exponent <= 0)
+		{
+			// Too small for a denormal half
+			if (exponent < -10)
+			{
+				return static_cast<uint16_t>(sign);
+			}
+
+			// Denormal, the implicit leading one becomes part of the mantissa
+			mantissa |= 0x800000;
+			shift = static_cast<uint32_t>(14 - exponent);
+		}
+		else
+		{
+			half = static_cast<uint32_t>(exponent) << 10;
+		}
+
+		half |= mantissa >> shift;
+
+		// A carry out of the mantissa correctly bumps the exponent, up to infinity
+		const uint32_t remainder = mantissa & ((1u << shift) - 1);
+		const uint32_t halfway = 1u << (shift - 1);
+
+		if (remainder > halfway || (remainder == halfway && (half & 1) != 0))
+		{
+			half++;
+		}
+
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	// Folds the unit vector onto the octahedron |x| + |y| + |z| = 1 and unfolds that into a square.
+	// Decoded by DecodeOctahedral in Simple_Shader.vert
+	static void ToOctahedral(const glm::vec3& normal, int16_t encoded[2])
+	{
+		const float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+
+		if (length == 0.0f)
+		{
+			encoded[0] = 0;
+			encoded[1] = 0;
+			return;
+		}
+
+		float x = normal.x / length;
+		float y = normal.y / length;
+
+		// The lower half folds over the diagonals
+		if (normal.z < 0.0f)
+		{
+			const float foldedX = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+			const float foldedY = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+
+			x = foldedX;
+			y = foldedY;
+		}
+
+		encoded[0] = ToSnorm16(x);
+		encoded[1] = ToSnorm16(y);
+	}
+
+	// Positions are stored relative to the center of the bounds, in units of the half extents
+	static std::vector<VEModel::PackedVertex> PackVertices(const std::vector<VEModel::Vertex>& vertices, const glm::vec3& offset, const glm::vec3& scale)
+	{
+		const glm::vec3 inverseScale = {
+			scale.x > 0.0f ? 1.0f / scale.x : 0.0f,
+			scale.y > 0.0f ? 1.0f / scale.y : 0.0f,
+			scale.z > 0.0f ? 1.0f / scale.z : 0.0f
+		};
+
+		std::vector<VEModel::PackedVertex> packed(vertices.size());
+
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			const VEModel::Vertex& vertex = vertices[i];
+			VEModel::PackedVertex& packedVertex = packed[i];
+
+			const glm::vec3 position = (vertex.Position - offset) * inverseScale;
+
+			packedVertex.Position[0] = ToSnorm16(position.x);
+			packedVertex.Position[1] = ToSnorm16(position.y);
+			packedVertex.Position[2] = ToSnorm16(position.z);
+			packedVertex.Position[3] = 0;
+
+			packedVertex.Color[0] = ToUnorm8(vertex.Color.r);
+			packedVertex.Color[1] = ToUnorm8(vertex.Color.g);
+			packedVertex.Color[2] = ToUnorm8(vertex.Color.b);
+			packedVertex.Color[3] = 0;
+
+			ToOctahedral(vertex.Normal, packedVertex.Normal);
+
+			packedVertex.UV[0] = ToHalf(vertex.UV.x);
+			packedVertex.UV[1] = ToHalf(vertex.UV.y);
+		}
+
+		return packed;
+	}
+
+	static std::vector<uint16_t> NarrowIndices(const std::vector<uint32_t>& indices)
+	{
+		std::vector<uint16_t> narrowed(indices.size());
+
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			assert(indices[i] <= std::numeric_limits<uint16_t>::max() && "Index doesn't fit in 16 bits.");
+			narrowed[i] = static_cast<uint16_t>(indices[i]);
+		}
+
+		return narrowed;
+	}
+
+	VEModel::VEModel(VEDevice& device, const VEModel::Builder& builder, VEUploadManager* uploadManager, VEGeometryPool* geometryPool)
+		: m_Device{ device }, m_UploadManager{ uploadManager }, m_GeometryPool{ geometryPool }
+	{
+		// Builders put together by hand don't come with bounds
+		if (builder.BoundingBox.IsEmpty())
+		{
+			CalculateBounds(builder.Vertices, m_BoundingBox, m_BoundingSphere);
+		}
+		else
+		{
+			m_BoundingBox		= builder.BoundingBox;
+			m_BoundingSphere	= builder.BoundingSphere;
+		}
+
+		m_PositionOffset	= m_BoundingBox.GetCenter();
+		m_PositionScale		= (m_BoundingBox.Max - m_BoundingBox.Min) * 0.5f;
+
+		const std::vector<PackedVertex> vertices = PackVertices(builder.Vertices, m_PositionOffset, m_PositionScale);
+
+		// Without LODs the whole index buffer, or every vertex of an unindexed model, is LOD 0
+		m_Lods = builder.Lods;
+
+		if (m_Lods.empty())
+		{
+			const size_t count = builder.Indices.empty() ? builder.Vertices.size() : builder.Indices.size();
+			m_Lods.push_back({ 0, static_cast<uint32_t>(count), 0.0f });
+		}
+
+		if (!builder.Meshlets.empty())
+		{
+			m_Meshlets = builder.Meshlets;
+			m_MeshletIndices.assign(builder.Indices.begin() + m_Lods[0].FirstIndex,
+				builder.Indices.begin() + m_Lods[0].FirstIndex + m_Lods[0].IndexCount);
+		}
+
+		if (m_GeometryPool != nullptr && CreatePooledBuffers(vertices, builder.Indices))
+		{
+			return;
+		}
+
+		m_GeometryPool = nullptr;
+
+		CreateVertexBuffers(vertices);
 		CreateIndexBuffers(builder.Indices);
 	}
 
 	VEModel::~VEModel()
 	{
+		if (m_GeometryPool != nullptr)
+		{
+			m_GeometryPool->Free(m_GeometryRange);
+		}
 	}
 
-	std::unique_ptr<VEModel> VEModel::CreateModelFromFile(VEDevice& device, const std::string& filepath)
+	std::unique_ptr<VEModel> VEModel::CreateModelFromFile(VEDevice& device, const std::string& filepath, VEUploadManager* uploadManager, VEGeometryPool* geometryPool)
 	{
 		Builder builder = {};
-		builder.LoadModel(filepath);
 
-		return std::make_unique<VEModel>(device, builder);
+		// Only parse the OBJ file if there is no up to date binary cache for it
+		if (!VEMeshCache::Load(filepath, builder))
+		{
+			builder.LoadModel(filepath);
+			builder.Optimize();
+			builder.GenerateLods();
+			builder.BuildMeshlets();
+			VEMeshCache::Write(filepath, builder);
+		}
+
+		return std::make_unique<VEModel>(device, builder, uploadManager, geometryPool);
 	}
 
-	void VEModel::CreateVertexBuffers(const std::vector<Vertex>& vertices)
+	bool VEModel::IsResident()
+	{
+		if (!m_IsResident)
+		{
+			m_IsResident = m_UploadManager == nullptr || m_UploadManager->IsComplete(m_UploadTicket);
+		}
+
+		return m_IsResident;
+	}
+
+	bool VEModel::CreatePooledBuffers(const std::vector<PackedVertex>& vertices, const std::vector<uint32_t>& builderIndices)
 	{
 		m_VertexCount = static_cast<uint32_t>(vertices.size());
 		assert(m_VertexCount >= 3 && "Vertex count must be atleast 3.");
 
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * m_VertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
+		// Everything in the pool is drawn indexed, so models without indices get a trivial index list
+		std::vector<uint32_t> sequentialIndices;
+		const std::vector<uint32_t>* indices = &builderIndices;
+
+		if (indices->empty())
+		{
+			sequentialIndices.resize(m_VertexCount);
+
+			for (uint32_t i = 0; i < m_VertexCount; i++)
+			{
+				sequentialIndices[i] = i;
+			}
+
+			indices = &sequentialIndices;
+		}
+
+		m_IndexCount = static_cast<uint32_t>(indices->size());
+		m_HasIndexBuffer = true;
+
+		if (!m_GeometryPool->Allocate(m_VertexCount, m_IndexCount, m_GeometryRange))
+		{
+			return false;
+		}
+
+		assert(m_GeometryPool->GetVertexStride() == sizeof(PackedVertex) && "The geometry pool must hold packed vertices.");
+
+		const VkDeviceSize vertexStride = m_GeometryPool->GetVertexStride();
+		const VkDeviceSize indexSize = m_GeometryPool->GetIndexSize();
+
+		UploadToBuffer(m_GeometryPool->GetVertexBuffer(),
+			vertices.data(),
+			vertexStride * m_VertexCount,
+			vertexStride * m_GeometryRange.FirstVertex);
+
+		// The pool's vertexOffset is added after the index is fetched, so 16 bit indices stay relative to the mesh
+		m_IndexType = m_GeometryPool->GetIndexType();
+
+		if (m_IndexType == VK_INDEX_TYPE_UINT16)
+		{
+			const std::vector<uint16_t> narrowed = NarrowIndices(*indices);
+
+			UploadToBuffer(m_GeometryPool->GetIndexBuffer(),
+				narrowed.data(),
+				indexSize * m_IndexCount,
+				indexSize * m_GeometryRange.FirstIndex);
+		}
+		else
+		{
+			UploadToBuffer(m_GeometryPool->GetIndexBuffer(),
+				indices->data(),
+				indexSize * m_IndexCount,
+				indexSize * m_GeometryRange.FirstIndex);
+		}
+
+		m_MemoryUsage.VertexBytes			= vertexStride * m_VertexCount;
+		m_MemoryUsage.IndexBytes			= indexSize * m_IndexCount;
+		m_MemoryUsage.UnpackedVertexBytes	= sizeof(Vertex) * m_VertexCount;
+		m_MemoryUsage.UnpackedIndexBytes	= sizeof(uint32_t) * m_IndexCount;
+
+		return true;
+	}
+
+	void VEModel::UploadToBuffer(VkBuffer buffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+	{
+		// Queue the copy and let the model become resident once the upload manager's batch has completed
+		if (m_UploadManager != nullptr)
+		{
+			m_UploadTicket = m_UploadManager->Upload(buffer, data, size, dstOffset);
+			return;
+		}
 
 		VEBuffer stagingBuffer = {
 			m_Device,
-			vertexSize,
-			m_VertexCount,
+			size,
+			1,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
 		};
 
 		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)vertices.data());
+		stagingBuffer.WriteToBuffer((void*)data);
+
+		// Copy the data from the staging buffer into the destination buffer
+		m_Device.CopyBuffer(stagingBuffer.GetBuffer(), buffer, size, dstOffset);
+	}
+
+	void VEModel::CreateVertexBuffers(const std::vector<PackedVertex>& vertices)
+	{
+		m_VertexCount = static_cast<uint32_t>(vertices.size());
+		assert(m_VertexCount >= 3 && "Vertex count must be atleast 3.");
+
+		VkDeviceSize bufferSize = sizeof(vertices[0]) * m_VertexCount;
+		uint32_t vertexSize = sizeof(vertices[0]);
 
 		m_VertexBuffer = std::make_unique<VEBuffer>(
 			m_Device,
@@ -71,8 +399,10 @@ namespace VulkanEngine {
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 			);
 
-		// Copy the data from the staging buffer into the vertex buffer
-		m_Device.CopyBuffer(stagingBuffer.GetBuffer(), m_VertexBuffer->GetBuffer(), bufferSize);
+		UploadToBuffer(m_VertexBuffer->GetBuffer(), vertices.data(), bufferSize);
+
+		m_MemoryUsage.VertexBytes			= bufferSize;
+		m_MemoryUsage.UnpackedVertexBytes	= sizeof(Vertex) * m_VertexCount;
 	}
 
 	void VEModel::CreateIndexBuffers(const std::vector<uint32_t>& indices)
@@ -88,19 +418,11 @@ namespace VulkanEngine {
 			return;
 		}
 
-		VkDeviceSize bufferSize = sizeof(indices[0]) * m_IndexCount;
-		uint32_t indexSize = sizeof(indices[0]);
+		// Half the index bandwidth whenever every vertex can be addressed with 16 bits
+		m_IndexType = m_VertexCount < MAX_16BIT_INDEX_VERTICES ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
 
-		VEBuffer stagingBuffer = {
-			m_Device,
-			indexSize,
-			m_IndexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-
-		stagingBuffer.Map();
-		stagingBuffer.WriteToBuffer((void*)indices.data());
+		uint32_t indexSize = m_IndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		VkDeviceSize bufferSize = static_cast<VkDeviceSize>(indexSize) * m_IndexCount;
 
 		m_IndexBuffer = std::make_unique<VEBuffer>(
 			m_Device,
@@ -110,24 +432,112 @@ namespace VulkanEngine {
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 			);
 
-		// Copy the data from the staging buffer into the index buffer
-		m_Device.CopyBuffer(stagingBuffer.GetBuffer(), m_IndexBuffer->GetBuffer(), bufferSize);
+		if (m_IndexType == VK_INDEX_TYPE_UINT16)
+		{
+			const std::vector<uint16_t> narrowed = NarrowIndices(indices);
+			UploadToBuffer(m_IndexBuffer->GetBuffer(), narrowed.data(), bufferSize);
+		}
+		else
+		{
+			UploadToBuffer(m_IndexBuffer->GetBuffer(), indices.data(), bufferSize);
+		}
+
+		m_MemoryUsage.IndexBytes			= bufferSize;
+		m_MemoryUsage.UnpackedIndexBytes	= sizeof(uint32_t) * m_IndexCount;
 	}
 
-	void VEModel::Draw(VkCommandBuffer commandBuffer)
+	void VEModel::Draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance, uint32_t lod)
 	{
-		if (m_HasIndexBuffer)
+		assert(lod < m_Lods.size() && "LOD out of range.");
+
+		const Lod& range = m_Lods[lod];
+
+		if (m_GeometryPool != nullptr)
 		{
-			vkCmdDrawIndexed(commandBuffer, m_IndexCount, 1, 0, 0, 0);
+			vkCmdDrawIndexed(commandBuffer,
+				range.IndexCount,
+				instanceCount,
+				m_GeometryRange.FirstIndex + range.FirstIndex,
+				static_cast<int32_t>(m_GeometryRange.FirstVertex),
+				firstInstance);
+		}
+		else if (m_HasIndexBuffer)
+		{
+			vkCmdDrawIndexed(commandBuffer, range.IndexCount, instanceCount, range.FirstIndex, 0, firstInstance);
 		}
 		else
 		{
-			vkCmdDraw(commandBuffer, m_VertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, m_VertexCount, instanceCount, 0, firstInstance);
+		}
+	}
+
+	VkDrawIndexedIndirectCommand VEModel::GetDrawCommand(uint32_t instanceCount, uint32_t firstInstance, uint32_t lod) const
+	{
+		assert(m_GeometryPool != nullptr && "Only pooled models can be drawn indirectly.");
+		assert(lod < m_Lods.size() && "LOD out of range.");
+
+		VkDrawIndexedIndirectCommand command = {};
+
+		command.indexCount		= m_Lods[lod].IndexCount;
+		command.instanceCount	= instanceCount;
+		command.firstIndex		= m_GeometryRange.FirstIndex + m_Lods[lod].FirstIndex;
+		command.vertexOffset	= static_cast<int32_t>(m_GeometryRange.FirstVertex);
+		command.firstInstance	= firstInstance;
+
+		return command;
+	}
+
+	uint32_t VEModel::SelectLod(float maxError) const
+	{
+		// Errors only grow with the level, so the first level past maxError ends the search
+		uint32_t lod = 0;
+
+		while (lod + 1 < m_Lods.size() && m_Lods[lod + 1].Error <= maxError)
+		{
+			lod++;
 		}
+
+		return lod;
+	}
+
+	uint32_t VEModel::CullMeshlets(const VEFrustum& frustum,
+		const glm::mat4& worldMatrix,
+		const glm::vec3& cameraPosition,
+		std::vector<uint32_t>& indices) const
+	{
+		// The cone test runs in object space, facing is the same there for any invertible affine transform
+		const glm::vec3 localCamera = glm::vec3(glm::inverse(worldMatrix) * glm::vec4(cameraPosition, 1.0f));
+		const float camera[3] = { localCamera.x, localCamera.y, localCamera.z };
+
+		uint32_t keptCount = 0;
+
+		for (const VEMeshOptimizer::Meshlet& meshlet : m_Meshlets)
+		{
+			const VEBoundingSphere sphere = { { meshlet.Center[0], meshlet.Center[1], meshlet.Center[2] }, meshlet.Radius };
+
+			if (meshlet.IsBackfacing(camera) || !frustum.Intersects(sphere.Transform(worldMatrix)))
+			{
+				continue;
+			}
+
+			indices.insert(indices.end(),
+				m_MeshletIndices.begin() + meshlet.FirstIndex,
+				m_MeshletIndices.begin() + meshlet.FirstIndex + meshlet.IndexCount);
+
+			keptCount++;
+		}
+
+		return keptCount;
 	}
 
 	void VEModel::Bind(VkCommandBuffer commandBuffer)
 	{
+		if (m_GeometryPool != nullptr)
+		{
+			m_GeometryPool->Bind(commandBuffer);
+			return;
+		}
+
 		VkBuffer buffers[] = { m_VertexBuffer->GetBuffer() };
 		VkDeviceSize offsets[] = { 0 };
 
@@ -135,34 +545,82 @@ namespace VulkanEngine {
 
 		if (m_HasIndexBuffer)
 		{
-			vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->GetBuffer(), 0, m_IndexType);
 		}
 	}
 
-	std::vector<VkVertexInputBindingDescription> VEModel::Vertex::GetBindingDescriptions()
+	std::vector<VkVertexInputBindingDescription> VEModel::PackedVertex::GetBindingDescriptions()
 	{
 		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
 
 		bindingDescriptions[0].binding = 0;
-		bindingDescriptions[0].stride = sizeof(Vertex);
+		bindingDescriptions[0].stride = sizeof(PackedVertex);
 		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
 
 		return bindingDescriptions;
 	}
 
-	std::vector<VkVertexInputAttributeDescription> VEModel::Vertex::GetAttributeDescriptions()
+	std::vector<VkVertexInputAttributeDescription> VEModel::PackedVertex::GetAttributeDescriptions()
 	{
 		std::vector<VkVertexInputAttributeDescription> attributeDescriptions = {};
 
-		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Position) });
-		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Color) });
-		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, Normal) });
-		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, UV) });
+		// All of these formats are required to support VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_SNORM, offsetof(PackedVertex, Position) });
+		attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedVertex, Color) });
+		attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SNORM, offsetof(PackedVertex, Normal) });
+		attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedVertex, UV) });
 
 		return attributeDescriptions;
 	}
 
-	void VEModel::Builder::LoadModel(const std::string& filepath)
+	// Builds the vertex referenced by a single face corner of an OBJ file
+	static VEModel::Vertex MakeVertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& index)
+	{
+		VEModel::Vertex vertex = {};
+
+		if (index.vertex_index >= 0)
+		{
+			vertex.Position = {
+				attrib.vertices[3 * index.vertex_index + 0],
+				attrib.vertices[3 * index.vertex_index + 1],
+				attrib.vertices[3 * index.vertex_index + 2]
+			};
+
+			vertex.Color = {
+				attrib.colors[3 * index.vertex_index + 0],
+				attrib.colors[3 * index.vertex_index + 1],
+				attrib.colors[3 * index.vertex_index + 2]
+			};
+		}
+
+		if (index.normal_index >= 0)
+		{
+			vertex.Normal = {
+				attrib.normals[3 * index.normal_index + 0],
+				attrib.normals[3 * index.normal_index + 1],
+				attrib.normals[3 * index.normal_index + 2]
+			};
+		}
+
+		if (index.texcoord_index >= 0)
+		{
+			vertex.UV = {
+				attrib.texcoords[2 * index.texcoord_index + 0],
+				attrib.texcoords[2 * index.texcoord_index + 1]
+			};
+		}
+
+		// The vertices are welded bit for bit, adding zero turns -0 into +0 so both zeros still weld like they do
+		// when the floats are compared
+		vertex.Position += 0.0f;
+		vertex.Color += 0.0f;
+		vertex.Normal += 0.0f;
+		vertex.UV += 0.0f;
+
+		return vertex;
+	}
+
+	void VEModel::Builder::LoadModel(const std::string& filepath, uint32_t threadCount)
 	{
 		tinyobj::attrib_t attrib;
 		std::vector<tinyobj::shape_t> shapes;
@@ -176,54 +634,285 @@ namespace VulkanEngine {
 
 		Vertices.clear();
 		Indices.clear();
+		Lods.clear();
+		Meshlets.clear();
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices = {};
+		// Flatten the face corners of every shape so they can be split into even ranges
+		std::vector<const tinyobj::index_t*> corners = {};
 
 		for (const auto& shape : shapes)
 		{
 			for (const auto& index : shape.mesh.indices)
 			{
-				Vertex vertex = {};
+				corners.push_back(&index);
+			}
+		}
+
+		if (threadCount == 0)
+		{
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+		}
+
+		// Small meshes aren't worth the cost of handing work to other threads
+		const size_t cornersPerThread = 1 << 16;
+		threadCount = static_cast<uint32_t>(std::min<size_t>(threadCount, (corners.size() + cornersPerThread - 1) / cornersPerThread));
+
+		// Every corner's vertex is appended, and removed again when the table already has an equal one
+		if (threadCount <= 1)
+		{
+			VEVertexTable uniqueVertices(sizeof(Vertex), GetExpectedVertexCount(corners.size()));
+			Indices.reserve(corners.size());
+
+			for (const auto* index : corners)
+			{
+				const uint32_t newIndex = static_cast<uint32_t>(Vertices.size());
+				Vertices.push_back(MakeVertex(attrib, *index));
 
-				if (index.vertex_index >= 0)
-				{
-					vertex.Position = {
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2]
-					};
-
-					vertex.Color = {
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2]
-					};
-				}
+				const uint32_t vertexIndex = uniqueVertices.FindOrInsert(Vertices.data(), newIndex);
 
-				if (index.normal_index >= 0)
+				if (vertexIndex != newIndex)
 				{
-					vertex.Normal = {
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					};
+					Vertices.pop_back();
 				}
 
-				if (index.texcoord_index >= 0)
+				Indices.push_back(vertexIndex);
+			}
+
+			ComputeBounds();
+			return;
+		}
+
+		// Each chunk deduplicates its own range. The unique vertices of a chunk are kept in order of first use so
+		// that merging the chunks in order produces exactly the same vertex order as the serial path
+		struct Chunk
+		{
+			size_t Begin;
+			size_t End;
+			std::vector<Vertex> Vertices;
+			std::vector<uint32_t> Indices;
+			std::vector<uint32_t> Remap;
+		};
+
+		std::vector<Chunk> chunks(threadCount);
+		VEThreadPool& threadPool = GetImportThreadPool();
+
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			chunks[i].Begin	= corners.size() * i / threadCount;
+			chunks[i].End	= corners.size() * (i + 1) / threadCount;
+		}
+
+		threadPool.Run(threadCount, [&attrib, &corners, &chunks](uint32_t chunkIndex)
+		{
+			Chunk& chunk = chunks[chunkIndex];
+
+			VEVertexTable uniqueVertices(sizeof(Vertex), GetExpectedVertexCount(chunk.End - chunk.Begin));
+			chunk.Indices.reserve(chunk.End - chunk.Begin);
+
+			for (size_t i = chunk.Begin; i < chunk.End; i++)
+			{
+				const uint32_t newIndex = static_cast<uint32_t>(chunk.Vertices.size());
+				chunk.Vertices.push_back(MakeVertex(attrib, *corners[i]));
+
+				const uint32_t vertexIndex = uniqueVertices.FindOrInsert(chunk.Vertices.data(), newIndex);
+
+				if (vertexIndex != newIndex)
 				{
-					vertex.UV = {
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1]
-					};
+					chunk.Vertices.pop_back();
 				}
 
-				if (uniqueVertices.count(vertex) == 0)
+				chunk.Indices.push_back(vertexIndex);
+			}
+		});
+
+		// Merge the chunk vertices into the final vertex buffer, recording where each local vertex ended up
+		VEVertexTable uniqueVertices(sizeof(Vertex), chunks[0].Vertices.size());
+
+		for (auto& chunk : chunks)
+		{
+			chunk.Remap.resize(chunk.Vertices.size());
+
+			for (size_t i = 0; i < chunk.Vertices.size(); i++)
+			{
+				const uint32_t newIndex = static_cast<uint32_t>(Vertices.size());
+				Vertices.push_back(chunk.Vertices[i]);
+
+				const uint32_t vertexIndex = uniqueVertices.FindOrInsert(Vertices.data(), newIndex);
+
+				if (vertexIndex != newIndex)
 				{
-					uniqueVertices[vertex] = static_cast<uint32_t>(Vertices.size());
-					Vertices.push_back(vertex);
+					Vertices.pop_back();
 				}
 
-				Indices.push_back(uniqueVertices[vertex]);
+				chunk.Remap[i] = vertexIndex;
+			}
+		}
+
+		// Translate the local indices of every chunk into the final index buffer
+		Indices.resize(corners.size());
+
+		threadPool.Run(threadCount, [this, &chunks](uint32_t chunkIndex)
+		{
+			const Chunk& chunk = chunks[chunkIndex];
+
+			for (size_t i = 0; i < chunk.Indices.size(); i++)
+			{
+				Indices[chunk.Begin + i] = chunk.Remap[chunk.Indices[i]];
+			}
+		});
+
+		ComputeBounds();
+	}
+
+	void VEModel::Builder::ComputeBounds()
+	{
+		CalculateBounds(Vertices, BoundingBox, BoundingSphere);
+	}
+
+	void VEModel::Builder::Optimize(bool optimizeOverdraw)
+	{
+		assert(Lods.empty() && "Optimize reorders the whole index buffer, it has to run before GenerateLods.");
+		assert(Meshlets.empty() && "Optimize reorders the whole index buffer, it has to run before BuildMeshlets.");
+
+		const uint32_t vertexCount = static_cast<uint32_t>(Vertices.size());
+
+		VEMeshOptimizer::OptimizeVertexCache(Indices, vertexCount);
+
+		if (optimizeOverdraw && vertexCount > 0)
+		{
+			VEMeshOptimizer::OptimizeOverdraw(Indices, &Vertices[0].Position.x, sizeof(Vertex), vertexCount);
+		}
+
+		const std::vector<uint32_t> remap = VEMeshOptimizer::OptimizeVertexFetch(Indices, vertexCount);
+
+		std::vector<Vertex> vertices(vertexCount);
+		uint32_t usedCount = 0;
+
+		for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+		{
+			if (remap[vertex] != VEMeshOptimizer::INVALID_INDEX)
+			{
+				vertices[remap[vertex]] = Vertices[vertex];
+				usedCount++;
+			}
+		}
+
+		vertices.resize(usedCount);
+		Vertices = std::move(vertices);
+
+		// Unused vertices may have stretched the bounds
+		if (usedCount != vertexCount)
+		{
+			ComputeBounds();
+		}
+	}
+
+	void VEModel::Builder::GenerateLods(uint32_t maxLodCount)
+	{
+		assert(Lods.empty() && "The builder already has LODs.");
+		assert(Meshlets.empty() && "Meshlets index LOD 0, they have to be built after GenerateLods.");
+
+		// Levels below this many triangles save too little to be worth a draw of their own
+		constexpr size_t MIN_LOD_TRIANGLES = 64;
+
+		// Keeps the coarsest levels recognisable, relative to the bounding sphere radius. Bounds the total error
+		// of every level against LOD 0, not each simplification step
+		constexpr float MAX_LOD_ERROR = 0.1f;
+
+		// A level has to drop at least a quarter of the triangles of the one before it
+		constexpr float MAX_LOD_RATIO = 0.75f;
+
+		if (BoundingBox.IsEmpty())
+		{
+			ComputeBounds();
+		}
+
+		const uint32_t vertexCount = static_cast<uint32_t>(Vertices.size());
+		const float maxError = MAX_LOD_ERROR * BoundingSphere.Radius;
+
+		Lods.push_back({ 0, static_cast<uint32_t>(Indices.size()), 0.0f });
+
+		if (Indices.empty())
+		{
+			return;
+		}
+
+		std::vector<uint32_t> previous = Indices;
+
+		while (Lods.size() < maxLodCount)
+		{
+			const size_t targetIndexCount = previous.size() / 6 * 3;
+
+			if (targetIndexCount < MIN_LOD_TRIANGLES * 3)
+			{
+				break;
+			}
+
+			// Every level is simplified from the one before, so the errors add up and each step only gets what
+			// the levels before it left of the budget
+			const float remainingError = maxError - Lods.back().Error;
+
+			if (remainingError <= 0.0f)
+			{
+				break;
+			}
+
+			std::vector<uint32_t> simplified;
+			const float error = VEMeshOptimizer::Simplify(simplified,
+				previous,
+				&Vertices[0].Position.x,
+				sizeof(Vertex),
+				vertexCount,
+				targetIndexCount,
+				remainingError);
+
+			if (simplified.size() > previous.size() * MAX_LOD_RATIO)
+			{
+				break;
+			}
+
+			VEMeshOptimizer::OptimizeVertexCache(simplified, vertexCount);
+
+			Lods.push_back({ static_cast<uint32_t>(Indices.size()), static_cast<uint32_t>(simplified.size()), Lods.back().Error + error });
+			Indices.insert(Indices.end(), simplified.begin(), simplified.end());
+
+			previous = std::move(simplified);
+		}
+	}
+
+	void VEModel::Builder::BuildMeshlets()
+	{
+		const uint32_t vertexCount = static_cast<uint32_t>(Vertices.size());
+
+		if (Indices.empty())
+		{
+			Meshlets.clear();
+			return;
+		}
+
+		const std::vector<uint32_t> lodIndices = Lods.empty()
+			? Indices
+			: std::vector<uint32_t>(Indices.begin() + Lods[0].FirstIndex, Indices.begin() + Lods[0].FirstIndex + Lods[0].IndexCount);
+
+		const float* positions = &Vertices[0].Position.x;
+
+		Meshlets = VEMeshOptimizer::BuildMeshlets(lodIndices, positions, sizeof(Vertex), vertexCount);
+
+		if (!VEMeshOptimizer::IsClosed(lodIndices, positions, sizeof(Vertex), vertexCount))
+		{
+			for (VEMeshOptimizer::Meshlet& meshlet : Meshlets)
+			{
+				meshlet.ConeCutoff = 1.0f;
+			}
+		}
+		else if (VEMeshOptimizer::GetSignedVolume(lodIndices, positions, sizeof(Vertex)) < 0.0)
+		{
+			// Wound inside out, the cones have to point the other way to stay outward
+			for (VEMeshOptimizer::Meshlet& meshlet : Meshlets)
+			{
+				meshlet.ConeAxis[0] = -meshlet.ConeAxis[0];
+				meshlet.ConeAxis[1] = -meshlet.ConeAxis[1];
+				meshlet.ConeAxis[2] = -meshlet.ConeAxis[2];
 			}
 		}
 	}
@@ -1,11 +1,16 @@
 #pragma once
 #include "VE_Buffer.h"
 #include "VE_Device.h"
+#include "VE_Frustum.h"
+#include "VE_GeometryPool.h"
+#include "VE_MeshOptimizer.h"
+#include "VE_UploadManager.h"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <memory>
 #include <vector>
 
@@ -21,9 +26,6 @@ namespace VulkanEngine {
 			glm::vec3 Normal{};
 			glm::vec2 UV{};
 
-			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
-			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
-
 			bool operator==(const Vertex& other) const
 			{
 				return Position == other.Position &&
@@ -33,32 +35,155 @@ namespace VulkanEngine {
 			}
 		};
 
+		// The vertex format in GPU memory, 20 bytes instead of Vertex's 44. Positions are snorm16 relative to the
+		// model's bounding box, normals are octahedral snorm16, colors unorm8 and UVs half floats
+		struct PackedVertex
+		{
+			int16_t Position[4];	// W is padding
+			uint8_t Color[4];		// A is padding
+			int16_t Normal[2];
+			uint16_t UV[2];
+
+			static std::vector<VkVertexInputBindingDescription> GetBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions();
+		};
+
+		// Bytes of vertex and index data the model uploads, and what it would take as Vertex and 32 bit indices
+		struct MemoryUsage
+		{
+			VkDeviceSize VertexBytes = 0;
+			VkDeviceSize IndexBytes = 0;
+			VkDeviceSize UnpackedVertexBytes = 0;
+			VkDeviceSize UnpackedIndexBytes = 0;
+
+			VkDeviceSize GetBytes() const { return VertexBytes + IndexBytes; }
+			VkDeviceSize GetSavedBytes() const { return UnpackedVertexBytes + UnpackedIndexBytes - GetBytes(); }
+		};
+
+		// A range of the model's indices that draws the whole mesh at one level of detail, LOD 0 is the full mesh
+		struct Lod
+		{
+			uint32_t FirstIndex = 0;
+			uint32_t IndexCount = 0;
+			float Error = 0.0f;		// How far the surface may be from LOD 0, in object space units
+		};
+
 		struct Builder
 		{
 			std::vector<Vertex> Vertices{};
 			std::vector<uint32_t> Indices{};
 
-			void LoadModel(const std::string& filepath);
+			// Empty when Indices holds a single level of detail
+			std::vector<Lod> Lods{};
+
+			// Split LOD 0 into meshlets, empty until BuildMeshlets
+			std::vector<VEMeshOptimizer::Meshlet> Meshlets{};
+
+			// Object space bounds, filled in by LoadModel and by the mesh cache
+			VEBoundingBox BoundingBox{};
+			VEBoundingSphere BoundingSphere{};
+
+			// A thread count of 0 uses every hardware thread. The output is identical for any thread count
+			void LoadModel(const std::string& filepath, uint32_t threadCount = 0);
+			void ComputeBounds();
+
+			// Reorders the triangles for the post transform cache and the vertices in first use order, optionally
+			// followed by sorting triangle clusters to cut overdraw. Drops vertices no triangle uses.
+			// Has to run before GenerateLods
+			void Optimize(bool optimizeOverdraw = false);
+
+			// Appends simplified copies of the mesh to Indices, each with about half the triangles of the one before,
+			// until maxLodCount levels exist or simplifying stops paying off. All levels share the vertices
+			void GenerateLods(uint32_t maxLodCount = DEFAULT_LOD_COUNT);
+
+			// Splits LOD 0 into meshlets. Their normal cones are only kept for closed meshes, the back faces of
+			// open ones can be seen and the pipeline doesn't cull them
+			void BuildMeshlets();
 		};
 
-		VEModel(VEDevice& device, const VEModel::Builder& builder);
+		// With an upload manager the buffers are filled asynchronously, see IsResident. With a geometry pool
+		// the model is packed into the pool's shared buffers when it fits, otherwise it gets its own
+		VEModel(VEDevice& device,
+			const VEModel::Builder& builder,
+			VEUploadManager* uploadManager = nullptr,
+			VEGeometryPool* geometryPool = nullptr);
 		~VEModel();
 
 		// Delete the copy constructor and copy operator
 		VEModel(const VEModel&) = delete;
 		VEModel& operator=(const VEModel&) = delete;
 
-		static std::unique_ptr<VEModel> CreateModelFromFile(VEDevice& device, const std::string& filepath);
+		static std::unique_ptr<VEModel> CreateModelFromFile(VEDevice& device,
+			const std::string& filepath,
+			VEUploadManager* uploadManager = nullptr,
+			VEGeometryPool* geometryPool = nullptr);
+
+		// True once the vertex and index data has finished uploading and the model can be drawn
+		bool IsResident();
 
 		void Bind(VkCommandBuffer commandBuffer);
-		void Draw(VkCommandBuffer commandBuffer);
+		void Draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0, uint32_t lod = 0);
+
+		const VEBoundingBox& GetBoundingBox() const { return m_BoundingBox; }
+		const VEBoundingSphere& GetBoundingSphere() const { return m_BoundingSphere; }
+
+		// Null when the model has its own buffers
+		VEGeometryPool* GetGeometryPool() const { return m_GeometryPool; }
+
+		// Indirect draw of a pooled model, the pool's buffers have to be bound
+		VkDrawIndexedIndirectCommand GetDrawCommand(uint32_t instanceCount, uint32_t firstInstance, uint32_t lod = 0) const;
+
+		// Object space position = offset + scale * packed position. Renderers fold this into the model matrix
+		const glm::vec3& GetPositionScale() const { return m_PositionScale; }
+		const glm::vec3& GetPositionOffset() const { return m_PositionOffset; }
+
+		const MemoryUsage& GetMemoryUsage() const { return m_MemoryUsage; }
+
+		uint32_t GetLodCount() const { return static_cast<uint32_t>(m_Lods.size()); }
+		const Lod& GetLod(uint32_t lod) const { return m_Lods[lod]; }
+
+		// Coarsest level whose error is at most maxError object space units
+		uint32_t SelectLod(float maxError) const;
+
+		bool HasMeshlets() const { return !m_Meshlets.empty(); }
+		uint32_t GetMeshletCount() const { return static_cast<uint32_t>(m_Meshlets.size()); }
+
+		// Appends the LOD 0 indices of every meshlet that is inside the frustum and not facing away from the camera,
+		// relative to the model's vertices like the model's own indices. Returns how many meshlets were kept
+		uint32_t CullMeshlets(const VEFrustum& frustum,
+			const glm::mat4& worldMatrix,
+			const glm::vec3& cameraPosition,
+			std::vector<uint32_t>& indices) const;
+
+		// For drawing the model's vertices with another index buffer, like the output of CullMeshlets
+		int32_t GetVertexOffset() const { return m_GeometryPool != nullptr ? static_cast<int32_t>(m_GeometryRange.FirstVertex) : 0; }
+
+		static constexpr uint32_t DEFAULT_LOD_COUNT = 5;
+
+		// Meshes with fewer vertices than this get 16 bit indices
+		static constexpr uint32_t MAX_16BIT_INDEX_VERTICES = 1u << 16;
 
 	private:
-		void CreateVertexBuffers(const std::vector<Vertex>& vertices);
+		void CreateVertexBuffers(const std::vector<PackedVertex>& vertices);
 		void CreateIndexBuffers(const std::vector<uint32_t>& indices);
+		bool CreatePooledBuffers(const std::vector<PackedVertex>& vertices, const std::vector<uint32_t>& builderIndices);
+		void UploadToBuffer(VkBuffer buffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
 
 	private:
 		VEDevice& m_Device;
+		VEUploadManager* m_UploadManager = nullptr;
+		VEUploadManager::Ticket m_UploadTicket = 0;
+		bool m_IsResident = false;
+
+		VEGeometryPool* m_GeometryPool = nullptr;
+		VEGeometryRange m_GeometryRange = {};
+
+		VEBoundingBox m_BoundingBox = {};
+		VEBoundingSphere m_BoundingSphere = {};
+
+		glm::vec3 m_PositionScale{ 1.0f };
+		glm::vec3 m_PositionOffset{ 0.0f };
+		MemoryUsage m_MemoryUsage = {};
 
 		std::unique_ptr<VEBuffer> m_VertexBuffer;
 		uint32_t m_VertexCount;
@@ -67,5 +192,13 @@ namespace VulkanEngine {
 
 		std::unique_ptr<VEBuffer> m_IndexBuffer;
 		uint32_t m_IndexCount;
+		VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
+
+		// Always at least LOD 0
+		std::vector<Lod> m_Lods;
+
+		// The meshlets keep a CPU copy of the LOD 0 indices to compact the visible ones from
+		std::vector<VEMeshOptimizer::Meshlet> m_Meshlets;
+		std::vector<uint32_t> m_MeshletIndices;
 	};
 }
\ No newline at end of file
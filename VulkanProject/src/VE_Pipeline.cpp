@@ -2,6 +2,7 @@
 #include"VE_Model.h"
 
 #include <cassert>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -109,11 +110,17 @@ namespace VulkanEngine {
 		pipelineInfo.basePipelineIndex							= -1;
 		pipelineInfo.basePipelineHandle							= VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(m_Device.Device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS)
+		auto start = std::chrono::high_resolution_clock::now();
+
+		if (vkCreateGraphicsPipelines(m_Device.Device(), m_Device.GetPipelineCache(), 1, &pipelineInfo, nullptr, &m_GraphicsPipeline) != VK_SUCCESS)
 		{
 			throw std::runtime_error("Failed to create the graphics pipeline");
 		}
 
+		float createTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+		std::cout << "Pipeline " << vertShaderPath << " created in " << createTime << " ms ("
+			<< (m_Device.IsPipelineCacheWarm() ? "warm" : "cold") << " cache)" << std::endl;
+
 	}
 
 	void VEPipeline::CreateShaderModule(const std::vector<char>& shader, VkShaderModule* shaderModule)
@@ -207,8 +214,8 @@ namespace VulkanEngine {
 		configInfo.DynamicStateInfo.dynamicStateCount			= static_cast<uint32_t>(configInfo.DynamicStateEnables.size());
 		configInfo.DynamicStateInfo.flags						= 0;
 
-		configInfo.BindingDescriptions							= VEModel::Vertex::GetBindingDescriptions();
-		configInfo.AttributeDescriptions						= VEModel::Vertex::GetAttributeDescriptions();
+		configInfo.BindingDescriptions							= VEModel::PackedVertex::GetBindingDescriptions();
+		configInfo.AttributeDescriptions						= VEModel::PackedVertex::GetAttributeDescriptions();
 	}
 	void VEPipeline::EnableAlphaBlending(PipelineConfigInfo& configInfo)
 	{
@@ -0,0 +1,323 @@
+#include "VE_Scene.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace VulkanEngine {
+
+	// The batch writes tightly packed column major matrices straight into these
+	static_assert(sizeof(glm::mat4) == 16 * sizeof(float) && sizeof(glm::mat3) == 9 * sizeof(float),
+		"glm matrices must not be padded");
+
+	VEEntity VEScene::CreateEntity()
+	{
+		VEEntity entity = m_NextEntity;
+
+		if (!m_FreeEntities.empty())
+		{
+			entity = m_FreeEntities.back();
+			m_FreeEntities.pop_back();
+		}
+		else
+		{
+			m_NextEntity++;
+		}
+
+		m_Transforms.Add(entity);
+
+		// A new root at the end of the array keeps parents before children
+		if (!m_HierarchyChanged)
+		{
+			m_ParentIndices.push_back(VEComponentPool<VEEntity>::INVALID_INDEX);
+		}
+
+		return entity;
+	}
+
+	void VEScene::DestroyEntity(VEEntity entity)
+	{
+		if (!IsAlive(entity))
+		{
+			return;
+		}
+
+		// Detach the children first, removing entries moves the last one into the hole
+		for (uint32_t i = m_Parents.Size(); i > 0; i--)
+		{
+			if (m_Parents.GetComponents()[i - 1] == entity)
+			{
+				m_Parents.Remove(m_Parents.GetEntities()[i - 1]);
+			}
+		}
+
+		m_Transforms.Remove(entity);
+		m_Models.Remove(entity);
+		m_PointLights.Remove(entity);
+		m_Parents.Remove(entity);
+
+		m_FreeEntities.push_back(entity);
+
+		// The last transform moved into the hole, possibly ahead of its parent
+		m_HierarchyChanged = true;
+	}
+
+	void VEScene::SetParent(VEEntity child, VEEntity parent)
+	{
+		assert(IsAlive(child) && "Entity has been destroyed.");
+
+		if (parent == NULL_ENTITY)
+		{
+			m_Parents.Remove(child);
+			m_HierarchyChanged = true;
+			return;
+		}
+
+		assert(IsAlive(parent) && "Parent has been destroyed.");
+
+		for (VEEntity ancestor = parent; ancestor != NULL_ENTITY; ancestor = GetParent(ancestor))
+		{
+			if (ancestor == child)
+			{
+				throw std::runtime_error("Parenting an entity to its own descendant would create a cycle!");
+			}
+		}
+
+		if (auto* existing = m_Parents.Find(child))
+		{
+			*existing = parent;
+		}
+		else
+		{
+			m_Parents.Add(child, parent);
+		}
+
+		m_HierarchyChanged = true;
+	}
+
+	VEEntity VEScene::GetParent(VEEntity entity) const
+	{
+		return m_Parents.Has(entity) ? m_Parents.Get(entity) : NULL_ENTITY;
+	}
+
+	VEEntity VEScene::CreatePointLight(float intensity, float radius, glm::vec3 color, float influenceRadius)
+	{
+		VEEntity entity = CreateEntity();
+
+		GetTransform(entity).SetScale({ radius, 1.0f, 1.0f });
+
+		PointLightComponent light = {};
+		light.Color				= color;
+		light.LightIntensity	= intensity;
+		light.Radius			= influenceRadius;
+
+		m_PointLights.Add(entity, light);
+
+		return entity;
+	}
+
+	void VEScene::Reserve(uint32_t entityCount, uint32_t pointLightCount)
+	{
+		m_Transforms.Reserve(entityCount);
+		m_Models.Reserve(entityCount);
+		m_PointLights.Reserve(pointLightCount);
+	}
+
+	uint32_t VEScene::UpdateTransforms()
+	{
+		if (m_HierarchyChanged)
+		{
+			SortHierarchy();
+		}
+
+		UpdateLocalMatrices();
+		UpdateWorldMatrices();
+
+		// A changed hierarchy has been propagated in full, the next frame only follows changed transforms
+		m_HierarchyChanged = false;
+
+		return m_UpdatedTransformCount;
+	}
+
+	void VEScene::SortHierarchy()
+	{
+		const uint32_t count = m_Transforms.Size();
+		const VEEntity* entities = m_Transforms.GetEntities();
+
+		// Depth of every entity, walking up each chain only as far as the first ancestor with a known depth
+		constexpr uint32_t UNKNOWN_DEPTH = ~0u;
+		std::vector<uint32_t> depths(m_NextEntity, UNKNOWN_DEPTH);
+		std::vector<VEEntity> chain;
+		uint32_t maxDepth = 0;
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			VEEntity entity = entities[i];
+
+			while (depths[entity] == UNKNOWN_DEPTH)
+			{
+				chain.push_back(entity);
+
+				const VEEntity parent = GetParent(entity);
+
+				if (parent == NULL_ENTITY)
+				{
+					depths[entity] = 0;
+					chain.pop_back();
+					break;
+				}
+
+				entity = parent;
+			}
+
+			for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			{
+				depths[*it] = depths[entity] + 1;
+				entity = *it;
+			}
+
+			maxDepth = std::max(maxDepth, depths[entity]);
+			chain.clear();
+		}
+
+		// Counting sort by depth gives a breadth-first order and keeps siblings in their current order
+		std::vector<uint32_t> offsets(static_cast<size_t>(maxDepth) + 2, 0);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			offsets[depths[entities[i]] + 1]++;
+		}
+
+		for (uint32_t depth = 1; depth < offsets.size(); depth++)
+		{
+			offsets[depth] += offsets[depth - 1];
+		}
+
+		std::vector<VEEntity> order(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			order[offsets[depths[entities[i]]]++] = entities[i];
+		}
+
+		m_Transforms.Reorder(order);
+
+		m_ParentIndices.resize(count);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const VEEntity parent = GetParent(order[i]);
+			m_ParentIndices[i] = parent == NULL_ENTITY ? VEComponentPool<VEEntity>::INVALID_INDEX : m_Transforms.GetIndex(parent);
+		}
+	}
+
+	void VEScene::UpdateLocalMatrices()
+	{
+		TransformComponent* transforms = m_Transforms.GetComponents();
+
+		// Reparenting changes the world matrix without touching the local one, so a changed hierarchy updates everything
+		m_WorldChanged.assign(m_Transforms.Size(), m_HierarchyChanged ? 1 : 0);
+		m_DirtyTransforms.clear();
+
+		for (uint32_t i = 0; i < m_Transforms.Size(); i++)
+		{
+			if (transforms[i].IsDirty())
+			{
+				m_DirtyTransforms.push_back(i);
+				m_WorldChanged[i] = 1;
+			}
+		}
+
+		m_UpdatedTransformCount = static_cast<uint32_t>(m_DirtyTransforms.size());
+
+		// Below one SIMD block, gathering into the batch costs more than it saves
+		if (m_UpdatedTransformCount < VETransformBatch::PADDING)
+		{
+			for (uint32_t index : m_DirtyTransforms)
+			{
+				transforms[index].Update();
+			}
+
+			return;
+		}
+
+		m_TransformBatch.Clear();
+		m_TransformBatch.Reserve(m_UpdatedTransformCount);
+
+		for (uint32_t index : m_DirtyTransforms)
+		{
+			const TransformComponent& transform = transforms[index];
+			m_TransformBatch.Add(&transform.GetTranslation().x, &transform.GetRotation().x, &transform.GetScale().x);
+		}
+
+		m_BatchMatrices.resize(m_UpdatedTransformCount);
+		m_BatchNormalMatrices.resize(m_UpdatedTransformCount);
+
+		m_TransformBatch.Compute(&m_BatchMatrices[0][0][0], &m_BatchNormalMatrices[0][0][0]);
+
+		for (uint32_t i = 0; i < m_UpdatedTransformCount; i++)
+		{
+			transforms[m_DirtyTransforms[i]].SetLocalMatrices(m_BatchMatrices[i], m_BatchNormalMatrices[i]);
+		}
+	}
+
+	void VEScene::UpdateWorldMatrices()
+	{
+		TransformComponent* transforms = m_Transforms.GetComponents();
+
+		m_UpdatedWorldCount = 0;
+
+		// Parents come first, so a parent's world matrix is final before any of its children read it
+		for (uint32_t i = 0; i < m_Transforms.Size(); i++)
+		{
+			const uint32_t parent = m_ParentIndices[i];
+
+			if (parent != VEComponentPool<VEEntity>::INVALID_INDEX)
+			{
+				m_WorldChanged[i] |= m_WorldChanged[parent];
+			}
+
+			if (!m_WorldChanged[i])
+			{
+				continue;
+			}
+
+			TransformComponent& transform = transforms[i];
+
+			if (parent == VEComponentPool<VEEntity>::INVALID_INDEX)
+			{
+				transform.SetWorldMatrices(transform.GetLocalMatrix(), transform.GetLocalNormalMatrix());
+			}
+			else
+			{
+				transform.SetWorldMatrices(transforms[parent].GetWorldMatrix() * transform.GetLocalMatrix(),
+					transforms[parent].GetWorldNormalMatrix() * transform.GetLocalNormalMatrix());
+			}
+
+			m_UpdatedWorldCount++;
+		}
+	}
+
+	void VEScene::SetModel(VEEntity entity, std::shared_ptr<VEModel> model)
+	{
+		assert(IsAlive(entity) && "Entity has been destroyed.");
+
+		if (model == nullptr)
+		{
+			m_Models.Remove(entity);
+		}
+		else if (auto* existing = m_Models.Find(entity))
+		{
+			*existing = std::move(model);
+		}
+		else
+		{
+			m_Models.Add(entity, std::move(model));
+		}
+	}
+
+	VEModel* VEScene::GetModel(VEEntity entity)
+	{
+		auto* model = m_Models.Find(entity);
+		return model != nullptr ? model->get() : nullptr;
+	}
+}
\ No newline at end of file
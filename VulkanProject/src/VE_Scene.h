@@ -0,0 +1,233 @@
+#pragma once
+#include "VE_GameObject.h"
+#include "VE_TransformBatch.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace VulkanEngine {
+
+	using VEEntity = uint32_t;
+
+	constexpr VEEntity NULL_ENTITY = ~0u;
+
+	// Sparse set of one component type. The components are packed into one array in no particular order,
+	// and the sparse array maps an entity to its slot, so lookups are O(1) and iteration never skips holes
+	template<typename T>
+	class VEComponentPool
+	{
+	public:
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		bool Has(VEEntity entity) const
+		{
+			return entity < m_Sparse.size() && m_Sparse[entity] != INVALID_INDEX;
+		}
+
+		T& Add(VEEntity entity, T component = {})
+		{
+			assert(!Has(entity) && "Entity already has this component.");
+
+			if (entity >= m_Sparse.size())
+			{
+				m_Sparse.resize(static_cast<size_t>(entity) + 1, INVALID_INDEX);
+			}
+
+			m_Sparse[entity] = static_cast<uint32_t>(m_Components.size());
+			m_Entities.push_back(entity);
+			m_Components.push_back(std::move(component));
+
+			return m_Components.back();
+		}
+
+		// Moves the last component into the hole, so the arrays stay packed
+		void Remove(VEEntity entity)
+		{
+			if (!Has(entity))
+			{
+				return;
+			}
+
+			const uint32_t index = m_Sparse[entity];
+			const VEEntity last = m_Entities.back();
+
+			m_Components[index] = std::move(m_Components.back());
+			m_Entities[index] = last;
+			m_Sparse[last] = index;
+
+			m_Components.pop_back();
+			m_Entities.pop_back();
+			m_Sparse[entity] = INVALID_INDEX;
+		}
+
+		T& Get(VEEntity entity)
+		{
+			assert(Has(entity) && "Entity does not have this component.");
+			return m_Components[m_Sparse[entity]];
+		}
+
+		const T& Get(VEEntity entity) const
+		{
+			assert(Has(entity) && "Entity does not have this component.");
+			return m_Components[m_Sparse[entity]];
+		}
+
+		T* Find(VEEntity entity) { return Has(entity) ? &m_Components[m_Sparse[entity]] : nullptr; }
+
+		// Slot of the entity in the packed arrays
+		uint32_t GetIndex(VEEntity entity) const { return Has(entity) ? m_Sparse[entity] : INVALID_INDEX; }
+
+		// Rearranges the packed arrays to follow order, which must list every entity in the pool exactly once
+		void Reorder(const std::vector<VEEntity>& order)
+		{
+			assert(order.size() == m_Entities.size() && "Order must contain every entity in the pool.");
+
+			std::vector<T> components;
+			components.reserve(order.size());
+
+			for (VEEntity entity : order)
+			{
+				components.push_back(std::move(m_Components[m_Sparse[entity]]));
+			}
+
+			for (uint32_t i = 0; i < order.size(); i++)
+			{
+				m_Sparse[order[i]] = i;
+			}
+
+			m_Components = std::move(components);
+			m_Entities = order;
+		}
+
+		void Reserve(uint32_t count)
+		{
+			m_Entities.reserve(count);
+			m_Components.reserve(count);
+		}
+
+		uint32_t Size() const { return static_cast<uint32_t>(m_Components.size()); }
+		bool Empty() const { return m_Components.empty(); }
+
+		// Packed arrays, entity i owns component i. Pointers are invalidated by Add and Remove
+		VEEntity* GetEntities() { return m_Entities.data(); }
+		const VEEntity* GetEntities() const { return m_Entities.data(); }
+		T* GetComponents() { return m_Components.data(); }
+		const T* GetComponents() const { return m_Components.data(); }
+
+	private:
+		std::vector<uint32_t> m_Sparse;
+		std::vector<VEEntity> m_Entities;
+		std::vector<T> m_Components;
+	};
+
+	// Owns every entity of a scene and stores each component type in its own packed array.
+	// Every entity has a transform, models and point lights are optional.
+	// Transforms are kept sorted by depth in the hierarchy, parents before children, so world matrices
+	// are propagated in one pass over the packed array
+	class VEScene
+	{
+	public:
+		VEScene() = default;
+
+		// Delete the copy constructor and copy operator
+		VEScene(const VEScene&) = delete;
+		VEScene& operator=(const VEScene&) = delete;
+
+		// Ids of destroyed entities are reused, so handles must not outlive DestroyEntity.
+		// The children of a destroyed entity become roots and keep their local transform
+		VEEntity CreateEntity();
+		void DestroyEntity(VEEntity entity);
+
+		// NULL_ENTITY makes the child a root again. The local transform is kept, so the child follows its new parent
+		void SetParent(VEEntity child, VEEntity parent);
+		VEEntity GetParent(VEEntity entity) const;
+
+		// Radius is the size of the light's billboard, influenceRadius how far the light reaches
+		VEEntity CreatePointLight(float intensity = 10.0f,
+			float radius = 0.1f,
+			glm::vec3 color = glm::vec3(1.0f),
+			float influenceRadius = 5.0f);
+
+		// Point lights are usually far fewer than the entities, so they are reserved separately
+		void Reserve(uint32_t entityCount, uint32_t pointLightCount = 0);
+
+		bool IsAlive(VEEntity entity) const { return m_Transforms.Has(entity); }
+		uint32_t GetEntityCount() const { return m_Transforms.Size(); }
+
+		TransformComponent& GetTransform(VEEntity entity) { return m_Transforms.Get(entity); }
+
+		void SetModel(VEEntity entity, std::shared_ptr<VEModel> model);
+		VEModel* GetModel(VEEntity entity);
+
+		PointLightComponent* GetPointLight(VEEntity entity) { return m_PointLights.Find(entity); }
+
+		// Recomputes the local matrices of every transform changed since the last call, then the world matrices of
+		// those transforms and their descendants. Once per frame before rendering.
+		// Many changed transforms are computed together with SIMD, a few are updated one at a time
+		uint32_t UpdateTransforms();
+		uint32_t GetUpdatedTransformCount() const { return m_UpdatedTransformCount; }
+		uint32_t GetUpdatedWorldCount() const { return m_UpdatedWorldCount; }
+
+		VEComponentPool<TransformComponent>& GetTransforms() { return m_Transforms; }
+		VEComponentPool<std::shared_ptr<VEModel>>& GetModels() { return m_Models; }
+		VEComponentPool<PointLightComponent>& GetPointLights() { return m_PointLights; }
+
+		// fn(VEEntity, VEModel*, TransformComponent&) for every entity with a model
+		template<typename Fn>
+		void ForEachModel(Fn&& fn)
+		{
+			const VEEntity* entities = m_Models.GetEntities();
+			std::shared_ptr<VEModel>* models = m_Models.GetComponents();
+
+			for (uint32_t i = 0; i < m_Models.Size(); i++)
+			{
+				fn(entities[i], models[i].get(), m_Transforms.Get(entities[i]));
+			}
+		}
+
+		// fn(VEEntity, PointLightComponent&, TransformComponent&) for every point light
+		template<typename Fn>
+		void ForEachPointLight(Fn&& fn)
+		{
+			const VEEntity* entities = m_PointLights.GetEntities();
+			PointLightComponent* lights = m_PointLights.GetComponents();
+
+			for (uint32_t i = 0; i < m_PointLights.Size(); i++)
+			{
+				fn(entities[i], lights[i], m_Transforms.Get(entities[i]));
+			}
+		}
+
+	private:
+		// Sorts the transforms by depth and finds the slot of every parent
+		void SortHierarchy();
+		void UpdateLocalMatrices();
+		void UpdateWorldMatrices();
+
+	private:
+		VEComponentPool<TransformComponent> m_Transforms;
+		VEComponentPool<std::shared_ptr<VEModel>> m_Models;
+		VEComponentPool<PointLightComponent> m_PointLights;
+
+		std::vector<VEEntity> m_FreeEntities;
+		VEEntity m_NextEntity = 0;
+
+		uint32_t m_UpdatedTransformCount = 0;
+		uint32_t m_UpdatedWorldCount = 0;
+
+		// Parent entity of every child. Parallel to the transforms, the parent's slot and whether the world matrix changed
+		VEComponentPool<VEEntity> m_Parents;
+		std::vector<uint32_t> m_ParentIndices;
+		std::vector<uint8_t> m_WorldChanged;
+		bool m_HierarchyChanged = false;
+
+		// Reused every frame to avoid allocating while gathering the dirty transforms
+		std::vector<uint32_t> m_DirtyTransforms;
+		VETransformBatch m_TransformBatch;
+		std::vector<glm::mat4> m_BatchMatrices;
+		std::vector<glm::mat3> m_BatchNormalMatrices;
+	};
+}
\ No newline at end of file
@@ -27,7 +27,15 @@ namespace VulkanEngine {
 
     void VESwapChain::Init()
     {
-        CreateSwapChain();
+        if (m_Device.IsHeadless())
+        {
+            CreateOffscreenImages();
+        }
+        else
+        {
+            CreateSwapChain();
+        }
+
         CreateImageViews();
         CreateRenderPass();
         CreateDepthResources();
@@ -49,6 +57,12 @@ namespace VulkanEngine {
             m_SwapChain = nullptr;
         }
 
+        for (size_t i = 0; i < m_OffscreenImageMemories.size(); i++)
+        {
+            vkDestroyImage(m_Device.Device(), m_SwapChainImages[i], nullptr);
+            vkFreeMemory(m_Device.Device(), m_OffscreenImageMemories[i], nullptr);
+        }
+
         for (int i = 0; i < m_DepthImages.size(); i++)
         {
             vkDestroyImageView(m_Device.Device(), m_DepthImageViews[i], nullptr);
@@ -80,6 +94,13 @@ namespace VulkanEngine {
             VK_TRUE,
             std::numeric_limits<uint64_t>::max());
 
+        // There is one offscreen image per frame in flight, so the fence above also guards the image
+        if (m_Device.IsHeadless())
+        {
+            *imageIndex = static_cast<uint32_t>(m_CurrentFrame);
+            return VK_SUCCESS;
+        }
+
         VkResult result = vkAcquireNextImageKHR(m_Device.Device(),
             m_SwapChain,
             std::numeric_limits<uint64_t>::max(),
@@ -103,9 +124,12 @@ namespace VulkanEngine {
 
         submitInfo.sType                                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+        // Nothing was acquired from or is presented to a swap chain when headless, so there are no semaphores
+        const uint32_t semaphoreCount                   = m_Device.IsHeadless() ? 0 : 1;
+
         VkSemaphore waitSemaphores[]                    = { m_ImageAvailableSemaphores[m_CurrentFrame] };
         VkPipelineStageFlags waitStages[]               = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-        submitInfo.waitSemaphoreCount                   = 1;
+        submitInfo.waitSemaphoreCount                   = semaphoreCount;
         submitInfo.pWaitSemaphores                      = waitSemaphores;
         submitInfo.pWaitDstStageMask                    = waitStages;
 
@@ -113,7 +137,7 @@ namespace VulkanEngine {
         submitInfo.pCommandBuffers                      = buffers;
 
         VkSemaphore signalSemaphores[]                  = { m_RenderFinishedSemaphores[m_CurrentFrame] };
-        submitInfo.signalSemaphoreCount                 = 1;
+        submitInfo.signalSemaphoreCount                 = semaphoreCount;
         submitInfo.pSignalSemaphores                    = signalSemaphores;
 
         vkResetFences(m_Device.Device(), 1, &m_InFlightFences[m_CurrentFrame]);
@@ -123,6 +147,12 @@ namespace VulkanEngine {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
 
+        if (m_Device.IsHeadless())
+        {
+            m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+            return VK_SUCCESS;
+        }
+
         VkPresentInfoKHR presentInfo = {};
 
         presentInfo.sType                               = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -211,6 +241,44 @@ namespace VulkanEngine {
         m_SwapChainExtent                               = extent;
     }
 
+    void VESwapChain::CreateOffscreenImages()
+    {
+        m_SwapChainImageFormat                          = m_Device.FindSupportedFormat({ VK_FORMAT_B8G8R8A8_UNORM,
+            VK_FORMAT_R8G8B8A8_UNORM },
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_BLEND_BIT);
+        m_SwapChainExtent                               = m_WindowExtent;
+
+        m_SwapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+        m_OffscreenImageMemories.resize(MAX_FRAMES_IN_FLIGHT);
+
+        for (size_t i = 0; i < m_SwapChainImages.size(); i++)
+        {
+            VkImageCreateInfo imageInfo = {};
+
+            imageInfo.sType                             = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType                         = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width                      = m_SwapChainExtent.width;
+            imageInfo.extent.height                     = m_SwapChainExtent.height;
+            imageInfo.extent.depth                      = 1;
+            imageInfo.mipLevels                         = 1;
+            imageInfo.arrayLayers                       = 1;
+            imageInfo.format                            = m_SwapChainImageFormat;
+            imageInfo.tiling                            = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout                     = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage                             = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples                           = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode                       = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.flags = 0;
+
+            m_Device.CreateImageWithInfo(
+                imageInfo,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                m_SwapChainImages[i],
+                m_OffscreenImageMemories[i]);
+        }
+    }
+
     void VESwapChain::CreateImageViews()
     {
         m_SwapChainImageViews.resize(m_SwapChainImages.size());
@@ -264,7 +332,8 @@ namespace VulkanEngine {
         colorAttachment.stencilStoreOp                  = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp                   = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout                   = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout                     = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        // Offscreen images are left ready to be copied out for comparisons
+        colorAttachment.finalLayout                     = m_Device.IsHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         VkAttachmentReference colorAttachmentRef = {};
 
@@ -11,6 +11,8 @@
 
 namespace VulkanEngine {
 
+    // Presents to the window's surface, or on a headless device renders into offscreen color images that are
+    // never presented, with the same frame pacing, so the rest of the renderer does not need to know the difference
     class VESwapChain {
     public:
         static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
@@ -48,6 +50,7 @@ namespace VulkanEngine {
     private:
         void Init();
         void CreateSwapChain();
+        void CreateOffscreenImages();
         void CreateImageViews();
         void CreateDepthResources();
         void CreateRenderPass();
@@ -73,10 +76,13 @@ namespace VulkanEngine {
         std::vector<VkImage> m_SwapChainImages;
         std::vector<VkImageView> m_SwapChainImageViews;
 
+        // Only used when headless, the swap chain owns its images otherwise
+        std::vector<VkDeviceMemory> m_OffscreenImageMemories;
+
         VEDevice& m_Device;
         VkExtent2D m_WindowExtent;
 
-        VkSwapchainKHR m_SwapChain;
+        VkSwapchainKHR m_SwapChain = VK_NULL_HANDLE;
         std::shared_ptr<VESwapChain> m_OldSwapChain;
 
         std::vector<VkSemaphore> m_ImageAvailableSemaphores;
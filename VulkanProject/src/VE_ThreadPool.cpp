@@ -0,0 +1,87 @@
+#include "VE_ThreadPool.h"
+
+namespace VulkanEngine {
+
+	VEThreadPool::~VEThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Stopping = true;
+		}
+
+		m_WorkReady.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void VEThreadPool::Run(uint32_t taskCount, const std::function<void(uint32_t)>& task)
+	{
+		if (taskCount == 0)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> runLock(m_RunMutex);
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		// The calling thread runs tasks too, so one worker fewer than tasks keeps every task on its own thread
+		while (m_Workers.size() + 1 < taskCount)
+		{
+			m_Workers.emplace_back(&VEThreadPool::WorkerLoop, this);
+		}
+
+		m_Task = &task;
+		m_TaskCount = taskCount;
+		m_NextTask = 0;
+		m_FinishedTasks = 0;
+
+		m_WorkReady.notify_all();
+
+		while (m_NextTask < m_TaskCount)
+		{
+			const uint32_t index = m_NextTask++;
+
+			lock.unlock();
+			task(index);
+			lock.lock();
+
+			m_FinishedTasks++;
+		}
+
+		m_WorkDone.wait(lock, [this]() { return m_FinishedTasks == m_TaskCount; });
+
+		m_Task = nullptr;
+		m_TaskCount = 0;
+		m_NextTask = 0;
+	}
+
+	void VEThreadPool::WorkerLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		while (true)
+		{
+			m_WorkReady.wait(lock, [this]() { return m_Stopping || m_NextTask < m_TaskCount; });
+
+			if (m_Stopping)
+			{
+				return;
+			}
+
+			const uint32_t index = m_NextTask++;
+			const std::function<void(uint32_t)>& task = *m_Task;
+
+			lock.unlock();
+			task(index);
+			lock.lock();
+
+			if (++m_FinishedTasks == m_TaskCount)
+			{
+				m_WorkDone.notify_all();
+			}
+		}
+	}
+}
\ No newline at end of file
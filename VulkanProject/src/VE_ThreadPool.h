@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Worker threads that are started once and then reused, so splitting work over threads doesn't pay thread
+	// startup every time. Workers are only created when a Run needs more of them than exist
+	class VEThreadPool
+	{
+	public:
+		VEThreadPool() = default;
+		~VEThreadPool();
+
+		// Delete the copy constructor and copy operator
+		VEThreadPool(const VEThreadPool&) = delete;
+		VEThreadPool& operator=(const VEThreadPool&) = delete;
+
+		// Calls task(i) for every i below taskCount, each on its own thread with the calling thread taking part.
+		// Returns once every task has finished. Runs from several threads at once take turns
+		void Run(uint32_t taskCount, const std::function<void(uint32_t)>& task);
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_Workers;
+
+		// Held for a whole Run, m_Mutex guards the task state below
+		std::mutex m_RunMutex;
+		std::mutex m_Mutex;
+		std::condition_variable m_WorkReady;
+		std::condition_variable m_WorkDone;
+
+		const std::function<void(uint32_t)>* m_Task = nullptr;
+		uint32_t m_TaskCount = 0;
+		uint32_t m_NextTask = 0;
+		uint32_t m_FinishedTasks = 0;
+		bool m_Stopping = false;
+	};
+}
\ No newline at end of file
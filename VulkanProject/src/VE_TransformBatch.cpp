@@ -0,0 +1,325 @@
+#include "VE_TransformBatch.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	#define VE_TRANSFORM_X86
+	#include <immintrin.h>
+
+	#ifdef _MSC_VER
+		#define VE_TARGET_AVX2
+	#else
+		#define VE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+	#endif
+#endif
+
+namespace VulkanEngine {
+
+	// The kernels produce 9 rotation * scale and 9 rotation / scale values per transform before they are
+	// written out as matrices. The translation is copied straight from the input arrays
+	static constexpr uint32_t LANE_VALUES = 18;
+
+	// Cody-Waite split of pi / 2, so the range reduction stays exact for the angles a transform uses
+	static constexpr float TWO_OVER_PI		= 0.636619772367581343f;
+	static constexpr float HALF_PI_1		= 1.5703125f;
+	static constexpr float HALF_PI_2		= 4.837512969970703125e-4f;
+	static constexpr float HALF_PI_3		= 7.54978995489188216e-8f;
+
+	// Minimax polynomials for sin and cos on [-pi / 4, pi / 4] (Cephes)
+	static constexpr float SIN_0			= -1.6666654611e-1f;
+	static constexpr float SIN_1			= 8.3321608736e-3f;
+	static constexpr float SIN_2			= -1.9515295891e-4f;
+	static constexpr float COS_0			= 4.166664568298827e-2f;
+	static constexpr float COS_1			= -1.388731625493765e-3f;
+	static constexpr float COS_2			= 2.443315711809948e-5f;
+
+	void VETransformBatch::Clear()
+	{
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_Translation[axis].clear();
+			m_Rotation[axis].clear();
+			m_Scale[axis].clear();
+		}
+
+		m_Count = 0;
+	}
+
+	void VETransformBatch::Reserve(uint32_t count)
+	{
+		const size_t padded = (count + PADDING - 1) / PADDING * PADDING;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_Translation[axis].reserve(padded);
+			m_Rotation[axis].reserve(padded);
+			m_Scale[axis].reserve(padded);
+		}
+	}
+
+	uint32_t VETransformBatch::Add(const float* translation, const float* rotation, const float* scale)
+	{
+		// Grow a whole block at a time. Padding transforms have a unit scale so the kernels never divide by zero
+		if (m_Count % PADDING == 0)
+		{
+			const size_t padded = m_Count + PADDING;
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				m_Translation[axis].resize(padded, 0.0f);
+				m_Rotation[axis].resize(padded, 0.0f);
+				m_Scale[axis].resize(padded, 1.0f);
+			}
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_Translation[axis][m_Count] = translation[axis];
+			m_Rotation[axis][m_Count] = rotation[axis];
+			m_Scale[axis][m_Count] = scale[axis];
+		}
+
+		return m_Count++;
+	}
+
+	void VETransformBatch::Compute(float* matrices, float* normalMatrices) const
+	{
+		Compute(matrices, normalMatrices, VECulling::GetBestPath());
+	}
+
+	void VETransformBatch::Compute(float* matrices, float* normalMatrices, VECulling::Path path) const
+	{
+		switch (path)
+		{
+		case VECulling::Path::AVX2:	ComputeAVX2(matrices, normalMatrices); break;
+		case VECulling::Path::SSE:	ComputeSSE(matrices, normalMatrices); break;
+		default:					ComputeScalar(matrices, normalMatrices); break;
+		}
+	}
+
+	void VETransformBatch::ComputeScalar(float* matrices, float* normalMatrices) const
+	{
+		for (uint32_t i = 0; i < m_Count; i++)
+		{
+			// Same expressions in the same order as TransformComponent, so the results are identical
+			const float c3 = std::cos(m_Rotation[2][i]);
+			const float s3 = std::sin(m_Rotation[2][i]);
+			const float c2 = std::cos(m_Rotation[0][i]);
+			const float s2 = std::sin(m_Rotation[0][i]);
+			const float c1 = std::cos(m_Rotation[1][i]);
+			const float s1 = std::sin(m_Rotation[1][i]);
+
+			const float axisX[3] = { c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 };
+			const float axisY[3] = { c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 };
+			const float axisZ[3] = { c2 * s1, -s2, c1 * c2 };
+			const float* axes[3] = { axisX, axisY, axisZ };
+
+			float* matrix = matrices + static_cast<size_t>(i) * 16;
+			float* normalMatrix = normalMatrices + static_cast<size_t>(i) * 9;
+
+			for (int column = 0; column < 3; column++)
+			{
+				const float scale = m_Scale[column][i];
+				const float invScale = 1.0f / scale;
+
+				for (int row = 0; row < 3; row++)
+				{
+					matrix[column * 4 + row] = scale * axes[column][row];
+					normalMatrix[column * 3 + row] = invScale * axes[column][row];
+				}
+
+				matrix[column * 4 + 3] = 0.0f;
+				matrix[12 + column] = m_Translation[column][i];
+			}
+
+			matrix[15] = 1.0f;
+		}
+	}
+
+#ifdef VE_TRANSFORM_X86
+	// Writes the lanes of the transforms that exist, lanes holds LANE_VALUES rows of WIDTH floats
+	template<uint32_t WIDTH>
+	static inline void StoreLanes(const float* lanes, uint32_t first, uint32_t count,
+		const std::vector<float>* translation, float* matrices, float* normalMatrices)
+	{
+		for (uint32_t lane = 0; lane < WIDTH && first + lane < count; lane++)
+		{
+			const uint32_t i = first + lane;
+
+			float* matrix = matrices + static_cast<size_t>(i) * 16;
+			float* normalMatrix = normalMatrices + static_cast<size_t>(i) * 9;
+
+			for (int column = 0; column < 3; column++)
+			{
+				for (int row = 0; row < 3; row++)
+				{
+					matrix[column * 4 + row] = lanes[(column * 3 + row) * WIDTH + lane];
+					normalMatrix[column * 3 + row] = lanes[(9 + column * 3 + row) * WIDTH + lane];
+				}
+
+				matrix[column * 4 + 3] = 0.0f;
+				matrix[12 + column] = translation[column][i];
+			}
+
+			matrix[15] = 1.0f;
+		}
+	}
+
+	static inline void SinCosSSE(__m128 x, __m128& sine, __m128& cosine)
+	{
+		// Reduce to [-pi / 4, pi / 4] and remember the quadrant
+		const __m128i quadrant = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(TWO_OVER_PI)));
+		const __m128 q = _mm_cvtepi32_ps(quadrant);
+
+		__m128 y = _mm_sub_ps(x, _mm_mul_ps(q, _mm_set1_ps(HALF_PI_1)));
+		y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(HALF_PI_2)));
+		y = _mm_sub_ps(y, _mm_mul_ps(q, _mm_set1_ps(HALF_PI_3)));
+
+		const __m128 z = _mm_mul_ps(y, y);
+
+		__m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(SIN_2), z), _mm_set1_ps(SIN_1));
+		s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(SIN_0));
+		s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), y), y);
+
+		__m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(COS_2), z), _mm_set1_ps(COS_1));
+		c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(COS_0));
+		c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+		c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(_mm_set1_ps(0.5f), z)), _mm_set1_ps(1.0f));
+
+		// Odd quadrants swap sin and cos, the sign bits follow the quadrant
+		const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+		const __m128 sineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, _mm_set1_epi32(2)), 30));
+		const __m128 cosineSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, _mm_set1_epi32(1)), _mm_set1_epi32(2)), 30));
+
+		sine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s)), sineSign);
+		cosine = _mm_xor_ps(_mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c)), cosineSign);
+	}
+
+	void VETransformBatch::ComputeSSE(float* matrices, float* normalMatrices) const
+	{
+		alignas(16) float lanes[LANE_VALUES * 4];
+
+		// The arrays are padded, so the last block can be read in full
+		for (uint32_t i = 0; i < m_Count; i += 4)
+		{
+			__m128 s1, c1, s2, c2, s3, c3;
+			SinCosSSE(_mm_loadu_ps(m_Rotation[1].data() + i), s1, c1);
+			SinCosSSE(_mm_loadu_ps(m_Rotation[0].data() + i), s2, c2);
+			SinCosSSE(_mm_loadu_ps(m_Rotation[2].data() + i), s3, c3);
+
+			const __m128 s1s2 = _mm_mul_ps(s1, s2);
+			const __m128 c1s2 = _mm_mul_ps(c1, s2);
+
+			const __m128 axes[9] = {
+				_mm_add_ps(_mm_mul_ps(c1, c3), _mm_mul_ps(s1s2, s3)),
+				_mm_mul_ps(c2, s3),
+				_mm_sub_ps(_mm_mul_ps(c1s2, s3), _mm_mul_ps(c3, s1)),
+				_mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c3, s1), s2), _mm_mul_ps(c1, s3)),
+				_mm_mul_ps(c2, c3),
+				_mm_add_ps(_mm_mul_ps(_mm_mul_ps(c1, c3), s2), _mm_mul_ps(s1, s3)),
+				_mm_mul_ps(c2, s1),
+				_mm_sub_ps(_mm_setzero_ps(), s2),
+				_mm_mul_ps(c1, c2),
+			};
+
+			for (int column = 0; column < 3; column++)
+			{
+				const __m128 scale = _mm_loadu_ps(m_Scale[column].data() + i);
+				const __m128 invScale = _mm_div_ps(_mm_set1_ps(1.0f), scale);
+
+				for (int row = 0; row < 3; row++)
+				{
+					_mm_store_ps(lanes + (column * 3 + row) * 4, _mm_mul_ps(scale, axes[column * 3 + row]));
+					_mm_store_ps(lanes + (9 + column * 3 + row) * 4, _mm_mul_ps(invScale, axes[column * 3 + row]));
+				}
+			}
+
+			StoreLanes<4>(lanes, i, m_Count, m_Translation, matrices, normalMatrices);
+		}
+	}
+
+	VE_TARGET_AVX2
+	static inline void SinCosAVX2(__m256 x, __m256& sine, __m256& cosine)
+	{
+		const __m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(TWO_OVER_PI)));
+		const __m256 q = _mm256_cvtepi32_ps(quadrant);
+
+		__m256 y = _mm256_fnmadd_ps(q, _mm256_set1_ps(HALF_PI_1), x);
+		y = _mm256_fnmadd_ps(q, _mm256_set1_ps(HALF_PI_2), y);
+		y = _mm256_fnmadd_ps(q, _mm256_set1_ps(HALF_PI_3), y);
+
+		const __m256 z = _mm256_mul_ps(y, y);
+
+		__m256 s = _mm256_fmadd_ps(_mm256_set1_ps(SIN_2), z, _mm256_set1_ps(SIN_1));
+		s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(SIN_0));
+		s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), y, y);
+
+		__m256 c = _mm256_fmadd_ps(_mm256_set1_ps(COS_2), z, _mm256_set1_ps(COS_1));
+		c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(COS_0));
+		c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+		c = _mm256_add_ps(_mm256_fnmadd_ps(_mm256_set1_ps(0.5f), z, c), _mm256_set1_ps(1.0f));
+
+		const __m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(1)));
+		const __m256 sineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, _mm256_set1_epi32(2)), 30));
+		const __m256 cosineSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, _mm256_set1_epi32(1)), _mm256_set1_epi32(2)), 30));
+
+		sine = _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sineSign);
+		cosine = _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosineSign);
+	}
+
+	VE_TARGET_AVX2
+	void VETransformBatch::ComputeAVX2(float* matrices, float* normalMatrices) const
+	{
+		alignas(32) float lanes[LANE_VALUES * 8];
+
+		for (uint32_t i = 0; i < m_Count; i += 8)
+		{
+			__m256 s1, c1, s2, c2, s3, c3;
+			SinCosAVX2(_mm256_loadu_ps(m_Rotation[1].data() + i), s1, c1);
+			SinCosAVX2(_mm256_loadu_ps(m_Rotation[0].data() + i), s2, c2);
+			SinCosAVX2(_mm256_loadu_ps(m_Rotation[2].data() + i), s3, c3);
+
+			const __m256 s1s2 = _mm256_mul_ps(s1, s2);
+			const __m256 c1s2 = _mm256_mul_ps(c1, s2);
+			const __m256 c1c3 = _mm256_mul_ps(c1, c3);
+			const __m256 c3s1 = _mm256_mul_ps(c3, s1);
+
+			const __m256 axes[9] = {
+				_mm256_fmadd_ps(s1s2, s3, c1c3),
+				_mm256_mul_ps(c2, s3),
+				_mm256_fmsub_ps(c1s2, s3, c3s1),
+				_mm256_fmsub_ps(c3s1, s2, _mm256_mul_ps(c1, s3)),
+				_mm256_mul_ps(c2, c3),
+				_mm256_fmadd_ps(c1c3, s2, _mm256_mul_ps(s1, s3)),
+				_mm256_mul_ps(c2, s1),
+				_mm256_sub_ps(_mm256_setzero_ps(), s2),
+				_mm256_mul_ps(c1, c2),
+			};
+
+			for (int column = 0; column < 3; column++)
+			{
+				const __m256 scale = _mm256_loadu_ps(m_Scale[column].data() + i);
+				const __m256 invScale = _mm256_div_ps(_mm256_set1_ps(1.0f), scale);
+
+				for (int row = 0; row < 3; row++)
+				{
+					_mm256_store_ps(lanes + (column * 3 + row) * 8, _mm256_mul_ps(scale, axes[column * 3 + row]));
+					_mm256_store_ps(lanes + (9 + column * 3 + row) * 8, _mm256_mul_ps(invScale, axes[column * 3 + row]));
+				}
+			}
+
+			StoreLanes<8>(lanes, i, m_Count, m_Translation, matrices, normalMatrices);
+		}
+	}
+#else
+	void VETransformBatch::ComputeSSE(float* matrices, float* normalMatrices) const
+	{
+		ComputeScalar(matrices, normalMatrices);
+	}
+
+	void VETransformBatch::ComputeAVX2(float* matrices, float* normalMatrices) const
+	{
+		ComputeScalar(matrices, normalMatrices);
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "VE_Culling.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Translation, rotation and scale of many transforms stored as separate arrays, so the matrices of 4 or 8
+	// transforms are built at once. Uses the same Y, X, Z Tait-Bryan convention as TransformComponent
+	class VETransformBatch
+	{
+	public:
+		static constexpr uint32_t PADDING = 8;
+
+		void Clear();
+		void Reserve(uint32_t count);
+
+		// Each argument points at 3 floats. Returns the index of the transform in the output arrays
+		uint32_t Add(const float* translation, const float* rotation, const float* scale);
+
+		uint32_t GetCount() const { return m_Count; }
+
+		// Writes a column major 4x4 model matrix (16 floats) and 3x3 normal matrix (9 floats) per transform.
+		// The scalar path matches TransformComponent::Mat4 and NormalMatrix bit for bit, the SIMD paths
+		// use a polynomial sincos that is accurate to a few ulp
+		void Compute(float* matrices, float* normalMatrices) const;
+		void Compute(float* matrices, float* normalMatrices, VECulling::Path path) const;
+
+	private:
+		void ComputeScalar(float* matrices, float* normalMatrices) const;
+		void ComputeSSE(float* matrices, float* normalMatrices) const;
+		void ComputeAVX2(float* matrices, float* normalMatrices) const;
+
+	private:
+		std::vector<float> m_Translation[3];
+		std::vector<float> m_Rotation[3];
+		std::vector<float> m_Scale[3];
+		uint32_t m_Count = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,437 @@
+#include "VE_UploadManager.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+
+namespace VulkanEngine {
+
+	// Staging offsets are kept aligned so copies start on a friendly boundary
+	static constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+
+	VEUploadManager::VEUploadManager(VEDevice& device, VkDeviceSize stagingSize)
+		: m_Device{ device }
+	{
+		m_StagingSize = std::max(stagingSize / STAGING_ALIGNMENT * STAGING_ALIGNMENT, STAGING_ALIGNMENT);
+
+		m_StagingBuffer = std::make_unique<VEBuffer>(
+			m_Device,
+			m_StagingSize,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+
+		m_StagingBuffer->Map();
+
+		QueueFamilyIndices queueFamilyIndices = m_Device.FindPhysicalQueueFamilies();
+
+		m_TransferFamily	= queueFamilyIndices.TransferFamily;
+		m_GraphicsFamily	= queueFamilyIndices.GraphicsFamily;
+
+		m_CommandPool = CreateCommandPool(m_TransferFamily);
+
+		if (m_TransferFamily != m_GraphicsFamily)
+		{
+			m_AcquireCommandPool = CreateCommandPool(m_GraphicsFamily);
+		}
+	}
+
+	VEUploadManager::~VEUploadManager()
+	{
+		// Every batch ends up back in the free list once the queue is idle
+		WaitIdle();
+
+		for (auto& batch : m_FreeBatches)
+		{
+			vkDestroyFence(m_Device.Device(), batch.Fence, nullptr);
+
+			if (batch.TransferComplete != VK_NULL_HANDLE)
+			{
+				vkDestroySemaphore(m_Device.Device(), batch.TransferComplete, nullptr);
+			}
+		}
+
+		// Destroying the pools frees every command buffer allocated from them
+		vkDestroyCommandPool(m_Device.Device(), m_CommandPool, nullptr);
+
+		if (m_AcquireCommandPool != VK_NULL_HANDLE)
+		{
+			vkDestroyCommandPool(m_Device.Device(), m_AcquireCommandPool, nullptr);
+		}
+	}
+
+	VkCommandPool VEUploadManager::CreateCommandPool(uint32_t queueFamily)
+	{
+		VkCommandPoolCreateInfo poolInfo = {};
+
+		poolInfo.sType				= VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex	= queueFamily;
+		poolInfo.flags				= VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VkCommandPool commandPool;
+
+		if (vkCreateCommandPool(m_Device.Device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to create upload command pool.");
+		}
+
+		return commandPool;
+	}
+
+	VEUploadManager::Ticket VEUploadManager::Upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset)
+	{
+		const char* bytes = static_cast<const char*>(data);
+
+		const VkDeviceSize rangeOffset = dstOffset;
+		const VkDeviceSize rangeSize = size;
+
+		// Anything larger than the ring is split up and streamed through it in pieces
+		while (size > 0)
+		{
+			const VkDeviceSize chunkSize = std::min(size, m_StagingSize);
+			const VkDeviceSize stagingOffset = AllocateStaging(chunkSize);
+
+			m_StagingBuffer->WriteToBuffer((void*)bytes, chunkSize, stagingOffset);
+
+			VkBufferCopy copyRegion = {};
+
+			copyRegion.srcOffset	= stagingOffset;
+			copyRegion.dstOffset	= dstOffset;
+			copyRegion.size			= chunkSize;
+
+			vkCmdCopyBuffer(m_CurrentBatch.CommandBuffer, m_StagingBuffer->GetBuffer(), dstBuffer, 1, &copyRegion);
+
+			bytes		+= chunkSize;
+			dstOffset	+= chunkSize;
+			size		-= chunkSize;
+		}
+
+		// Chunks can end up in different batches when the ring wraps, the range is released with the last one
+		if (rangeSize > 0 && m_AcquireCommandPool != VK_NULL_HANDLE)
+		{
+			VkBufferMemoryBarrier barrier = {};
+
+			barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			barrier.srcAccessMask		= VK_ACCESS_TRANSFER_WRITE_BIT;
+			barrier.dstAccessMask		= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+										  VK_ACCESS_INDEX_READ_BIT |
+										  VK_ACCESS_UNIFORM_READ_BIT |
+										  VK_ACCESS_SHADER_READ_BIT;
+			barrier.srcQueueFamilyIndex	= m_TransferFamily;
+			barrier.dstQueueFamilyIndex	= m_GraphicsFamily;
+			barrier.buffer				= dstBuffer;
+			barrier.offset				= rangeOffset;
+			barrier.size				= rangeSize;
+
+			m_OwnershipBarriers.push_back(barrier);
+		}
+
+		return m_IsRecording ? m_CurrentBatch.Id : m_CompletedTicket;
+	}
+
+	VEUploadManager::Ticket VEUploadManager::Flush()
+	{
+		if (!m_IsRecording)
+		{
+			return m_NextTicket - 1;
+		}
+
+		if (m_AcquireCommandPool != VK_NULL_HANDLE)
+		{
+			SubmitWithOwnershipTransfer();
+
+			m_InFlightBatches.push_back(m_CurrentBatch);
+			m_IsRecording = false;
+
+			return m_CurrentBatch.Id;
+		}
+
+		// Make the copied data visible to everything that reads vertex, index or shader data afterwards
+		VkMemoryBarrier barrier = {};
+
+		barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask	= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT |
+								  VK_ACCESS_INDEX_READ_BIT |
+								  VK_ACCESS_UNIFORM_READ_BIT |
+								  VK_ACCESS_SHADER_READ_BIT;
+
+		vkCmdPipelineBarrier(m_CurrentBatch.CommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0,
+			1, &barrier,
+			0, nullptr,
+			0, nullptr);
+
+		if (vkEndCommandBuffer(m_CurrentBatch.CommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload command buffer.");
+		}
+
+		VkSubmitInfo submitInfo = {};
+
+		submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount	= 1;
+		submitInfo.pCommandBuffers		= &m_CurrentBatch.CommandBuffer;
+
+		if (vkQueueSubmit(m_Device.TransferQueue(), 1, &submitInfo, m_CurrentBatch.Fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer.");
+		}
+
+		m_InFlightBatches.push_back(m_CurrentBatch);
+		m_IsRecording = false;
+
+		return m_CurrentBatch.Id;
+	}
+
+	void VEUploadManager::SubmitWithOwnershipTransfer()
+	{
+		const uint32_t barrierCount = static_cast<uint32_t>(m_OwnershipBarriers.size());
+
+		// Release the written ranges from the transfer family
+		vkCmdPipelineBarrier(m_CurrentBatch.CommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0,
+			0, nullptr,
+			barrierCount, m_OwnershipBarriers.data(),
+			0, nullptr);
+
+		if (vkEndCommandBuffer(m_CurrentBatch.CommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload command buffer.");
+		}
+
+		// Acquire them on the graphics family with a matching barrier
+		VkCommandBufferBeginInfo beginInfo = {};
+
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(m_CurrentBatch.AcquireCommandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording upload acquire command buffer.");
+		}
+
+		vkCmdPipelineBarrier(m_CurrentBatch.AcquireCommandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			0,
+			0, nullptr,
+			barrierCount, m_OwnershipBarriers.data(),
+			0, nullptr);
+
+		if (vkEndCommandBuffer(m_CurrentBatch.AcquireCommandBuffer) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to record upload acquire command buffer.");
+		}
+
+		m_OwnershipBarriers.clear();
+
+		VkSubmitInfo transferSubmit = {};
+
+		transferSubmit.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		transferSubmit.commandBufferCount	= 1;
+		transferSubmit.pCommandBuffers		= &m_CurrentBatch.CommandBuffer;
+		transferSubmit.signalSemaphoreCount	= 1;
+		transferSubmit.pSignalSemaphores	= &m_CurrentBatch.TransferComplete;
+
+		if (vkQueueSubmit(m_Device.TransferQueue(), 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload command buffer.");
+		}
+
+		// The fence sits on the acquire submission, so a completed ticket means the data is usable by graphics
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+
+		VkSubmitInfo acquireSubmit = {};
+
+		acquireSubmit.sType					= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		acquireSubmit.waitSemaphoreCount	= 1;
+		acquireSubmit.pWaitSemaphores		= &m_CurrentBatch.TransferComplete;
+		acquireSubmit.pWaitDstStageMask		= &waitStage;
+		acquireSubmit.commandBufferCount	= 1;
+		acquireSubmit.pCommandBuffers		= &m_CurrentBatch.AcquireCommandBuffer;
+
+		if (vkQueueSubmit(m_Device.GraphicsQueue(), 1, &acquireSubmit, m_CurrentBatch.Fence) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to submit upload acquire command buffer.");
+		}
+	}
+
+	bool VEUploadManager::IsComplete(Ticket ticket)
+	{
+		if (ticket <= m_CompletedTicket)
+		{
+			return true;
+		}
+
+		RetireCompletedBatches(false);
+
+		return ticket <= m_CompletedTicket;
+	}
+
+	void VEUploadManager::Wait(Ticket ticket)
+	{
+		if (m_IsRecording && ticket >= m_CurrentBatch.Id)
+		{
+			Flush();
+		}
+
+		while (ticket > m_CompletedTicket && !m_InFlightBatches.empty())
+		{
+			RetireCompletedBatches(true);
+		}
+	}
+
+	void VEUploadManager::WaitIdle()
+	{
+		Wait(m_NextTicket - 1);
+	}
+
+	VkDeviceSize VEUploadManager::AllocateStaging(VkDeviceSize size)
+	{
+		const VkDeviceSize alignedSize = (size + STAGING_ALIGNMENT - 1) / STAGING_ALIGNMENT * STAGING_ALIGNMENT;
+		assert(alignedSize <= m_StagingSize && "Staging allocation larger than the ring.");
+
+		for (;;)
+		{
+			// Space at the end of the ring that is too small is skipped over and released with this allocation
+			const VkDeviceSize wasted = m_StagingHead + alignedSize > m_StagingSize ? m_StagingSize - m_StagingHead : 0;
+
+			if (m_StagingUsed + wasted + alignedSize <= m_StagingSize)
+			{
+				const VkDeviceSize offset = wasted > 0 ? 0 : m_StagingHead;
+
+				m_StagingHead	= offset + alignedSize;
+				m_StagingUsed	+= wasted + alignedSize;
+
+				if (!m_IsRecording)
+				{
+					BeginBatch();
+				}
+
+				m_CurrentBatch.StagingBytes += wasted + alignedSize;
+
+				return offset;
+			}
+
+			// The ring is full, submit what has been recorded so far and wait for the oldest batch to free its space
+			Flush();
+			RetireCompletedBatches(true);
+		}
+	}
+
+	void VEUploadManager::BeginBatch()
+	{
+		assert(!m_IsRecording && "Upload batch is already being recorded.");
+
+		if (!m_FreeBatches.empty())
+		{
+			m_CurrentBatch = m_FreeBatches.back();
+			m_FreeBatches.pop_back();
+		}
+		else
+		{
+			m_CurrentBatch = {};
+
+			VkCommandBufferAllocateInfo allocInfo = {};
+
+			allocInfo.sType					= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level					= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool			= m_CommandPool;
+			allocInfo.commandBufferCount	= 1;
+
+			if (vkAllocateCommandBuffers(m_Device.Device(), &allocInfo, &m_CurrentBatch.CommandBuffer) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to allocate upload command buffer.");
+			}
+
+			VkFenceCreateInfo fenceInfo = {};
+
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			if (vkCreateFence(m_Device.Device(), &fenceInfo, nullptr, &m_CurrentBatch.Fence) != VK_SUCCESS)
+			{
+				throw std::runtime_error("Failed to create upload fence.");
+			}
+
+			if (m_AcquireCommandPool != VK_NULL_HANDLE)
+			{
+				allocInfo.commandPool = m_AcquireCommandPool;
+
+				if (vkAllocateCommandBuffers(m_Device.Device(), &allocInfo, &m_CurrentBatch.AcquireCommandBuffer) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to allocate upload acquire command buffer.");
+				}
+
+				VkSemaphoreCreateInfo semaphoreInfo = {};
+
+				semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+				if (vkCreateSemaphore(m_Device.Device(), &semaphoreInfo, nullptr, &m_CurrentBatch.TransferComplete) != VK_SUCCESS)
+				{
+					throw std::runtime_error("Failed to create upload semaphore.");
+				}
+			}
+		}
+
+		m_CurrentBatch.Id			= m_NextTicket++;
+		m_CurrentBatch.StagingBytes	= 0;
+
+		VkCommandBufferBeginInfo beginInfo = {};
+
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(m_CurrentBatch.CommandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			throw std::runtime_error("Failed to begin recording upload command buffer.");
+		}
+
+		m_IsRecording = true;
+	}
+
+	void VEUploadManager::RetireCompletedBatches(bool wait)
+	{
+		// Batches complete in the order they were submitted, the fence is always on the last queue a batch touches
+		while (!m_InFlightBatches.empty())
+		{
+			Batch batch = m_InFlightBatches.front();
+
+			if (wait)
+			{
+				vkWaitForFences(m_Device.Device(), 1, &batch.Fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+				wait = false;
+			}
+			else if (vkGetFenceStatus(m_Device.Device(), batch.Fence) != VK_SUCCESS)
+			{
+				break;
+			}
+
+			m_InFlightBatches.pop_front();
+
+			m_StagingUsed		-= batch.StagingBytes;
+			m_CompletedTicket	= batch.Id;
+
+			vkResetFences(m_Device.Device(), 1, &batch.Fence);
+			vkResetCommandBuffer(batch.CommandBuffer, 0);
+
+			if (batch.AcquireCommandBuffer != VK_NULL_HANDLE)
+			{
+				vkResetCommandBuffer(batch.AcquireCommandBuffer, 0);
+			}
+			m_FreeBatches.push_back(batch);
+		}
+
+		// Nothing is left in the ring, so the next allocation can start from the beginning again
+		if (m_StagingUsed == 0)
+		{
+			m_StagingHead = 0;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include "VE_Buffer.h"
+#include "VE_Device.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Streams data into device local buffers through a persistent staging ring. Copies are batched into a
+	// single command buffer per Flush and tracked with tickets instead of waiting for the queue to go idle.
+	// Copies run on the transfer queue, when that is a separate family the destination buffers are handed
+	// over to the graphics family by a small acquire command buffer that waits on the copies
+	class VEUploadManager
+	{
+	public:
+		using Ticket = uint64_t;
+
+		static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32ull * 1024 * 1024;
+
+		VEUploadManager(VEDevice& device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+		~VEUploadManager();
+
+		// Delete the copy constructor and copy operator
+		VEUploadManager(const VEUploadManager&) = delete;
+		VEUploadManager& operator=(const VEUploadManager&) = delete;
+
+		// Copies data into the staging ring straight away, so it can be released as soon as this returns.
+		// The returned ticket completes once the data has arrived in dstBuffer
+		Ticket Upload(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+		// Submits all queued copies. Returns the ticket of the submitted batch
+		Ticket Flush();
+
+		bool IsComplete(Ticket ticket);
+		void Wait(Ticket ticket);
+		void WaitIdle();
+
+	private:
+		struct Batch
+		{
+			VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+			VkCommandBuffer AcquireCommandBuffer = VK_NULL_HANDLE;	// Only used with a dedicated transfer family
+			VkSemaphore TransferComplete = VK_NULL_HANDLE;
+			VkFence Fence = VK_NULL_HANDLE;
+			Ticket Id = 0;
+			VkDeviceSize StagingBytes = 0;
+		};
+
+		VkCommandPool CreateCommandPool(uint32_t queueFamily);
+		void SubmitWithOwnershipTransfer();
+		VkDeviceSize AllocateStaging(VkDeviceSize size);
+		void BeginBatch();
+		void RetireCompletedBatches(bool wait);
+
+	private:
+		VEDevice& m_Device;
+		VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+		VkCommandPool m_AcquireCommandPool = VK_NULL_HANDLE;
+		uint32_t m_TransferFamily;
+		uint32_t m_GraphicsFamily;
+
+		std::unique_ptr<VEBuffer> m_StagingBuffer;
+		VkDeviceSize m_StagingSize;
+		VkDeviceSize m_StagingHead = 0;
+		VkDeviceSize m_StagingUsed = 0;
+
+		// Batch currently being recorded, only valid when m_IsRecording is set
+		Batch m_CurrentBatch = {};
+		bool m_IsRecording = false;
+
+		// Ranges written by the current batch that change queue family ownership when it is submitted
+		std::vector<VkBufferMemoryBarrier> m_OwnershipBarriers;
+
+		std::deque<Batch> m_InFlightBatches;
+		std::vector<Batch> m_FreeBatches;
+
+		Ticket m_NextTicket = 1;
+		Ticket m_CompletedTicket = 0;
+	};
+}
\ No newline at end of file
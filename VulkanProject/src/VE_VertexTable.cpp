@@ -0,0 +1,116 @@
+#include "VE_VertexTable.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace VulkanEngine {
+
+	// Power of two so the hash can be masked, at least twice the count so probe sequences stay short
+	static size_t GetCapacity(size_t count)
+	{
+		size_t capacity = 16;
+
+		while (capacity < count * 2)
+		{
+			capacity *= 2;
+		}
+
+		return capacity;
+	}
+
+	VEVertexTable::VEVertexTable(size_t vertexSize, size_t expectedCount)
+		: m_VertexSize{ vertexSize }, m_Slots(GetCapacity(expectedCount), EMPTY_SLOT)
+	{
+		assert(vertexSize > 0 && vertexSize % sizeof(uint32_t) == 0 && "Vertices are hashed a 32 bit word at a time.");
+	}
+
+	uint32_t VEVertexTable::Hash(const uint8_t* vertex) const
+	{
+		// MurmurHash2's mixing, one multiply per word is enough for float data and keeps the loop short
+		const uint32_t m = 0x5bd1e995;
+		uint32_t hash = 0;
+
+		for (size_t offset = 0; offset < m_VertexSize; offset += sizeof(uint32_t))
+		{
+			uint32_t word;
+			std::memcpy(&word, vertex + offset, sizeof(word));
+
+			word *= m;
+			word ^= word >> 24;
+			word *= m;
+
+			hash *= m;
+			hash ^= word;
+		}
+
+		hash ^= hash >> 13;
+		hash *= m;
+		hash ^= hash >> 15;
+
+		return hash;
+	}
+
+	uint32_t VEVertexTable::FindOrInsert(const void* vertices, uint32_t index)
+	{
+		assert(index != EMPTY_SLOT && "The largest index marks empty slots.");
+
+		const uint8_t* bytes = static_cast<const uint8_t*>(vertices);
+
+		if ((m_Count + 1) * 2 > m_Slots.size())
+		{
+			Grow(bytes);
+		}
+
+		const uint8_t* vertex = bytes + index * m_VertexSize;
+		const size_t mask = m_Slots.size() - 1;
+
+		// Triangular probing visits every slot of a power of two table
+		size_t slot = Hash(vertex) & mask;
+
+		for (size_t probe = 1; ; probe++)
+		{
+			const uint32_t found = m_Slots[slot];
+
+			if (found == EMPTY_SLOT)
+			{
+				m_Slots[slot] = index;
+				m_Count++;
+
+				return index;
+			}
+
+			if (std::memcmp(bytes + found * m_VertexSize, vertex, m_VertexSize) == 0)
+			{
+				return found;
+			}
+
+			slot = (slot + probe) & mask;
+		}
+	}
+
+	void VEVertexTable::Grow(const uint8_t* vertices)
+	{
+		std::vector<uint32_t> slots(m_Slots.size() * 2, EMPTY_SLOT);
+		const size_t mask = slots.size() - 1;
+
+		// Every stored vertex is unique, so rehashing only has to find an empty slot
+		for (uint32_t index : m_Slots)
+		{
+			if (index == EMPTY_SLOT)
+			{
+				continue;
+			}
+
+			size_t slot = Hash(vertices + index * m_VertexSize) & mask;
+
+			for (size_t probe = 1; slots[slot] != EMPTY_SLOT; probe++)
+			{
+				slot = (slot + probe) & mask;
+			}
+
+			slots[slot] = index;
+		}
+
+		m_Slots.swap(slots);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VulkanEngine {
+
+	// Open addressing hash set of vertex indices for welding identical vertices. Vertices are hashed and compared
+	// bit for bit over their raw bytes, so they must not have padding. The table only stores indices, the vertices
+	// stay in the caller's array
+	class VEVertexTable
+	{
+	public:
+		// vertexSize has to be a multiple of 4 bytes. expectedCount is the number of unique vertices the table
+		// is sized for up front, it grows past that when needed
+		VEVertexTable(size_t vertexSize, size_t expectedCount);
+
+		// vertices[index] is a vertex that has just been appended to vertices. Returns the index of an equal vertex
+		// found earlier, or inserts index and returns it when there is none. vertices may be reallocated between
+		// calls, the indices already inserted must keep referring to the same vertices
+		uint32_t FindOrInsert(const void* vertices, uint32_t index);
+
+		uint32_t GetCount() const { return m_Count; }
+
+	private:
+		uint32_t Hash(const uint8_t* vertex) const;
+
+		void Grow(const uint8_t* vertices);
+
+	private:
+		static constexpr uint32_t EMPTY_SLOT = ~0u;
+
+		size_t m_VertexSize;
+		std::vector<uint32_t> m_Slots;
+		uint32_t m_Count = 0;
+	};
+}
\ No newline at end of file
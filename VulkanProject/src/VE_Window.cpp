@@ -3,20 +3,31 @@
 #include <stdexcept>
 
 namespace VulkanEngine {
-	VEWindow::VEWindow(int width, int height, std::string title)
-		: m_Width(width), m_Height(height), m_Title(title)
+	VEWindow::VEWindow(int width, int height, std::string title, bool headless)
+		: m_Width(width), m_Height(height), m_Headless(headless), m_Title(title)
 	{
 		InitWindow();
 	}
 	
 	VEWindow::~VEWindow()
 	{
+		if (m_Headless)
+		{
+			return;
+		}
+
 		glfwDestroyWindow(m_Window);
 		glfwTerminate();
 	}
 
 	void VEWindow::InitWindow()
 	{
+		// No display is needed, so GLFW is never initialized
+		if (m_Headless)
+		{
+			return;
+		}
+
 		glfwInit();
 		// Disable OpenGL functionality since Vulkan is being used
 		glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
@@ -8,7 +8,8 @@ namespace VulkanEngine {
 
 	class VEWindow {
 	public:
-		VEWindow(int width, int height, std::string title);
+		// A headless window creates no GLFW window, the renderer then draws into offscreen images of this size
+		VEWindow(int width, int height, std::string title, bool headless = false);
 		~VEWindow();
 
 		// Delete the copy constructor and copy operator
@@ -18,7 +19,10 @@ namespace VulkanEngine {
 		VkExtent2D GetExtent() { return { m_Width, m_Height }; }
 		GLFWwindow* GetWindow() const { return m_Window; }
 
-		bool Close() { return glfwWindowShouldClose(m_Window); }
+		bool IsHeadless() const { return m_Headless; }
+
+		// A headless window is never closed by the user
+		bool Close() { return !m_Headless && glfwWindowShouldClose(m_Window); }
 		bool WasWindowResized() { return m_FramebufferResized; }
 		void ResetWindowResizeFlag() { m_FramebufferResized = false; }
 		
@@ -32,7 +36,8 @@ namespace VulkanEngine {
 		uint32_t m_Width;
 		uint32_t m_Height;
 		bool m_FramebufferResized = false;
-		GLFWwindow* m_Window;
+		bool m_Headless = false;
+		GLFWwindow* m_Window = nullptr;
 		std::string m_Title;
 
 	};
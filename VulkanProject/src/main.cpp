@@ -1,16 +1,117 @@
 #include "Application.h"
+#include "Tools/AllocatorTests.h"
+#include "Tools/Benchmarks.h"
+#include "Tools/MeshTools.h"
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main()
+int main(int argc, char** argv)
 {
-	VulkanEngine::Application App;
+	// Offline tools that don't need a window or device
+	if (argc > 1)
+	{
+		if (strcmp(argv[1], "--convert-mesh") == 0)
+		{
+			return VulkanEngine::RunMeshConverter(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--analyze-mesh") == 0)
+		{
+			return VulkanEngine::RunMeshOptimizerReport(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-mesh-load") == 0)
+		{
+			return VulkanEngine::RunMeshLoadBenchmark(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-mesh-import") == 0)
+		{
+			return VulkanEngine::RunMeshImportBenchmark(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--test-allocator") == 0)
+		{
+			return VulkanEngine::RunAllocatorTests(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-culling") == 0)
+		{
+			return VulkanEngine::RunCullingBenchmark(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-scene") == 0)
+		{
+			return VulkanEngine::RunSceneBenchmark(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-transforms") == 0)
+		{
+			return VulkanEngine::RunTransformBenchmark(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-depth-sort") == 0)
+		{
+			return VulkanEngine::RunDepthSortBenchmark(argc, argv);
+		}
+
+		if (strcmp(argv[1], "--bench-vertex-weld") == 0)
+		{
+			return VulkanEngine::RunVertexWeldBenchmark(argc, argv);
+		}
+	}
+
+	// Usage: --benchmark [frameCount] [objectCount] [lightCount] [meshPath] [outputPath] [--meshlet-culling]
+	// Renders a synthetic scene headless with a fixed timestep and reports frame timings as JSON
+	if (argc > 1 && strcmp(argv[1], "--benchmark") == 0)
+	{
+		const VulkanEngine::BenchmarkSettings settings = VulkanEngine::ParseBenchmarkSettings(argc, argv);
+
+		// A printed report has stdout to itself so it can be piped into a JSON parser, the engine's own
+		// output goes to stderr until the run is over
+		std::streambuf* stdoutBuffer = std::cout.rdbuf();
+
+		if (settings.OutputPath.empty())
+		{
+			std::cout.rdbuf(std::cerr.rdbuf());
+		}
+
+		std::string report;
+
+		try
+		{
+			VulkanEngine::Application App(settings);
+			App.Run();
+
+			report = App.GetBenchmarkReport();
+		}
+		catch (const std::exception &e)
+		{
+			std::cout.rdbuf(stdoutBuffer);
+			std::cerr << e.what() << "\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout.rdbuf(stdoutBuffer);
+		std::cout << report;
+
+		return EXIT_SUCCESS;
+	}
+
+	// Usage: --headless [frameCount], renders without a window, for machines without a display
+	const bool headless = argc > 1 && strcmp(argv[1], "--headless") == 0;
+	const uint32_t frameCount = headless ? static_cast<uint32_t>(argc > 2 ? std::max(1, std::atoi(argv[2])) : 300) : 0;
+
+	VulkanEngine::Application App(headless);
 
 	try
 	{
-		App.Run();
+		App.Run(frameCount);
 	}
 	catch (const std::exception &e)
 	{